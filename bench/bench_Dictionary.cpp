@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "ForthDictionary.h"
+#include "SymbolTable.h"
+
+// Dictionary lookup benchmarks.
+// A vocabulary of BENCH_WORDS words is created once; each iteration looks up one name.
+
+static constexpr size_t BENCH_WORDS = 4096;
+
+static std::vector<std::string> &benchNames() {
+    static std::vector<std::string> names;
+    if (names.empty()) {
+        auto &dict = ForthDictionary::instance();
+        if (!dict.findVocab("FORTH")) {
+            dict.createVocabulary("FORTH");
+        }
+        dict.createVocabulary("BENCHVOC");
+        dict.setSearchOrder({"FORTH", "BENCHVOC"});
+        for (size_t i = 0; i < BENCH_WORDS; ++i) {
+            names.push_back("BW" + std::to_string(i * 7919));
+            dict.addWord(names.back().c_str(), ForthState::EXECUTABLE, ForthWordType::WORD, "BENCHVOC");
+        }
+    }
+    return names;
+}
+
+// Case folding entry point, as used by the interpreter for untokenized names
+static void BM_FindWord_CString(benchmark::State &state) {
+    const auto &names = benchNames();
+    const auto &dict = ForthDictionary::instance();
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(dict.findWord(names[i].c_str()));
+        i = (i + 1) % names.size();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_FindWord_CString);
+
+// Already folded name, no allocation
+static void BM_FindWord_StringView(benchmark::State &state) {
+    const auto &names = benchNames();
+    const auto &dict = ForthDictionary::instance();
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(dict.findWord(std::string_view(names[i])));
+        i = (i + 1) % names.size();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_FindWord_StringView);
+
+// Pre-resolved word id from the tokenizer
+static void BM_FindWordByToken(benchmark::State &state) {
+    const auto &names = benchNames();
+    const auto &dict = ForthDictionary::instance();
+    std::vector<ForthToken> tokens;
+    for (const auto &name: names) {
+        ForthToken token;
+        token.type = TOKEN_WORD;
+        token.value = name;
+        token.word_id = SymbolTable::instance().findSymbol(name);
+        token.word_len = static_cast<uint32_t>(name.size());
+        tokens.push_back(token);
+    }
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(dict.findWordByToken(tokens[i]));
+        i = (i + 1) % tokens.size();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_FindWordByToken);
+
+// Unknown names must not grow the symbol table
+static void BM_FindWord_Miss(benchmark::State &state) {
+    benchNames();
+    const auto &dict = ForthDictionary::instance();
+    const char *misses[] = {"NOSUCHWORD", "MISSING1", "MISSING2", "XYZZY"};
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(dict.findWord(misses[i]));
+        i = (i + 1) & 3;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_FindWord_Miss);
@@ -0,0 +1,189 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CodeGenerator.h"
+#include "ForthDictionary.h"
+#include "Interpreter.h"
+
+// Classic Forth kernels run from their compiled words: the BYTE sieve, recursive fib,
+// bubble sort, integer matrix multiply, and a LET function called per point.
+// The arrays are C++ vectors, passed to the words in variables. Each benchmark checks
+// its result once, so a code generation bug shows as an error, not as a fast time.
+
+static const char *kernelDefinitions[] = {
+    "VARIABLE BK-FLAGS",
+    "VARIABLE BK-SIZE",
+    ": BK-SIEVE ( -- primes ) "
+    "  BK-FLAGS @ BK-SIZE @ 1 FILL "
+    "  0 BK-SIZE @ 0 DO "
+    "    BK-FLAGS @ I + C@ IF "
+    "      I DUP + 3 + DUP I + "
+    "      BEGIN DUP BK-SIZE @ < WHILE 0 OVER BK-FLAGS @ + C! OVER + REPEAT "
+    "      2DROP 1 + "
+    "    THEN "
+    "  LOOP ;",
+
+    ": BK-FIB ( n -- fib ) DUP 2 < 0= IF DUP 1 - RECURSE SWAP 2 - RECURSE + THEN ;",
+
+    ": BK-BUBBLE ( addr n -- ) "
+    "  SWAP OVER 1 - 0 DO "
+    "    OVER I - 1 - 8 * OVER + OVER DO "
+    "      I @ I 8 + @ 2DUP > IF I ! I 8 + ! ELSE 2DROP THEN "
+    "    8 +LOOP "
+    "  LOOP 2DROP ;",
+
+    "VARIABLE BK-A",
+    "VARIABLE BK-B",
+    "VARIABLE BK-C",
+    "VARIABLE BK-N",
+    ": BK-MATMUL ( -- ) "
+    "  BK-N @ 0 DO "
+    "    BK-N @ 0 DO "
+    "      0 BK-N @ 0 DO "
+    "        BK-A @ K BK-N @ * I + 8 * + @ "
+    "        BK-B @ I BK-N @ * J + 8 * + @ "
+    "        * + "
+    "      LOOP "
+    "      BK-C @ J BK-N @ * I + 8 * + ! "
+    "    LOOP "
+    "  LOOP ;",
+
+    ": BK-NORMALIZE LET (nx, ny, nz, len) = FN(x, y, z) = x / r, y / r, z / r, r "
+    "  WHERE r = sqrt(x * x + y * y + z * z) ;",
+};
+
+static ForthFunction kernelWord(const char *name) {
+    static bool initialized = false;
+    if (!initialized) {
+        code_generator_initialize();
+        for (const char *definition: kernelDefinitions) {
+            Interpreter::instance().execute(definition);
+        }
+        initialized = true;
+    }
+    return ForthDictionary::instance().findWord(name)->executable;
+}
+
+static void setVariable(const char *name, const int64_t value) {
+    Interpreter::instance().execute(name);
+    *reinterpret_cast<int64_t *>(cpop()) = value;
+}
+
+static void BM_Sieve(benchmark::State &state) {
+    const ForthFunction sieve = kernelWord("BK-SIEVE");
+    std::vector<uint8_t> flags(8190);
+    setVariable("BK-FLAGS", reinterpret_cast<int64_t>(flags.data()));
+    setVariable("BK-SIZE", static_cast<int64_t>(flags.size()));
+    int64_t primes = 0;
+    for (auto _: state) {
+        sieve();
+        primes = cpop();
+    }
+    if (primes != 1899) state.SkipWithError("BK-SIEVE found the wrong number of primes");
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Sieve);
+
+// calls and returns, fib(n) makes 2 fib(n+1) - 1 calls
+static void BM_Fib(benchmark::State &state) {
+    const ForthFunction fib = kernelWord("BK-FIB");
+    const int64_t n = state.range(0);
+    int64_t result = 0;
+    for (auto _: state) {
+        cpush(n);
+        fib();
+        result = cpop();
+    }
+    int64_t a = 0, b = 1;
+    for (int64_t i = 0; i < n; i++) {
+        b += a;
+        a = b - a;
+    }
+    if (result != a) state.SkipWithError("BK-FIB computed the wrong number");
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * (2 * b - 1));
+}
+BENCHMARK(BM_Fib)->Arg(16)->Arg(24);
+
+// n^2 / 2 compares of memory cells, on reversed data so every compare swaps
+static void BM_BubbleSort(benchmark::State &state) {
+    const ForthFunction bubble = kernelWord("BK-BUBBLE");
+    const auto n = static_cast<size_t>(state.range(0));
+    std::vector<int64_t> cells(n);
+    for (auto _: state) {
+        for (size_t i = 0; i < n; i++) cells[i] = static_cast<int64_t>(n - i);
+        cpush(reinterpret_cast<int64_t>(cells.data()));
+        cpush(static_cast<int64_t>(n));
+        bubble();
+    }
+    if (!std::is_sorted(cells.begin(), cells.end())) state.SkipWithError("BK-BUBBLE left the cells unsorted");
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n * (n - 1) / 2));
+}
+BENCHMARK(BM_BubbleSort)->Arg(100)->Arg(1000);
+
+// n^3 multiply-adds, nested DO loops with I J K
+static void BM_MatrixMultiply(benchmark::State &state) {
+    const ForthFunction matmul = kernelWord("BK-MATMUL");
+    const auto n = static_cast<size_t>(state.range(0));
+    std::vector<int64_t> a(n * n), b(n * n), c(n * n);
+    for (size_t i = 0; i < n * n; i++) {
+        a[i] = static_cast<int64_t>(i % 7) - 3;
+        b[i] = static_cast<int64_t>(i % 5) - 2;
+    }
+    setVariable("BK-A", reinterpret_cast<int64_t>(a.data()));
+    setVariable("BK-B", reinterpret_cast<int64_t>(b.data()));
+    setVariable("BK-C", reinterpret_cast<int64_t>(c.data()));
+    setVariable("BK-N", static_cast<int64_t>(n));
+    for (auto _: state) {
+        matmul();
+    }
+    for (size_t row = 0; row < n; row++) {
+        for (size_t col = 0; col < n; col++) {
+            int64_t sum = 0;
+            for (size_t k = 0; k < n; k++) sum += a[row * n + k] * b[k * n + col];
+            if (c[row * n + col] != sum) {
+                state.SkipWithError("BK-MATMUL computed the wrong product");
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n * n * n));
+}
+BENCHMARK(BM_MatrixMultiply)->Arg(16)->Arg(64);
+
+// A LET with a square root and three divides, per point
+static void BM_LetNormalize(benchmark::State &state) {
+    const ForthFunction normalize = kernelWord("BK-NORMALIZE");
+    constexpr int points = 1024;
+    std::vector<double> xyz(3 * points);
+    for (int i = 0; i < 3 * points; i++) xyz[i] = 0.5 + (i % 11) * 0.25;
+    double sum = 0.0;
+    for (auto _: state) {
+        for (int i = 0; i < points; i++) {
+            cfpush(xyz[3 * i]);
+            cfpush(xyz[3 * i + 1]);
+            cfpush(xyz[3 * i + 2]);
+            normalize();
+            sum += cfpop();
+            sum += cfpop();
+            sum += cfpop();
+            sum += cfpop();
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    // the unit vector and its length, in whatever order they are returned
+    cfpush(3.0);
+    cfpush(0.0);
+    cfpush(4.0);
+    normalize();
+    std::vector<double> results = {cfpop(), cfpop(), cfpop(), cfpop()};
+    std::sort(results.begin(), results.end());
+    if (std::fabs(results[1] - 0.6) > 1e-12 || std::fabs(results[2] - 0.8) > 1e-12 ||
+        std::fabs(results[3] - 5.0) > 1e-12) {
+        state.SkipWithError("BK-NORMALIZE computed the wrong vector");
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * points);
+}
+BENCHMARK(BM_LetNormalize);
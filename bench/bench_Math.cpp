@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "CodeGenerator.h"
+#include "ForthDictionary.h"
+#include "Interpreter.h"
+#include "LetMapGenerator.h"
+#include "Settings.h"
+
+// Transcendental functions called in libm (SET MATH LIBM) against the inlined
+// MathKernels polynomials (SET MATH PRECISE and FAST), in a LET expression where
+// each call spills the live XMM registers, and in a plain Forth word.
+
+static const char *benchExpression =
+    "sin(x) * cos(x) + exp(x * 0.5) - log(x + 2) + tanh(x) + pow(x, 1.5)";
+
+// The word compiled under the given SET MATH, the setting goes back to LIBM
+static ForthFunction mathWord(const std::string &name, const char *accuracy, const std::string &definition) {
+    static bool initialized = false;
+    if (!initialized) {
+        code_generator_initialize();
+        initialized = true;
+    }
+    auto &dict = ForthDictionary::instance();
+    if (!dict.findWord(name.c_str())) {
+        Interpreter::instance().execute(std::string("SET MATH ") + accuracy);
+        Interpreter::instance().execute(": " + name + " " + definition + " ;");
+        Interpreter::instance().execute("SET MATH LIBM");
+    }
+    return dict.findWord(name.c_str())->executable;
+}
+
+static void BM_LetMath(benchmark::State &state, const char *accuracy) {
+    const ForthFunction word = mathWord(std::string("BMLET") + accuracy, accuracy,
+                                        std::string("LET (r) = FN(x) = ") + benchExpression);
+    double x = 0.25;
+    double sum = 0.0;
+    for (auto _: state) {
+        cfpush(x);
+        word();
+        sum += cfpop();
+        x = x < 4.0 ? x + 0.001 : 0.25;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_CAPTURE(BM_LetMath, libm, "LIBM");
+BENCHMARK_CAPTURE(BM_LetMath, precise, "PRECISE");
+BENCHMARK_CAPTURE(BM_LetMath, fast, "FAST");
+
+// x sin x fexp f* x fln f+
+static void BM_ForthMath(benchmark::State &state, const char *accuracy) {
+    const ForthFunction word = mathWord(std::string("BMFORTH") + accuracy, accuracy,
+                                        "fdup sin fover fexp f* fswap fln f+");
+    double x = 0.25;
+    double sum = 0.0;
+    for (auto _: state) {
+        cfpush(x);
+        word();
+        sum += cfpop();
+        x = x < 4.0 ? x + 0.001 : 0.25;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_CAPTURE(BM_ForthMath, libm, "LIBM");
+BENCHMARK_CAPTURE(BM_ForthMath, precise, "PRECISE");
+BENCHMARK_CAPTURE(BM_ForthMath, fast, "FAST");
+
+// One formula over arrays: the scalar LET called per element, against LET-MAP at each width
+static const char *mapExpression = "a * x * x + sqrt(fabs(y)) - fmin(x, y) WHERE a = 0.5";
+static constexpr int mapElements = 4096;
+
+static void BM_LetPerElement(benchmark::State &state) {
+    const ForthFunction word = mathWord("BMLETELEM", "LIBM", std::string("LET (r) = FN(x, y) = ") + mapExpression);
+    std::vector<double> x(mapElements, 1.25), y(mapElements, -3.5), r(mapElements);
+    for (auto _: state) {
+        for (int i = 0; i < mapElements; i++) {
+            cfpush(x[i]);
+            cfpush(y[i]);
+            word();
+            r[i] = cfpop();
+        }
+    }
+    benchmark::DoNotOptimize(r.data());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mapElements);
+}
+BENCHMARK(BM_LetPerElement);
+
+static void BM_LetMap(benchmark::State &state, const LetMapGenerator::Isa isa, const char *name) {
+    LetMapGenerator::instance().limit_isa(isa);
+    const ForthFunction word = mathWord(name, "LIBM", std::string("LET-MAP (r) = FN(x, y) = ") + mapExpression);
+    LetMapGenerator::instance().limit_isa(LetMapGenerator::Isa::AVX512);
+    std::vector<double> x(mapElements, 1.25), y(mapElements, -3.5), r(mapElements);
+    for (auto _: state) {
+        cpush(reinterpret_cast<int64_t>(x.data()));
+        cpush(reinterpret_cast<int64_t>(y.data()));
+        cpush(reinterpret_cast<int64_t>(r.data()));
+        cpush(mapElements);
+        word();
+    }
+    benchmark::DoNotOptimize(r.data());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mapElements);
+}
+BENCHMARK_CAPTURE(BM_LetMap, sse2, LetMapGenerator::Isa::SSE2, "BMMAPSSE2");
+BENCHMARK_CAPTURE(BM_LetMap, avx2, LetMapGenerator::Isa::AVX2, "BMMAPAVX2");
+BENCHMARK_CAPTURE(BM_LetMap, avx512, LetMapGenerator::Isa::AVX512, "BMMAPAVX512");
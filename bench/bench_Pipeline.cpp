@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CodeGenerator.h"
+#include "Compiler.h"
+#include "ForthDictionary.h"
+#include "Optimizer.h"
+#include "Settings.h"
+#include "StringsStorage.h"
+#include "Tokenizer.h"
+#include "WordHeap.h"
+
+// The compile pipeline stage by stage: optimizer, code generation of colon definitions
+// and LET statements, and the string and word data allocators they use.
+
+static const char *pipelineDefinition =
+    ": BENCHP DUP + 4 * 8 / SWAP DROP 3 < IF 2 - THEN OVER DROP DUP ROT 10 > "
+    "0 10 0 DO I + LOOP BEGIN 1 - DUP 0 = UNTIL DROP ;";
+
+static std::deque<ForthToken> pipelineTokens() {
+    static bool initialized = false;
+    if (!initialized) {
+        code_generator_initialize();
+        initialized = true;
+    }
+    std::deque<ForthToken> tokens;
+    Tokenizer::instance().tokenize_forth(pipelineDefinition, tokens);
+    return tokens;
+}
+
+// Tokens already made, the optimizer alone
+static void BM_Optimize(benchmark::State &state) {
+    const auto tokens = pipelineTokens();
+    std::deque<ForthToken> optimized;
+    for (auto _: state) {
+        Optimizer::instance().optimize(tokens, optimized);
+        benchmark::DoNotOptimize(optimized.back());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tokens.size()));
+}
+BENCHMARK(BM_Optimize);
+
+// Definitions compiled per second, with the optimizer off (0) and on (1)
+// compile_words consumes its tokens, so each iteration copies them; the word is forgotten again
+static void BM_CompileWords(benchmark::State &state) {
+    const auto tokens = pipelineTokens();
+    const bool before = optimizer;
+    optimizer = state.range(0) != 0;
+    for (auto _: state) {
+        std::deque<ForthToken> input = tokens;
+        Compiler::instance().compile_words(input);
+        ForthDictionary::instance().forgetLastWord();
+    }
+    optimizer = before;
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_CompileWords)->Arg(0)->Arg(1);
+
+// LET statements compiled per second, parsing and register allocation included
+static void BM_CompileLet(benchmark::State &state) {
+    pipelineTokens();
+    const std::string statement =
+        ": BENCHL LET (nx, ny, len) = FN(x, y) = x / r, y / r, r "
+        "WHERE r = sqrt(x * x + y * y + e) WHERE e = 0.000001 ;";
+    for (auto _: state) {
+        Compiler::instance().compile_let(statement);
+        ForthDictionary::instance().forgetLastWord();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_CompileLet);
+
+static std::vector<std::string> internStrings(const size_t count) {
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < count; i++) {
+        strings.push_back("string literal " + std::to_string(i * 7919));
+    }
+    return strings;
+}
+
+// A literal seen before, as when the same S" string is compiled again
+static void BM_InternHit(benchmark::State &state) {
+    const auto strings = internStrings(1024);
+    auto &storage = StringStorage::instance();
+    for (const auto &s: strings) storage.intern(s);
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(storage.intern(strings[i]));
+        i = (i + 1) & 1023;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_InternHit);
+
+// New literals, copied into the arena; the storage is cleared between batches, untimed
+static void BM_InternNew(benchmark::State &state) {
+    const auto strings = internStrings(1024);
+    auto &storage = StringStorage::instance();
+    for (auto _: state) {
+        for (const auto &s: strings) {
+            benchmark::DoNotOptimize(storage.intern(s));
+        }
+        state.PauseTiming();
+        storage.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * strings.size()));
+}
+BENCHMARK(BM_InternNew);
+
+// Data for new words, as ALLOT and VARIABLE make; freed between batches, untimed
+static constexpr uint64_t BENCH_WORD_IDS = 0xBE4C000000000000ULL; // not ids of real words
+
+static void BM_WordHeapAllocate(benchmark::State &state) {
+    constexpr uint64_t batch = 1024;
+    const auto size = static_cast<size_t>(state.range(0));
+    auto &heap = WordHeap::instance();
+    std::vector<void *> blocks(batch);
+    for (auto _: state) {
+        for (uint64_t id = 0; id < batch; id++) {
+            blocks[id] = heap.allocate(BENCH_WORD_IDS + id, size);
+        }
+        benchmark::DoNotOptimize(blocks.data());
+        state.PauseTiming();
+        // deallocate reports each word
+        std::streambuf *out = std::cout.rdbuf(nullptr);
+        for (uint64_t id = 0; id < batch; id++) {
+            heap.deallocate(BENCH_WORD_IDS + id);
+        }
+        std::cout.rdbuf(out);
+        std::cout.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+}
+BENCHMARK(BM_WordHeapAllocate)->Arg(8)->Arg(256)->Arg(4096);
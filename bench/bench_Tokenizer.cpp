@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CodeGenerator.h"
+#include "Compiler.h"
+#include "ForthDictionary.h"
+#include "Optimizer.h"
+#include "Tokenizer.h"
+
+// Tokenizer and optimizer throughput over a typical block of source.
+
+static const std::string &benchSource() {
+    static const std::string source =
+        ": BENCHT R> 1 + >R BEGIN DUP BASE @ MOD R@ C! R> 1 + >R BASE @ / DUP 0 = UNTIL DROP ; "
+        ": BENCHA >R 0 BEGIN KEY DUP 10 = IF DROP R> DROP EXIT THEN DUP EMIT OVER C! 1 + SWAP 1 + SWAP R@ OVER > UNTIL DROP R> DROP ; "
+        ": BENCHS ( n -- n ) DUP + 4 * 8 / SWAP DROP 3 < IF 2 - THEN OVER DROP DUP ROT 10 > ; "
+        "10 20 + 30 * .\" done\" CR";
+    return source;
+}
+
+// Lines of docs/forth.f, repeated so a run tokenizes n copies of the file
+static std::vector<std::string> forthFileLines(const int64_t copies) {
+    std::ifstream file(std::string(FORTHJIT_SOURCE_DIR) + "/docs/forth.f");
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    std::vector<std::string> result;
+    for (int64_t i = 0; i < copies; i++) {
+        result.insert(result.end(), lines.begin(), lines.end());
+    }
+    return result;
+}
+
+static void benchInitialize() {
+    static bool initialized = false;
+    if (!initialized) {
+        code_generator_initialize();
+        initialized = true;
+    }
+}
+
+static void BM_Tokenize(benchmark::State &state) {
+    benchInitialize();
+    const std::string &source = benchSource();
+    std::deque<ForthToken> tokens;
+    size_t count = 0;
+    for (auto _: state) {
+        count += Tokenizer::instance().tokenize_forth(source, tokens);
+        benchmark::DoNotOptimize(tokens.back());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(count));
+}
+BENCHMARK(BM_Tokenize);
+
+// Whole source files, line by line as include_file does
+static void BM_TokenizeForthFile(benchmark::State &state) {
+    benchInitialize();
+    const auto lines = forthFileLines(state.range(0));
+    if (lines.empty()) {
+        state.SkipWithError("docs/forth.f not found");
+        return;
+    }
+    std::deque<ForthToken> tokens;
+    size_t count = 0;
+    size_t bytes = 0;
+    for (auto _: state) {
+        for (const auto &line: lines) {
+            count += Tokenizer::instance().tokenize_forth(line, tokens);
+            bytes += line.size();
+        }
+        benchmark::DoNotOptimize(tokens.back());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(count));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_TokenizeForthFile)->Arg(1)->Arg(16)->Arg(256);
+
+static void BM_TokenizeOptimize(benchmark::State &state) {
+    benchInitialize();
+    const std::string &source = benchSource();
+    std::deque<ForthToken> tokens;
+    std::deque<ForthToken> optimized;
+    size_t count = 0;
+    for (auto _: state) {
+        count += Tokenizer::instance().tokenize_forth(source, tokens);
+        Optimizer::instance().optimize(tokens, optimized);
+        benchmark::DoNotOptimize(optimized.back());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(count));
+}
+BENCHMARK(BM_TokenizeOptimize);
+
+// Full definition pipeline, the word is forgotten again after each compile
+static void BM_TokenizeOptimizeCompile(benchmark::State &state) {
+    benchInitialize();
+    const std::string source =
+        ": BENCHC DUP + 4 * 8 / SWAP DROP 3 < IF 2 - THEN OVER DROP DUP ROT 10 > ;";
+    std::deque<ForthToken> tokens;
+    size_t count = 0;
+    for (auto _: state) {
+        count += Tokenizer::instance().tokenize_forth(source, tokens);
+        Compiler::instance().compile_words(tokens);
+        ForthDictionary::instance().forgetLastWord();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(count));
+}
+BENCHMARK(BM_TokenizeOptimizeCompile);
@@ -0,0 +1,60 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include "ForthDictionaryEntry.h"
+#include "PerfCounters.h"
+#include "Singleton.h"
+
+// Statistical timing of a Forth word (BENCH word n).
+// The word is called in batches; a batch is sized so it takes about a millisecond, long enough
+// for the clock, and each of the n samples is the time of one batch divided by its iterations.
+// The batches are run from a small assembler loop, not from C++, so the cost of a call is
+// the same for every word and the C++ registers are not disturbed between calls.
+class Benchmark : public Singleton<Benchmark> {
+    friend class Singleton<Benchmark>;
+
+public:
+    static constexpr size_t DEFAULT_SAMPLES = 100;
+    static constexpr uint64_t BATCH_NS = 1000000; // calibrated batch length
+    static constexpr uint64_t WARMUP_NS = 20000000; // words are run this long before the samples
+
+    // nanoseconds per iteration, except where noted
+    struct Result {
+        size_t samples = 0;
+        uint64_t iterations = 0; // per sample
+        double min = 0;
+        double median = 0;
+        double p99 = 0;
+        double mean = 0;
+        double stddev = 0;
+        double ticks = 0; // time stamp counter ticks per iteration, median
+        uint64_t totalNs = 0; // all the samples
+        PerfCounters::Counts counts; // all the samples, when counted
+    };
+
+    // CLOCK_MONOTONIC_RAW, not slewed by NTP
+    static uint64_t nanoseconds();
+
+    // the time stamp counter, read with rdtscp so earlier instructions have finished
+    static uint64_t ticks();
+
+    // Calls the word count times, each call sees the data stack the previous one left
+    static void call(ForthFunction word, uint64_t count);
+
+    // Warms up, calibrates and samples a balanced word, with the hardware counters around the samples
+    Result run(ForthFunction word, size_t samples = DEFAULT_SAMPLES, bool count = false);
+
+    // Prints the statistics line of a result
+    static void display(const Result &result);
+
+    [[nodiscard]] const Result &last() const { return lastResult; }
+
+private:
+    Benchmark() = default;
+
+    Result lastResult;
+};
+
+#endif // BENCHMARK_H
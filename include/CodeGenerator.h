@@ -16,20 +16,54 @@ bool initialize_assembler(asmjit::x86::Assembler *&assembler);
 
 void code_generator_initialize();
 
-ForthFunction code_generator_build_forth(ForthFunction fn);
+ForthFunction code_generator_build_forth(ForthFunction fn, const std::string &name);
+
+// batch the words built by code_generator_build_forth into one JIT allocation
+void code_generator_begin_batch();
+
+void code_generator_commit_batch();
 
 void code_generator_startFunction(const std::string &name);
 
+asmjit::Label code_generator_enterFunction(const std::string &name);
+
 void compile_return();
 
+// the next DO keeps its index and limit in registers, the compiler checked its body
+void code_generator_plan_do_loop(bool registers);
+
+// the next CASE has only literal OF keys, in OF order; they are dispatched at CASE
+void code_generator_plan_case(const std::vector<int64_t> &keys);
+
+// comparison followed by IF, WHILE or UNTIL, compiles the comparison to set the flags only
+bool code_generator_compare_and_branch(const ForthToken &compare, const ForthToken &branch);
+
 ForthFunction code_generator_finalizeFunction(const std::string &name);
 
 void code_generator_reset();
 
+// performs the rollback requested by a MARKER word, after it returned
+void code_generator_run_pending_marker();
+
+// SET TIERING ON, the word being compiled counts its calls and loop iterations in profile
+void code_generator_count_calls(TierProfile *profile);
+
+// recompiles the words that became hot, after the word that ran them returned
+void code_generator_run_pending_tier_ups();
+
 void compile_pushLiteral(const int64_t literal);
 
 void compile_pushLiteralFloat(const double literal);
 
+// SET FSTACK SEPARATE, writes the floats cached in XMM registers back to the float stack
+void code_generator_flush_floats();
+
+// a float literal or float word, compiled against the cached floats
+bool code_generator_float_token(const ForthToken &token);
+
+// rebuilds the float words the interpreter runs, for the float stack just selected
+void code_generator_rebuild_float_words();
+
 void compile_pushVariableAddress(const int64_t literal, const std::string &name);
 
 void compile_pushConstantValue(const int64_t literal, const std::string &name);
@@ -38,6 +72,16 @@ void compile_call_C(void (*func)());
 
 void compile_call_forth(void (*func)(), const std::string &forth_word);
 
+// jump instead of call when nothing follows but the return, false inside a DO loop
+bool compile_tail_call_forth(void (*func)(), const std::string &forth_word);
+
+// call and tail call through the entry's executable, for words a recompile may swap
+void compile_call_forth_entry(const ForthDictionaryEntry *entry, const std::string &forth_word);
+
+bool compile_tail_call_forth_entry(const ForthDictionaryEntry *entry, const std::string &forth_word);
+
+bool compile_tail_recurse();
+
 void compile_call_C_char(void (*func)(char*));
 
 void stack_self();
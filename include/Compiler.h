@@ -2,9 +2,11 @@
 #define COMPILER_H
 
 #include <deque>
+#include <memory>
 #include <string>
 #include "Singleton.h"
 #include "Tokenizer.h"
+#include "ForthDictionaryEntry.h"
 
 class Compiler : public Singleton<Compiler> {
     // The Singleton template will manage instance creation
@@ -16,6 +18,9 @@ public:
     // Main compile entry point
     void compile_words(std::deque<ForthToken> &input_tokens);
 
+    // SET TIERING ON, compiles a hot word again optimized and swaps its executable
+    void recompile(TierProfile &profile);
+
 private:
     // Constructor and destructor are private to enforce Singleton behavior
     Compiler() = default;
@@ -24,6 +29,15 @@ private:
     // Utility and helper methods
     void validate_compiler_state(std::deque<ForthToken> &tokens);
     std::string extract_word_name(std::deque<ForthToken> &tokens);
+    ForthFunction compile_definition(std::deque<ForthToken> &input_tokens, std::string &word_name,
+                                     TierProfile *profile);
+
+    // Inlining of small definitions
+    void expand_inline_calls(std::deque<ForthToken> &tokens);
+    std::unique_ptr<InlineBody> capture_inline_body(const std::deque<ForthToken> &tokens);
+
+    // Tiered recompilation
+    std::unique_ptr<TierProfile> capture_tier_profile(const std::deque<ForthToken> &tokens);
 
     // Token processing
     void process_token(const ForthToken &token, std::deque<ForthToken> &tokens, std::string &word_name);
@@ -31,6 +45,7 @@ private:
     void compile_token_float(const ForthToken &token);
     void compile_token_word(const ForthToken &token, std::deque<ForthToken> &tokens, std::string &word_name);
     void compile_token_optimized(const ForthToken &token, std::deque<ForthToken> &tokens);
+    void compile_token_call(const ForthToken &token, std::deque<ForthToken> &tokens, std::string &word_name);
 };
 
 #endif // COMPILER_H
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef DICTIONARY_INDEX_H
+#define DICTIONARY_INDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct ForthDictionaryEntry;
+
+// Open addressing hash index over dictionary entries.
+// Keyed by the 64 bit entry id (word_id | vocab_id << 32), the value is the
+// newest entry with that id; older entries with the same id are shadowed and
+// can still be reached through the per-length chains.
+// Linear probing, power of two capacity, backward shift deletion (no tombstones).
+class DictionaryIndex {
+public:
+    explicit DictionaryIndex(size_t initialCapacity = 1024) {
+        size_t capacity = 16;
+        while (capacity < initialCapacity) capacity <<= 1;
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    // Insert or replace (a redefinition shadows the older entry)
+    void insert(uint64_t id, ForthDictionaryEntry *entry) {
+        if ((count + 1) * 4 > slots.size() * 3) {
+            grow();
+        }
+        size_t i = slotFor(id);
+        while (slots[i].entry) {
+            if (slots[i].id == id) {
+                slots[i].entry = entry;
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+        slots[i] = {id, entry};
+        ++count;
+    }
+
+    [[nodiscard]] ForthDictionaryEntry *find(uint64_t id) const {
+        size_t i = slotFor(id);
+        while (slots[i].entry) {
+            if (slots[i].id == id) {
+                return slots[i].entry;
+            }
+            i = (i + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    void erase(uint64_t id) {
+        size_t i = slotFor(id);
+        while (slots[i].entry && slots[i].id != id) {
+            i = (i + 1) & mask;
+        }
+        if (!slots[i].entry) return;
+
+        // shift later members of the cluster back into the hole
+        size_t hole = i;
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (!slots[j].entry) break;
+            const size_t home = slotFor(slots[j].id);
+            // move j into the hole unless its home lies cyclically in (hole, j]
+            if (((j - home) & mask) >= ((j - hole) & mask)) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole] = {};
+        --count;
+    }
+
+    void clear() {
+        for (auto &slot: slots) slot = {};
+        count = 0;
+    }
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] size_t capacity() const { return slots.size(); }
+
+private:
+    struct Slot {
+        uint64_t id{};
+        ForthDictionaryEntry *entry{};
+    };
+
+    // splitmix64 finalizer, word and vocab ids are small dense integers
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    [[nodiscard]] size_t slotFor(uint64_t id) const {
+        return static_cast<size_t>(mix(id)) & mask;
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(old.size() * 2);
+        mask = slots.size() - 1;
+        count = 0;
+        for (const auto &slot: old) {
+            if (slot.entry) insert(slot.id, slot.entry);
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t mask{};
+    size_t count{};
+};
+
+#endif // DICTIONARY_INDEX_H
@@ -3,6 +3,7 @@
 #include <asmjit/asmjit.h>
 #include <variant>
 #include <stack>
+#include <vector>
 #include <iostream>
 
 // these label stacks are used for control flow words.
@@ -43,6 +44,11 @@ struct CaseLabel
     asmjit::Label end_case_label;
     std::vector<asmjit::Label> endOfLabels;
     int ofCount = 0;
+    // literal OF keys are dispatched at CASE, each OF only binds its arm
+    bool keyed = false;
+    std::vector<asmjit::Label> armLabels;
+    asmjit::Label defaultLabel;
+    bool defaultBound = false;
 
     void print() const
     {
@@ -65,6 +71,7 @@ struct DoLoopLabel
     asmjit::Label loopLabel;
     asmjit::Label leaveLabel;
     bool hasLeave;
+    bool inRegisters = false; // index in r10, limit in r11
 };
 
 struct BeginAgainRepeatUntilLabel
@@ -100,6 +107,8 @@ inline std::stack<LoopLabel> loopStack;
 
 inline int doLoopDepth = 0;
 
+inline bool doLoopInRegisters = false; // compiling the body of a DO loop held in r10/r11
+
 inline std::stack<LoopLabel> tempLoopStack;
 
 // save stack to tempLoopStack
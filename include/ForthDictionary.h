@@ -3,12 +3,14 @@
 
 #include <memory>      // For std::unique_ptr
 #include <string>      // For std::string
+#include <string_view> // For std::string_view
 #include <vector>      // For std::vector
 #include <unordered_map> // For std::unordered_map
 #include <array>       // For std::array
 #include <Tokenizer.h>
 
 #include "ForthDictionaryEntry.h"
+#include "DictionaryIndex.h"
 #include "Singleton.h"
 
 
@@ -52,8 +54,13 @@ public:
     // Find a word in the dictionary using the search order
     ForthDictionaryEntry* findWord(const char* name) const;
 
+    // Allocation free lookup, name must already be upper case (the tokenizer folds case)
+    ForthDictionaryEntry* findWord(std::string_view name) const;
+
     bool isVariable(const char *name) const;
 
+    bool isVariable(uint32_t word_id) const;
+
     void execWord(const char *name);
 
     ForthDictionaryEntry *findWordByToken(const ForthToken &word) const;
@@ -91,6 +98,32 @@ public:
 
     void forgetLastWord();
 
+    // Set an entry's executable, the way compiled code calling through the entry sees it,
+    // and count its users for forgetLastWord
+    void setExecutable(const ForthDictionaryEntry *entry, ForthFunction executable);
+
+    // True if a live entry other than except runs code, or keeps it as its baseline. Forth code can store
+    // into the executable cell a CREATE word pushes without setExecutable counting it,
+    // so this scan guards code the counts say is free before it is released.
+    [[nodiscard]] bool executableInUse(const void *code, const ForthDictionaryEntry *except = nullptr) const;
+
+    // Forget the words added since marker, and marker itself (MARKER)
+    void forgetTo(const ForthDictionaryEntry *marker);
+
+    // Release the forgotten symbol ids nothing names any more;
+    // called once the interpreter has no tokens left that could hold them
+    void releaseForgottenSymbols() const;
+
+    // Visit every entry, in all vocabularies
+    template<typename Visitor>
+    void forEachEntry(Visitor visit) const {
+        for (ForthDictionaryEntry *head: dictionaryLists) {
+            for (ForthDictionaryEntry *entry = head; entry; entry = entry->previous) {
+                visit(entry);
+            }
+        }
+    }
+
 private:
     void addToCache(const std::string &name, ForthDictionaryEntry *entry);
 
@@ -98,6 +131,21 @@ private:
 
     ForthDictionaryEntry* findInCache(const std::string &name) const;
 
+    // 64 bit key used by the hash index, same layout as ForthDictionaryEntry::id
+    static uint64_t makeId(uint32_t word_id, uint32_t vocab_id) {
+        return (static_cast<uint64_t>(vocab_id) << 32) | word_id;
+    }
+
+    // Probe the index for word_id in each vocabulary of the search order
+    ForthDictionaryEntry *lookup(uint32_t word_id) const;
+
+    void indexEntry(ForthDictionaryEntry *entry);
+
+    void unindexEntry(ForthDictionaryEntry *entry);
+
+    // Rebuild the cached vocab ids whenever searchOrder changes
+    void rebuildSearchCache();
+
 private:
     // Dictionary lists (by word length): manage entries using smart pointers
     std::array<ForthDictionaryEntry*, MAX_WORD_LENGTH> dictionaryLists{};
@@ -108,6 +156,16 @@ private:
     // The search order for vocabularies
     std::vector<ForthDictionaryEntry*> searchOrder;
 
+    // vocab ids of searchOrder, deduplicated, in priority order
+    std::vector<uint32_t> searchVocabIds;
+
+    // id -> newest entry, avoids walking the chains on lookup
+    DictionaryIndex index;
+
+    // entries per entry id (the WordHeap key) and per word id, so forgetting is O(1)
+    std::unordered_map<uint64_t, uint32_t> entryUsers;
+    std::unordered_map<uint32_t, uint32_t> nameUsers;
+
     // Mapping from vocabulary name to its entry
     std::unordered_map<std::string, ForthDictionaryEntry*> vocabularies;
 
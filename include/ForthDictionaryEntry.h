@@ -5,6 +5,8 @@
 #include <deque>
 #include <iostream>
 #include <string> // Include this to avoid potential std::string issues
+#include <string_view>
+#include <vector>
 #include "WordHeap.h"
 #include "SymbolTable.h"
 #include "Tokenizer.h"
@@ -49,6 +51,41 @@ using ForthFunction = void(*)();
 using ImmediateInterpreter = void(*)(std::deque<ForthToken> &tokens);
 using ImmediateCompiler = void(*)(std::deque<ForthToken> &tokens);
 
+struct ForthDictionaryEntry;
+
+// Token stream of a small colon definition, expanded at call sites instead of a call.
+// words holds what each word token resolved to when the definition was compiled,
+// so a later redefinition of one of them stops the expansion.
+enum class MathAccuracy; // MathKernels.h
+
+struct InlineBody {
+    std::vector<ForthToken> tokens;
+    std::vector<const ForthDictionaryEntry *> words;
+};
+
+// Counted by the code of a word compiled with SET TIERING ON
+struct TierCounters {
+    uint64_t calls = 0;
+    uint64_t loops = 0; // iterations of its BEGIN and DO loops
+    uint64_t limit = 0; // calls + loops that make the word hot
+};
+
+// A word compiled by the baseline tier, with counters. Once hot it is compiled again
+// from its tokens with the optimizer and inlining on, and its executable is swapped;
+// callers compiled in the meantime call through the entry.
+struct TierProfile {
+    TierCounters counters;
+    bool floatStackSeparate = false; // the settings it was compiled under, kept when recompiled
+    MathAccuracy mathAccuracy{};
+    std::string text; // the token values, the tokens view it
+    std::vector<ForthToken> tokens; // : NAME ... ;
+    std::vector<const ForthDictionaryEntry *> words; // what each word token resolved to
+    ForthDictionaryEntry *entry = nullptr;
+    ForthFunction baseline = nullptr;
+    bool pending = false; // hot, waiting for the interpreter
+    bool recompiled = false;
+};
+
 
 struct ForthDictionaryEntry {
     ForthDictionaryEntry *previous;
@@ -77,10 +114,12 @@ struct ForthDictionaryEntry {
     ForthDictionaryEntry *firstWordInVocabulary;
     ImmediateCompiler immediate_compiler;
     ForthWordType type;
+    InlineBody *inlineBody = nullptr; // set for definitions small enough to inline
+    TierProfile *tierProfile = nullptr; // set for definitions compiled with SET TIERING ON
 
     // Constructor
-    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string &wordName,
-                         const std::string &vocabName, ForthState wordState, ForthWordType wordType)
+    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string_view wordName,
+                         const std::string_view vocabName, ForthState wordState, ForthWordType wordType)
         : previous(prev), state(wordState), executable(nullptr), generator(nullptr), capacity(0), immediate_interpreter(nullptr),
             offset(0),  data(nullptr), firstWordInVocabulary(nullptr), immediate_compiler(nullptr), type(wordType) {
         word_id = SymbolTable::instance().addSymbol(wordName);
@@ -90,8 +129,8 @@ struct ForthDictionaryEntry {
     }
 
 
-    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string &wordName,
-                         const std::string &vocabName, ForthState wordState, ForthWordType wordType,
+    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string_view wordName,
+                         const std::string_view vocabName, ForthState wordState, ForthWordType wordType,
                          ForthFunction executable)
         : previous(prev), state(wordState), executable(executable), generator(nullptr), capacity(0), immediate_interpreter(nullptr),
         offset(0),  data(nullptr), firstWordInVocabulary(nullptr), immediate_compiler(nullptr), type(wordType) {
@@ -102,7 +141,7 @@ struct ForthDictionaryEntry {
     }
 
 
-    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string &wordName, const std::string &vocabName,
+    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string_view wordName, const std::string_view vocabName,
                          ForthState wordState, ForthWordType wordType, ForthFunction generator,
                          ForthFunction executable, ImmediateInterpreter immediate_interpreter)
         : previous(prev), state(wordState), executable(executable), generator(generator),
@@ -114,7 +153,7 @@ struct ForthDictionaryEntry {
         std::memcpy(res1, asciiInput, 8);
     }
 
-    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string &wordName, const std::string &vocabName,
+    ForthDictionaryEntry(ForthDictionaryEntry *prev, const std::string_view wordName, const std::string_view vocabName,
                          ForthState wordState, ForthWordType wordType, ForthFunction generator,
                          ForthFunction executable, ImmediateInterpreter immediate_interpreter,
                          ImmediateCompiler immediate_compiler)
@@ -188,12 +227,12 @@ struct ForthDictionaryEntry {
 
 
     // Get the word name from the symbol table
-    [[nodiscard]] std::string getWordName() const {
+    [[nodiscard]] std::string_view getWordName() const {
         return SymbolTable::instance().getSymbol(word_id);
     }
 
     // Get the vocabulary name from the symbol table
-    [[nodiscard]] std::string getVocabularyName() const {
+    [[nodiscard]] std::string_view getVocabularyName() const {
         return SymbolTable::instance().getSymbol(vocab_id);
     }
 
@@ -14,11 +14,19 @@ public:
     // Main function to execute Forth code
     void execute(const std::string &input);
 
+    // Called after an error jumps back to QUIT
+    void recover();
+
 private:
     // Private constructor and destructor (required for singleton)
     Interpreter() = default;
     ~Interpreter() = default;
 
+    // Tokenizes and runs one line
+    void interpret(const std::string &input);
+
+    int depth = 0; // nested execute calls, from INCLUDE
+
     // Helper methods for token processing
     void handle_comment(ForthToken &first, std::deque<ForthToken> &tokens);
     void handle_word(std::deque<ForthToken> &tokens);
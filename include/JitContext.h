@@ -3,9 +3,14 @@
 
 #include <iostream>
 #include <cstdio>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include <vector>
 #include <ForthDictionary.h>
 
 #include "asmjit/asmjit.h"
+#include "PerfMap.h"
 #include "Singleton.h"
 #include "SignalHandler.h"
 
@@ -42,6 +47,7 @@ public:
         _logger.addFlags(asmjit::FormatFlags::kHexImms);
 
         _code.setLogger(&_logger);
+        _batchCode.setLogger(&_logger);
     }
 
     // Redirect logging to a file
@@ -60,6 +66,7 @@ public:
     // Disable logging
     void disableLogging() {
         _code.setLogger(nullptr);
+        _batchCode.setLogger(nullptr);
         if (_logFile) {
             if (fclose(_logFile) != 0) {
                 std::cerr << "Failed to close log file." << std::endl;
@@ -92,6 +99,8 @@ public:
     std::cout << "    Overhead:   " << toKB(_rt.allocator()->statistics().overheadSize()) << " KB" << std::endl;
     std::cout << "    Allocation Count: "
               << _rt.allocator()->statistics().allocationCount() << " allocations" << std::endl;
+    std::cout << "    Owned regions: " << _regions.size() << std::endl;
+    std::cout << "    Released:   " << toKB(_releasedBytes) << " KB" << std::endl;
 }
 
 
@@ -106,10 +115,11 @@ public:
             SignalHandler::instance().raise(20);
         }
         _assembler = new asmjit::x86::Assembler(&_code);
-
+        _pendingReferences.clear();
     }
 
-    ForthFunction finalize() {
+    // name labels the code for perf (SET PERFMAP)
+    ForthFunction finalize(std::string_view name = "jit") {
         void *funcPtr = nullptr;
         asmjit::Error err = _rt.add(&funcPtr, &_code);
         if (err) {
@@ -117,9 +127,168 @@ public:
                     << asmjit::DebugUtils::errorAsString(err) << std::endl;
             return nullptr;
         }
+        // each finalize owns one region of executable memory
+        _regions[reinterpret_cast<uintptr_t>(funcPtr)] = {_code.codeSize(), std::move(_pendingReferences)};
+        _pendingReferences.clear();
+        PerfMap::instance().add(name, funcPtr, _code.codeSize());
         return reinterpret_cast<ForthFunction>(funcPtr);
     }
 
+    // Record that the function being assembled calls or embeds target
+    void noteReference(const void *target) {
+        if (target) {
+            _pendingReferences.push_back(reinterpret_cast<uintptr_t>(target));
+        }
+    }
+
+    // True if fn is the start of a region added by finalize
+    [[nodiscard]] bool ownsCode(const void *fn) const {
+        return _regions.count(reinterpret_cast<uintptr_t>(fn)) != 0;
+    }
+
+    // Count of dictionary entries whose executable is fn, kept by ForthDictionary as it
+    // sets them; code is only released once no entry uses it.
+    void shareCode(const void *fn) {
+        if (fn) ++_codeUsers[reinterpret_cast<uintptr_t>(fn)];
+    }
+
+    void unshareCode(const void *fn) {
+        const auto it = _codeUsers.find(reinterpret_cast<uintptr_t>(fn));
+        if (it != _codeUsers.end() && --it->second == 0) _codeUsers.erase(it);
+    }
+
+    [[nodiscard]] size_t codeUsers(const void *fn) const {
+        const auto it = _codeUsers.find(reinterpret_cast<uintptr_t>(fn));
+        return it == _codeUsers.end() ? 0 : it->second;
+    }
+
+    // True if the code of another live region calls into the region starting at fn
+    [[nodiscard]] bool isReferenced(const void *fn) const {
+        const auto it = _regions.find(reinterpret_cast<uintptr_t>(fn));
+        if (it == _regions.end()) return false;
+        const uintptr_t start = it->first;
+        const uintptr_t end = start + it->second.size;
+        for (const auto &[other, region]: _regions) {
+            if (other == start) continue;
+            for (const uintptr_t target: region.references) {
+                if (target >= start && target < end) return true;
+            }
+        }
+        return false;
+    }
+
+    // Give the region starting at fn back to the runtime.
+    // Refuses (returns false) for code it does not own or that live code still calls.
+    bool releaseCode(const void *fn) {
+        if (!ownsCode(fn)) return false;
+        if (isReferenced(fn)) {
+            std::cerr << "JitContext: code at " << fn << " is still called, not released" << std::endl;
+            return false;
+        }
+        const auto it = _regions.find(reinterpret_cast<uintptr_t>(fn));
+        const asmjit::Error err = _rt.release(const_cast<void *>(fn));
+        if (err) {
+            std::cerr << "JitContext: failed to release code: "
+                    << asmjit::DebugUtils::errorAsString(err) << std::endl;
+            return false;
+        }
+        _releasedBytes += it->second.size;
+        _regions.erase(it);
+        PerfMap::instance().remove(fn);
+        return true;
+    }
+
+    // Batched emission.
+    // Between beginBatch and commitBatch, words are assembled one after another
+    // into a shared CodeHolder, each starting at its own label, and the whole
+    // batch is made executable by a single JitRuntime::add.
+    // Words in a batch have no address until the commit, so only words that are
+    // not called or executed before then can be batched.
+    void beginBatch() {
+        std::lock_guard<std::mutex> lock(init_mutex);
+        delete _batchAssembler;
+        _batchCode.reset();
+        if (_batchCode.init(_rt.environment()) != asmjit::kErrorOk) {
+            SignalHandler::instance().raise(20);
+        }
+        _batchCode.setLogger(_code.logger());
+        _batchAssembler = new asmjit::x86::Assembler(&_batchCode);
+        _batchWords = 0;
+        _batchBase = nullptr;
+        _batchStart = std::chrono::steady_clock::now();
+    }
+
+    [[nodiscard]] bool batching() const {
+        return _batchAssembler != nullptr;
+    }
+
+    // Direct getAssembler to the batch while one word is emitted
+    void beginBatchWord() {
+        std::lock_guard<std::mutex> lock(init_mutex);
+        _savedAssembler = _assembler;
+        _assembler = _batchAssembler;
+    }
+
+    void endBatchWord() {
+        std::lock_guard<std::mutex> lock(init_mutex);
+        _assembler = _savedAssembler;
+        _savedAssembler = nullptr;
+        ++_batchWords;
+    }
+
+    // Adds the batch to the runtime, returns its base address or nullptr
+    void *commitBatch() {
+        const auto assembled = std::chrono::steady_clock::now();
+        void *base = nullptr;
+        asmjit::Error err = _rt.add(&base, &_batchCode);
+        const auto committed = std::chrono::steady_clock::now();
+        if (err) {
+            std::cerr << "Failed to commit batch: "
+                    << asmjit::DebugUtils::errorAsString(err) << std::endl;
+            base = nullptr;
+        }
+
+        _batchStats.batches++;
+        _batchStats.words += _batchWords;
+        _batchStats.bytes += _batchCode.codeSize();
+        _batchStats.assembleTime += assembled - _batchStart;
+        _batchStats.commitTime += committed - assembled;
+
+        std::lock_guard<std::mutex> lock(init_mutex);
+        _batchBase = base;
+        delete _batchAssembler;
+        _batchAssembler = nullptr;
+        return base;
+    }
+
+    // Address of a label after the batch holding it was committed
+    [[nodiscard]] ForthFunction batchFunction(const asmjit::Label &label) const {
+        if (!_batchBase) return nullptr;
+        return reinterpret_cast<ForthFunction>(
+            static_cast<char *>(_batchBase) + _batchCode.labelOffsetFromBase(label));
+    }
+
+    // Names the words of the committed batch for perf, each runs from its start to the next
+    void nameBatchCode(const std::map<uintptr_t, std::string_view> &starts) const {
+        if (!_batchBase) return;
+        const uintptr_t end = reinterpret_cast<uintptr_t>(_batchBase) + _batchCode.codeSize();
+        for (auto it = starts.begin(); it != starts.end(); ++it) {
+            const auto next = std::next(it);
+            const uintptr_t stop = next == starts.end() ? end : next->first;
+            PerfMap::instance().add(it->second, reinterpret_cast<const void *>(it->first), stop - it->first);
+        }
+    }
+
+    void displayBatchStatistics() const {
+        using ms = std::chrono::duration<double, std::milli>;
+        std::cout << "JIT batches:" << std::endl;
+        std::cout << "    Batches:    " << _batchStats.batches << std::endl;
+        std::cout << "    Words:      " << _batchStats.words << std::endl;
+        std::cout << "    Code bytes: " << _batchStats.bytes << std::endl;
+        std::cout << "    Assemble:   " << ms(_batchStats.assembleTime).count() << " ms" << std::endl;
+        std::cout << "    Commit:     " << ms(_batchStats.commitTime).count() << " ms" << std::endl;
+    }
+
 private:
     JitContext() {
         _logger.setFile(stderr); // Default logging to stderr
@@ -133,6 +302,33 @@ public:
     asmjit::x86::Assembler *_assembler = nullptr; // Assembler for x86-64 instructions
     FILE *_logFile = nullptr; // File pointer for logging output
     std::mutex init_mutex;
+
+private:
+    struct CodeRegion {
+        size_t size;
+        std::vector<uintptr_t> references; // words this code calls
+    };
+
+    std::map<uintptr_t, CodeRegion> _regions; // start address -> region
+    std::vector<uintptr_t> _pendingReferences; // references of the function being assembled
+    std::unordered_map<uintptr_t, size_t> _codeUsers; // executable -> entries using it
+    size_t _releasedBytes = 0;
+
+    struct BatchStatistics {
+        size_t batches = 0;
+        size_t words = 0;
+        size_t bytes = 0;
+        std::chrono::steady_clock::duration assembleTime{};
+        std::chrono::steady_clock::duration commitTime{};
+    };
+
+    asmjit::CodeHolder _batchCode; // Shared holder for a batch of words
+    asmjit::x86::Assembler *_batchAssembler = nullptr;
+    asmjit::x86::Assembler *_savedAssembler = nullptr;
+    void *_batchBase = nullptr;
+    size_t _batchWords = 0;
+    std::chrono::steady_clock::time_point _batchStart;
+    BatchStatistics _batchStats;
 };
 
 #endif // JITCONTEXT_H
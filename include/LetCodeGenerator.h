@@ -96,6 +96,9 @@ private:
     void callMathFunction(const std::string &funcName, const asmjit::x86::Xmm &arg1Reg,
                           const asmjit::x86::Xmm &arg2Reg = asmjit::x86::Xmm());
 
+    void emitMathKernel(const std::string &funcName, const asmjit::x86::Xmm &arg1Reg,
+                        const asmjit::x86::Xmm &arg2Reg);
+
     void emitExponentiation(asmjit::x86::Xmm exprReg,
                             asmjit::x86::Xmm lhsReg,
                             asmjit::x86::Xmm rhsReg);
@@ -0,0 +1,98 @@
+#ifndef LETMAPGENERATOR_H
+#define LETMAPGENERATOR_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <asmjit/asmjit.h>
+#include "ParseLet.h"
+#include "Singleton.h"
+
+// LET-MAP compiles a LET statement into a loop over float arrays,
+//   : name LET-MAP (outs) = FN(ins) = exprs WHERE ... ;    ( in-addr ... out-addr ... n -- )
+// element i of each output array is the LET result for element i of the input arrays.
+//
+// The loop body is emitted twice from the same AST: packed, 8 lanes in ZMM registers with
+// AVX-512, 4 lanes in YMM with AVX2 or 2 lanes in XMM with SSE2, chosen by CPUID when the
+// word is compiled; then one element at a time for the n mod lanes left over.
+// Every value keeps its own vector register for the whole loop, literals and WHERE clauses
+// that do not depend on the inputs are computed once, before it.
+//
+// The functions with a vector form are sqrt, fabs, abs, fmin, fmax and pow with an integer
+// literal exponent (as is ^); anything else is an error, use a scalar LET.
+class LetMapGenerator : public Singleton<LetMapGenerator> {
+    friend class Singleton<LetMapGenerator>;
+
+public:
+    enum class Isa { SSE2, AVX2, AVX512 };
+
+    // The widest vector unit of this CPU, AVX-512 needs the F, DQ and VL subsets
+    static Isa select_isa();
+
+    static int lanes(Isa isa);
+
+    // Compiles no wider than widest, for tests and benchmarks, AVX512 to undo
+    void limit_isa(Isa widest);
+
+    // Emits the loop into the word being compiled, raises 22 (with a message)
+    // if an expression has no vector form or needs more registers than there are
+    void generateCode(const LetStatement *letStmt);
+
+private:
+    LetMapGenerator() = default;
+    ~LetMapGenerator() override = default;
+
+    enum class Op { ADD, SUB, MUL, DIV, MIN, MAX, AND, XOR, SQRT, MOV };
+
+    static constexpr uint64_t SIGN_BIT = 0x8000000000000000ULL;
+    static constexpr uint64_t ABS_MASK = 0x7FFFFFFFFFFFFFFFULL;
+    static constexpr uint64_t ONE = 0x3FF0000000000000ULL;
+    static constexpr int MAX_POWER = 64;
+    static constexpr int MAX_ARRAYS = 7;
+
+    // true if expr has a vector form, otherwise false with a message
+    bool vectorizable(const Expression *expr) const;
+
+    // true if expr does not depend on the inputs
+    bool invariant(const Expression *expr) const;
+
+    // the bit patterns of the constants expr uses
+    void collectConstants(const Expression *expr, std::set<uint64_t> &bits) const;
+
+    // temporary registers emit() needs for expr
+    int temporaries(const Expression *expr) const;
+
+    // Emits expr using the temporaries from depth up, returns the register holding it:
+    // a temporary, a variable or a constant
+    int emit(const Expression *expr, int depth);
+
+    int emitPower(const Expression *base, long exponent, int depth);
+
+    // register holding the constant, loaded into the temporary at depth if not hoisted
+    int constant(uint64_t bits, int depth);
+
+    void emitOp(Op op, int dst, int a, int b);
+    void loadConstant(uint64_t bits, int reg);
+    void load(int reg, const asmjit::x86::Gp &base);
+    void store(int reg, const asmjit::x86::Gp &base);
+
+    static bool integerExponent(const Expression *expr, long &exponent);
+    static uint64_t literalBits(const Expression *expr);
+
+    int temp(int depth) const { return firstTemporary + depth; }
+
+    asmjit::x86::Assembler *assembler = nullptr;
+    Isa widestIsa = Isa::AVX512;
+    Isa isa = Isa::SSE2;
+    bool packed = true; // false while emitting the one element tail
+    bool hoisting = true; // constants live in registers for the whole loop
+    int firstTemporary = 0;
+    std::set<std::string> inputs;
+    std::set<std::string> invariantWheres;
+    std::unordered_map<std::string, int> variables; // input and WHERE names -> register
+    std::map<uint64_t, int> constants; // hoisted constant bits -> register
+};
+
+#endif // LETMAPGENERATOR_H
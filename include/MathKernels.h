@@ -0,0 +1,42 @@
+#ifndef MATH_KERNELS_H
+#define MATH_KERNELS_H
+
+#include <string_view>
+#include <asmjit/asmjit.h>
+
+// Inline polynomial kernels for the transcendental float words and LET functions,
+// emitted straight into the caller's code instead of a call to libm, so live XMM
+// registers are not spilled around each call. Plain SSE4.1 (roundsd), no FMA.
+//
+// Error bounds, measured against long double libm over millions of random arguments,
+// in ULPs of the correctly rounded double result:
+//
+//              PRECISE                        FAST
+//   sin cos    2.5  for |x| <= 2^21          3e-9 absolute
+//   exp        1                             1e-8 relative
+//   log        1                             1e-8 relative
+//   tanh       3.5                           1e-8 relative
+//   pow        2 (1 + |y ln x|)              1e-8 (1 + |y ln x|) relative
+//
+// sin and cos reduce by pi/2 in three parts (Cody-Waite), past |x| = 2^21 the reduction
+// loses accuracy; use SET MATH LIBM there. exp, log and pow give libm's results for
+// zeros, infinities, NaNs, subnormals and negative bases with integer exponents.
+enum class MathAccuracy { LIBM, PRECISE, FAST };
+
+// scratch XMM registers a kernel may use
+constexpr int MATH_KERNEL_SCRATCH = 6;
+
+// sin cos exp log ln tanh pow
+bool math_kernel_available(std::string_view name);
+
+// Emits result = name(x) or name(x, y), false if there is no kernel or accuracy is LIBM.
+// Clobbers the scratch registers, rax, rcx and rdx. result is written last, so it may be
+// x, y or a scratch register; x and y must not be scratch registers.
+bool math_kernel_emit(asmjit::x86::Assembler &assembler, std::string_view name, MathAccuracy accuracy,
+                      const asmjit::x86::Xmm &result, const asmjit::x86::Xmm &x, const asmjit::x86::Xmm &y,
+                      const asmjit::x86::Xmm (&scratch)[MATH_KERNEL_SCRATCH]);
+
+// What the emitted kernel computes, bit for bit, for tests and error measurement
+double math_kernel_reference(std::string_view name, MathAccuracy accuracy, double x, double y = 0.0);
+
+#endif // MATH_KERNELS_H
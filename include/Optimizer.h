@@ -4,6 +4,7 @@
 #include "Singleton.h"
 #include "Tokenizer.h"
 #include <deque>
+#include <string_view>
 
 class Optimizer : public Singleton<Optimizer> {
     friend class Singleton<Optimizer>; // Allow access to private constructor for Singleton
@@ -11,9 +12,9 @@ class Optimizer : public Singleton<Optimizer> {
 public:
     int optimize(const std::deque<ForthToken> &tokens, std::deque<ForthToken> &optimized_tokens);
 
-    bool is_arithmetic_operator(const std::string &op);
+    bool is_arithmetic_operator(std::string_view op);
 
-    bool is_comparison_operator(const std::string &op);
+    bool is_comparison_operator(std::string_view op);
 
     bool optimize_constant_operation(const std::deque<ForthToken> &tokens, std::deque<ForthToken> &optimized_tokens,
                                      size_t index);
@@ -21,14 +22,9 @@ public:
     bool optimize_literal_comparison(const std::deque<ForthToken> &tokens, std::deque<ForthToken> &optimized_tokens,
                                      size_t index);
 
-    ForthToken getToken(const std::deque<ForthToken> &tokens, size_t i);
-
-    bool optimize_peephole_case(const std::deque<ForthToken> &tokens, std::deque<ForthToken> &optimized_tokens,
-                                size_t &index);
-
     bool is_power_of_two(int64_t value);
 
-    ForthToken create_optimized_token(const std::string &optimized_op);
+    ForthToken create_optimized_token(std::string_view optimized_op);
 
     void set_common_fields(ForthToken &token);
 
@@ -42,6 +38,7 @@ private:
     // Helper methods for folding and optimizing
     bool fold_constants(std::deque<ForthToken> &tokens, size_t start, size_t end);
     void optimize_literal_comparisons(std::deque<ForthToken> &tokens, std::deque<ForthToken> &optimized_tokens);
+    void mark_tail_calls(std::deque<ForthToken> &tokens);
 };
 
 #endif // OPTIMIZER_H
\ No newline at end of file
@@ -552,7 +552,7 @@ private:
             auto expr = std::make_unique<Expression>(ExprType::UNARY_OP, "neg");
             expr->children.push_back(std::move(child));
 
-            if (expr->children[0]->isConstant && expr->children[1]->isConstant) {
+            if (expr->children[0]->isConstant) {
                 expr->isConstant = true;
             }
 
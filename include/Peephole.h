@@ -0,0 +1,69 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Singleton.h"
+#include "Tokenizer.h"
+
+// Peephole rules, pattern => replacement, e.g. R> #n + >R => INC_R@
+// A pattern is a sequence of words and literal classes: #n matches any number,
+// #v any variable. The replacement is a word, or nothing to delete the pattern.
+// A FRAGMENTS macro replacement is given the pattern's number or variable.
+// Rules are held in a trie keyed by symbol id, every token position is matched in one walk;
+// rewriting repeats until no rule applies.
+class Peephole : public Singleton<Peephole> {
+    friend class Singleton<Peephole>;
+
+public:
+    // Parses and adds "pattern => replacement", false (with a message) if malformed
+    bool add_rule(std::string_view text);
+
+    // Rewrites the body of tokens in place, returns the number of rewrites
+    size_t rewrite(std::deque<ForthToken> &tokens);
+
+    // SHOW OPTIMIZER, the rules and how often each fired
+    void display() const;
+
+    // True if a rule's pattern or replacement names the symbol id
+    [[nodiscard]] bool usesSymbol(uint32_t id) const;
+
+private:
+    Peephole();
+    ~Peephole() override = default;
+
+    static constexpr uint32_t ANY_NUMBER = UINT32_MAX;
+    static constexpr uint32_t ANY_VARIABLE = UINT32_MAX - 1;
+    static constexpr int MAX_PASSES = 8;
+
+    struct Rule {
+        std::string text;
+        std::vector<uint32_t> pattern; // symbol ids, ANY_NUMBER or ANY_VARIABLE
+        std::string_view replacement; // symbol arena, empty to delete
+        uint32_t replacementId = 0;
+        bool fragment = false; // compiled by its immediate_interpreter, takes the operand
+        uint64_t hits = 0;
+    };
+
+    struct Node {
+        std::unordered_map<uint32_t, uint32_t> next; // element -> node
+        int rule = -1;
+    };
+
+    bool add(const std::vector<uint32_t> &pattern, std::string_view replacement, bool fragment, std::string text);
+
+    // Longest rule matching at tokens[start], -1 if none
+    int match(const std::deque<ForthToken> &tokens, size_t start) const;
+
+    void longest(const std::deque<ForthToken> &tokens, size_t position, uint32_t node, int &best) const;
+
+    std::vector<Node> trie;
+    std::vector<Rule> rules;
+};
+
+#endif // PEEPHOLE_H
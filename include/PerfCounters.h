@@ -0,0 +1,60 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Singleton.h"
+
+// Hardware performance counters, through Linux perf_event_open (SET COUNTERS ON|OFF).
+// BENCH and TIMEIT count the cycles, instructions, branch misses and L1d and LLC read misses
+// of the timed word, in user mode, and print them per iteration with the IPC.
+// The counters are opened as one group, so they count the same instructions; an event the
+// processor or a container does not offer is left out, and if none can be opened
+// the counters are unavailable and the timings are printed alone.
+class PerfCounters : public Singleton<PerfCounters> {
+    friend class Singleton<PerfCounters>;
+
+public:
+    enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, EVENTS };
+
+    struct Counts {
+        bool valid = false;
+        bool scaled = false; // the group was multiplexed with other users of the counters
+        std::array<bool, EVENTS> counted{};
+        std::array<double, EVENTS> values{};
+    };
+
+    // Opens the events that are offered, false if there are none
+    bool open();
+
+    void close();
+
+    [[nodiscard]] bool available() const { return leader >= 0; }
+
+    // Why open failed
+    [[nodiscard]] const std::string &error() const { return lastError; }
+
+    // Resets and enables the group
+    void start();
+
+    // Disables the group and reads it
+    Counts stop();
+
+    // Prints the counts divided by iterations, and the IPC
+    static void display(const Counts &counts, uint64_t iterations);
+
+    static const char *name(Event event);
+
+private:
+    PerfCounters();
+    ~PerfCounters() override;
+
+    std::array<int, EVENTS> fds{};
+    std::array<uint64_t, EVENTS> ids{};
+    int leader = -1;
+    std::string lastError;
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,69 @@
+#ifndef PERFMAP_H
+#define PERFMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Singleton.h"
+
+// Names JIT code for Linux perf, so perf report and perf annotate show Forth words
+// instead of anonymous addresses (SET PERFMAP ON|JITDUMP|OFF).
+//
+// MAP writes /tmp/perf-<pid>.map, a "start size name" line per word, read by perf report.
+// JITDUMP also writes /tmp/jit-<pid>.dump with the code bytes, in perf's jitdump format:
+//   perf record -k 1 ./ForthJIT ...
+//   perf inject --jit -i perf.data -o perf.jit.data
+//   perf annotate -i perf.jit.data
+// Every piece of code JitContext makes executable is remembered, so switching on also
+// names the words compiled before; code given back by FORGET is forgotten.
+class PerfMap : public Singleton<PerfMap> {
+    friend class Singleton<PerfMap>;
+
+public:
+    enum class Mode { OFF, MAP, JITDUMP };
+
+    struct Symbol {
+        std::string name;
+        uintptr_t start;
+        size_t size;
+    };
+
+    // Called for all code made executable, written out if the mode is not OFF
+    void add(std::string_view name, const void *code, size_t size);
+
+    // Called when code is released, its address may be reused
+    void remove(const void *code);
+
+    // Opens or closes the files, a file opened again is started afresh
+    void setMode(Mode newMode);
+
+    [[nodiscard]] Mode mode() const { return currentMode; }
+
+    // All live code, in the order it was made executable
+    [[nodiscard]] const std::vector<Symbol> &code() const { return symbols; }
+
+    [[nodiscard]] std::string mapPath() const;
+    [[nodiscard]] std::string dumpPath() const;
+
+private:
+    PerfMap() = default;
+    ~PerfMap() override;
+
+    void writeMap(const Symbol &symbol);
+    void writeDump(const Symbol &symbol);
+    bool openDump();
+    void closeDump();
+
+    std::vector<Symbol> symbols;
+    Mode currentMode = Mode::OFF;
+    FILE *mapFile = nullptr;
+    FILE *dumpFile = nullptr;
+    void *dumpMarker = nullptr; // the executable mapping of the dump that tells perf where it is
+    size_t dumpMarkerSize = 0;
+    uint64_t codeIndex = 0;
+};
+
+#endif // PERFMAP_H
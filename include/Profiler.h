@@ -0,0 +1,78 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Singleton.h"
+
+// Sampling profiler for Forth words (PROFILE word, PROFILE-START, PROFILE-REPORT).
+// A SIGPROF interval timer records the interrupted instruction address and the words
+// above it on the machine stack; the report maps them to the code ranges of the words
+// and counts, per word, the samples spent in it (self) and under it (total).
+// Nothing is compiled differently, and with no profile running no timer is armed.
+class Profiler : public Singleton<Profiler> {
+    friend class Singleton<Profiler>;
+
+public:
+    static constexpr int SAMPLE_HZ = 1000;
+
+    struct WordProfile {
+        std::string name;
+        size_t self = 0;
+        size_t total = 0;
+    };
+
+    struct CallProfile {
+        std::string caller;
+        std::string callee;
+        size_t samples = 0;
+    };
+
+    // Forgets earlier samples and arms the timer
+    void start();
+
+    void stop();
+
+    [[nodiscard]] bool running() const { return profiling; }
+
+    [[nodiscard]] size_t sampleCount() const;
+
+    // Words by self samples, then total
+    [[nodiscard]] std::vector<WordProfile> flat() const;
+
+    // Caller -> callee pairs by samples
+    [[nodiscard]] std::vector<CallProfile> callGraph() const;
+
+    // Stops, then prints the flat profile and the call graph
+    void report();
+
+private:
+    Profiler() = default;
+    ~Profiler() override;
+
+    static constexpr size_t MAX_SAMPLES = 16384;
+    static constexpr size_t STACK_WORDS = 64; // machine stack words scanned for return addresses
+
+    struct Sample {
+        uintptr_t pc;
+        size_t depth;
+        uintptr_t stack[STACK_WORDS];
+    };
+
+    // each sample as indexes into names, innermost first; names[0] is code outside the words
+    [[nodiscard]] std::vector<std::vector<int>> chains(std::vector<std::string> &names) const;
+
+    static void sample(const void *context);
+
+    std::vector<Sample> samples; // allocated by start, filled by the signal handler
+    std::atomic<size_t> taken{0};
+    std::atomic<size_t> dropped{0};
+    uintptr_t stackLow = 0; // this thread's stack
+    uintptr_t stackTop = 0;
+    bool profiling = false;
+};
+
+#endif // PROFILER_H
@@ -4,6 +4,9 @@
 #include <deque>
 #include "Tokenizer.h"
 #include "CodeGenerator.h"
+#include "MathKernels.h"
+#include "PerfMap.h"
+#include "PerfCounters.h"
 
 inline bool print_stack = false;
 inline bool optimizer;
@@ -13,12 +16,27 @@ inline bool GPCACHE = false;
 inline bool TrackLRU = true;
 inline int corePinned = 0;
 inline bool corePinnedSet = false;
+inline bool inlining = true;
+inline int inlineLimit = 8; // most tokens in a definition that is inlined
+inline bool tiering = false; // count calls, recompile hot words optimized
+inline int tierLimit = 1000; // calls + loop iterations that make a word hot
+inline bool floatStackSeparate = false; // floats on their own stack, not the data stack
+inline MathAccuracy mathAccuracy = MathAccuracy::LIBM; // sin cos exp ... call libm or are inlined
+inline bool hardwareCounters = false; // BENCH and TIMEIT also read the perf_event counters
 
 
 inline void display_settings() {
     std::cout << "Current Settings:" << std::endl;
     std::cout << "Stack prompt: " << (print_stack ? "ON" : "OFF") << std::endl;
     std::cout << "Optimizer: " << (optimizer ? "ON" : "OFF") << std::endl;
+    std::cout << "Inline: " << (inlining ? "ON" : "OFF") << " limit " << inlineLimit << " tokens" << std::endl;
+    std::cout << "Tiering: " << (tiering ? "ON" : "OFF") << " limit " << tierLimit << std::endl;
+    std::cout << "Float stack: " << (floatStackSeparate ? "SEPARATE" : "SHARED") << std::endl;
+    std::cout << "Math: " << (mathAccuracy == MathAccuracy::LIBM ? "LIBM"
+                              : mathAccuracy == MathAccuracy::PRECISE ? "PRECISE" : "FAST") << std::endl;
+    std::cout << "Perf map: " << (PerfMap::instance().mode() == PerfMap::Mode::OFF ? "OFF"
+                                  : PerfMap::instance().mode() == PerfMap::Mode::MAP ? "ON" : "JITDUMP") << std::endl;
+    std::cout << "Counters: " << (hardwareCounters ? "ON" : "OFF") << std::endl;
     std::cout << "JIT logging: " << (jitLogging ? "ON" : "OFF") << std::endl;
     std::cout << "Debug mode: " << (debug ? "ON" : "OFF") << std::endl;
     std::cout << "GPCACHE: " << (GPCACHE ? "ON" : "OFF") << std::endl;
@@ -38,6 +56,14 @@ std::cout << "Usage: SET <feature> <state>" << std::endl;
     std::cout << "  GPCACHE ON/OFF" << std::endl;
     std::cout << "  LOGGING ON/OFF" << std::endl;
     std::cout << "  OPTIMIZE ON/OFF" << std::endl;
+    std::cout << "  INLINE ON/OFF" << std::endl;
+    std::cout << "  INLINELIMIT n" << std::endl;
+    std::cout << "  TIERING ON/OFF" << std::endl;
+    std::cout << "  TIERLIMIT n" << std::endl;
+    std::cout << "  FSTACK SEPARATE/SHARED" << std::endl;
+    std::cout << "  MATH LIBM/PRECISE/FAST" << std::endl;
+    std::cout << "  PERFMAP ON/JITDUMP/OFF" << std::endl;
+    std::cout << "  COUNTERS ON/OFF" << std::endl;
     std::cout << "  TRACKLRU ON/OFF" << std::endl;
     std::cout << "  CORE ZERO,ONE,TWO,THREE,FOUR|ANY" << std::endl;
     std::cout << std::endl;
@@ -154,6 +180,89 @@ inline void runImmediateSET(std::deque<ForthToken> &tokens) {
             std::cout << "Optimizer disabled" << std::endl;
         }
     }
+
+    if (feature == "INLINE") {
+        if (state == "ON") {
+            inlining = true;
+            std::cout << "Inlining enabled" << std::endl;
+        } else if (state == "OFF") {
+            inlining = false;
+            std::cout << "Inlining disabled" << std::endl;
+        }
+    }
+
+    if (feature == "INLINELIMIT" && third.type == TOKEN_NUMBER) {
+        inlineLimit = static_cast<int>(third.int_value);
+        std::cout << "Inline limit " << inlineLimit << " tokens" << std::endl;
+    }
+
+    if (feature == "TIERING") {
+        if (state == "ON") {
+            tiering = true;
+            std::cout << "Tiering enabled" << std::endl;
+        } else if (state == "OFF") {
+            tiering = false;
+            std::cout << "Tiering disabled" << std::endl;
+        }
+    }
+
+    if (feature == "TIERLIMIT" && third.type == TOKEN_NUMBER) {
+        tierLimit = static_cast<int>(third.int_value);
+        std::cout << "Tier limit " << tierLimit << std::endl;
+    }
+
+    if (feature == "FSTACK") {
+        if (state == "SEPARATE" && !floatStackSeparate) {
+            floatStackSeparate = true;
+            code_generator_rebuild_float_words();
+            std::cout << "Separate float stack" << std::endl;
+        } else if (state == "SHARED" && floatStackSeparate) {
+            floatStackSeparate = false;
+            code_generator_rebuild_float_words();
+            std::cout << "Floats on the data stack" << std::endl;
+        }
+    }
+
+    if (feature == "MATH") {
+        const MathAccuracy before = mathAccuracy;
+        if (state == "LIBM") mathAccuracy = MathAccuracy::LIBM;
+        else if (state == "PRECISE") mathAccuracy = MathAccuracy::PRECISE;
+        else if (state == "FAST") mathAccuracy = MathAccuracy::FAST;
+        if (mathAccuracy != before) {
+            code_generator_rebuild_float_words();
+            std::cout << "Math " << state << std::endl;
+        }
+    }
+
+    if (feature == "PERFMAP") {
+        auto &perfMap = PerfMap::instance();
+        if (state == "ON") {
+            perfMap.setMode(PerfMap::Mode::MAP);
+            if (perfMap.mode() == PerfMap::Mode::MAP) std::cout << "Perf map " << perfMap.mapPath() << std::endl;
+        } else if (state == "JITDUMP") {
+            perfMap.setMode(PerfMap::Mode::JITDUMP);
+            if (perfMap.mode() == PerfMap::Mode::JITDUMP) std::cout << "Perf map and " << perfMap.dumpPath() << std::endl;
+        } else if (state == "OFF") {
+            perfMap.setMode(PerfMap::Mode::OFF);
+            std::cout << "Perf map off" << std::endl;
+        }
+    }
+
+    if (feature == "COUNTERS") {
+        auto &counters = PerfCounters::instance();
+        if (state == "ON") {
+            hardwareCounters = counters.open();
+            if (hardwareCounters) {
+                std::cout << "Counters on" << std::endl;
+            } else {
+                std::cout << "Counters unavailable, " << counters.error() << std::endl;
+            }
+        } else if (state == "OFF") {
+            counters.close();
+            hardwareCounters = false;
+            std::cout << "Counters off" << std::endl;
+        }
+    }
 }
 
 
@@ -17,6 +17,14 @@ public:
 
     void register_signal_handlers();
 
+    // Called from SIGPROF with the interrupted thread's ucontext
+    using ProfileSampler = void (*)(const void *context);
+
+    // SIGPROF every 1/hz seconds of CPU time calls sampler, false if the timer can not be armed
+    bool arm_profile_timer(int hz, ProfileSampler sampler);
+
+    void disarm_profile_timer();
+
 private:
     // Constructor (private to enforce singleton)
     SignalHandler() = default;
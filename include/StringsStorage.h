@@ -1,10 +1,20 @@
+#ifndef STRINGS_STORAGE_H
+#define STRINGS_STORAGE_H
+
 #include <unordered_set>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <mutex>
 #include <memory>
 #include <iostream>
+#include <iomanip>
+#include <cstring>
 #include <cstdlib> // For aligned_alloc (C++17)
 
+// Interned string literals (S" ." Z" etc.) referenced by compiled code.
+// Strings are copied once into a bump-pointer arena of 16-byte aligned chunks
+// and never move, so compiled words can embed their addresses.
 class StringStorage {
 public:
     static StringStorage& instance() {
@@ -13,7 +23,7 @@ public:
     }
 
     // Returns an interned string with guaranteed 16-byte alignment
-    const char* intern(const std::string& str);
+    const char* intern(std::string_view str);
 
     // Clears all interned strings
     void clear();
@@ -21,42 +31,102 @@ public:
     // Displays all interned strings along with their addresses
     void displayInternedStrings() const;
 
+    static constexpr size_t ALIGNMENT = 16;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    struct Statistics {
+        size_t strings = 0;
+        size_t stringBytes = 0; // bytes of text including terminators
+        size_t used = 0; // arena bytes, 16 byte aligned
+        size_t reserved = 0;
+        size_t chunks = 0;
+        size_t internCalls = 0;
+        size_t internHits = 0;
+    };
+
+    // The figures displayStatistics prints
+    Statistics statistics() const;
+
+    // Displays arena utilization and intern hit rate
+    void displayStatistics() const;
+
 private:
     StringStorage() = default;
     ~StringStorage();
 
-    // Aligned string pool
-    std::unordered_set<const char*> internedStrings;
+    struct Chunk {
+        char* base;
+        size_t size;
+        size_t used;
+    };
+
+    // Aligned string pool, each view's data() is the interned pointer
+    std::unordered_set<std::string_view> internedStrings;
+
+    // Arena chunks, the last one is the one being filled
+    std::vector<Chunk> chunks;
+
+    // Statistics
+    size_t internCalls = 0;
+    size_t internHits = 0;
+    size_t stringBytes = 0; // bytes of text including terminators
 
     // Mutex for thread safety
     mutable std::mutex mutex;
 
+    // Bump allocate size bytes, 16-byte aligned
+    char* allocate(size_t size);
+
     // Custom deallocation function for aligned memory
     void freeAligned(const char* ptr);
 };
 
-inline const char* StringStorage::intern(const std::string& str) {
-    std::lock_guard<std::mutex> lock(mutex);
+inline char* StringStorage::allocate(size_t size) {
+    size = ((size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
 
-    // Check if the string is already interned
-    for (const char* s : internedStrings) {
-        if (strcmp(s, str.c_str()) == 0) {
-            return s; // Return the existing interned string if it matches
+    if (size > CHUNK_SIZE) {
+        // Oversized strings get a chunk of their own, kept behind the chunk being filled
+        char* base = static_cast<char*>(std::aligned_alloc(ALIGNMENT, size));
+        if (!base) {
+            throw std::bad_alloc();
         }
+        chunks.insert(chunks.empty() ? chunks.end() : chunks.end() - 1, {base, size, size});
+        return base;
     }
 
-    // Allocate aligned memory for the new string
-    size_t size = str.size() + 1; // Include space for null terminator
-    char* alignedString = static_cast<char*>(std::aligned_alloc(16, ((size + 15) / 16) * 16));
-    if (!alignedString) {
-        throw std::bad_alloc();
+    if (chunks.empty() || chunks.back().size - chunks.back().used < size) {
+        char* base = static_cast<char*>(std::aligned_alloc(ALIGNMENT, CHUNK_SIZE));
+        if (!base) {
+            throw std::bad_alloc();
+        }
+        chunks.push_back({base, CHUNK_SIZE, 0});
     }
 
-    // Copy the string into the aligned memory
-    std::strncpy(alignedString, str.c_str(), size);
+    Chunk& chunk = chunks.back();
+    char* ptr = chunk.base + chunk.used;
+    chunk.used += size;
+    return ptr;
+}
+
+inline const char* StringStorage::intern(std::string_view str) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++internCalls;
+
+    // Check if the string is already interned
+    if (const auto it = internedStrings.find(str); it != internedStrings.end()) {
+        ++internHits;
+        return it->data(); // Return the existing interned string if it matches
+    }
+
+    // Copy the string into the arena
+    const size_t size = str.size() + 1; // Include space for null terminator
+    char* alignedString = allocate(size);
+    std::memcpy(alignedString, str.data(), str.size());
+    alignedString[str.size()] = '\0';
+    stringBytes += size;
 
     // Insert the aligned string into the pool
-    internedStrings.insert(alignedString);
+    internedStrings.emplace(alignedString, str.size());
 
     return alignedString;
 }
@@ -64,24 +134,62 @@ inline const char* StringStorage::intern(const std::string& str) {
 inline void StringStorage::clear() {
     std::lock_guard<std::mutex> lock(mutex);
 
-    // Free all aligned memory strings
-    for (const char* s : internedStrings) {
-        freeAligned(s);
+    // Free all arena chunks
+    for (const Chunk& chunk : chunks) {
+        freeAligned(chunk.base);
     }
 
+    chunks.clear();
     internedStrings.clear();
+    internCalls = 0;
+    internHits = 0;
+    stringBytes = 0;
 }
 
 inline void StringStorage::displayInternedStrings() const {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::cout << "Interned Strings:\n";
+        for (const std::string_view s : internedStrings) {
+            std::cout << std::hex
+                      << reinterpret_cast<const void*>(s.data())
+                      << " \"" << s << "\" \n";
+        }
+        std::cout << std::dec << std::endl;
+    }
+    displayStatistics();
+}
+
+inline StringStorage::Statistics StringStorage::statistics() const {
     std::lock_guard<std::mutex> lock(mutex);
 
-    std::cout << "Interned Strings:\n";
-    for (const char* s : internedStrings) {
-        std::cout << std::hex
-                  << reinterpret_cast<const void*>(s)
-                  << " \"" << s << "\" \n";
+    Statistics statistics;
+    for (const Chunk& chunk : chunks) {
+        statistics.reserved += chunk.size;
+        statistics.used += chunk.used;
     }
-    std::cout << std::dec << std::endl;
+    statistics.strings = internedStrings.size();
+    statistics.stringBytes = stringBytes;
+    statistics.chunks = chunks.size();
+    statistics.internCalls = internCalls;
+    statistics.internHits = internHits;
+    return statistics;
+}
+
+inline void StringStorage::displayStatistics() const {
+    const Statistics s = statistics();
+
+    std::cout << std::dec << "String arena:" << std::endl;
+    std::cout << "    Strings:       " << s.strings << std::endl;
+    std::cout << "    Text bytes:    " << s.stringBytes << std::endl;
+    std::cout << "    Used bytes:    " << s.used << " (16 byte aligned)" << std::endl;
+    std::cout << "    Reserved:      " << s.reserved << " bytes in " << s.chunks << " chunks" << std::endl;
+    std::cout << "    Utilization:   " << std::fixed << std::setprecision(1)
+              << (s.reserved ? 100.0 * static_cast<double>(s.used) / static_cast<double>(s.reserved) : 0.0) << "%" << std::endl;
+    std::cout << "    Intern calls:  " << s.internCalls << ", hits " << s.internHits << " ("
+              << (s.internCalls ? 100.0 * static_cast<double>(s.internHits) / static_cast<double>(s.internCalls) : 0.0)
+              << "%)" << std::defaultfloat << std::endl;
 }
 
 inline StringStorage::~StringStorage() {
@@ -92,4 +200,6 @@ inline StringStorage::~StringStorage() {
 inline void StringStorage::freeAligned(const char* ptr) {
     // Free aligned memory
     std::free(const_cast<char*>(ptr));
-}
\ No newline at end of file
+}
+
+#endif // STRINGS_STORAGE_H
@@ -3,9 +3,19 @@
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstring>
 #include <iostream>
 #include <cstdint>
 
+// Interns word and vocabulary names as small integer IDs.
+// IDs index a dense vector of names; the name text lives in an append-only
+// arena, so a string_view returned by getSymbol stays valid for the session.
+// A forgotten ID is held back until nothing refers to it: tokens of the line being
+// interpreted, peephole rules and the token copies kept for inlining and tiering
+// may still hold it, and must not find a different word under it.
 class SymbolTable {
 public:
     static SymbolTable& instance() {
@@ -14,18 +24,40 @@ public:
     }
 
     // Adds a new word or returns the existing ID if already present
-    uint32_t addSymbol(const std::string& name) {
+    uint32_t addSymbol(const std::string_view name) {
         auto it = symbols.find(name);
         if (it != symbols.end()) {
             return it->second;
         }
-        uint32_t id = next_id++;
-        symbols[name] = id;
-        reverse_lookup[id] = name;
+
+        // a name forgotten and defined again gets its ID back
+        if (auto held = forgotten.find(name); held != forgotten.end()) {
+            const std::string_view stored = held->first;
+            const uint32_t id = held->second;
+            forgotten.erase(held);
+            names[id] = stored;
+            symbols.emplace(stored, id);
+            return id;
+        }
+
+        const std::string_view stored = storeName(name);
+
+        // reuse an ID released by releaseForgotten
+        uint32_t id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+            names[id] = stored;
+        } else {
+            id = static_cast<uint32_t>(names.size());
+            names.push_back(stored);
+        }
+        symbols.emplace(stored, id);
         return id;
     }
 
-    uint32_t findSymbol(const std::string& name) {
+    // Lookup without allocating, the name must already be case folded
+    uint32_t findSymbol(const std::string_view name) const {
         auto it = symbols.find(name);
         if (it != symbols.end()) {
             return it->second;
@@ -33,22 +65,40 @@ public:
         return 0;
     }
 
-    // Removes a symbol if it exists
-    bool forgetSymbol(const std::string& name) {
+    // Removes a symbol if it exists, its ID is held until releaseForgotten
+    bool forgetSymbol(const std::string_view name) {
         auto it = symbols.find(name);
         if (it != symbols.end()) {
+            const std::string_view stored = it->first;
             uint32_t id = it->second;
 
-            // Remove from both maps
             symbols.erase(it);
-            reverse_lookup.erase(id);
+            names[id] = {};
+            forgotten.emplace(stored, id);
             return true;
         }
         return false; // Symbol wasn't found
     }
 
+    [[nodiscard]] bool hasForgotten() const {
+        return !forgotten.empty();
+    }
+
+    // Lets addSymbol hand out the forgotten IDs inUse(id) no longer reports, to any name
+    template<typename InUse>
+    void releaseForgotten(InUse inUse) {
+        for (auto it = forgotten.begin(); it != forgotten.end();) {
+            if (inUse(it->second)) {
+                ++it;
+                continue;
+            }
+            freeIds.push_back(it->second);
+            it = forgotten.erase(it);
+        }
+    }
+
 
-    uint32_t definedSymbol(const std::string& name) {
+    uint32_t definedSymbol(const std::string_view name) const {
         auto it = symbols.find(name);
         if (it != symbols.end()) {
             return it->second;
@@ -57,13 +107,16 @@ public:
     }
 
 
-    // Gets the string name from an ID
-    [[nodiscard]] std::string getSymbol(const uint32_t id) const {
-        auto it = reverse_lookup.find(id);
-        if (it != reverse_lookup.end()) {
-            return it->second;
+    // Gets the name from an ID, empty if the ID is not in use
+    [[nodiscard]] std::string_view getSymbol(const uint32_t id) const {
+        if (id < names.size()) {
+            return names[id];
         }
-        return "";
+        return {};
+    }
+
+    [[nodiscard]] size_t size() const {
+        return symbols.size();
     }
 
     void printSymbols() const {
@@ -73,10 +126,35 @@ public:
     }
 
 private:
-    SymbolTable() = default;
-    std::unordered_map<std::string, uint32_t> symbols;
-    std::unordered_map<uint32_t, std::string> reverse_lookup;
-    uint32_t next_id = 1; // Start from 1 (0 can be used as NULL_ID)
+    SymbolTable() {
+        names.emplace_back(); // ID 0 is the NULL_ID
+    }
+
+    static constexpr size_t ARENA_CHUNK = 16 * 1024;
+
+    // Copy name into the arena, names are never moved or freed
+    std::string_view storeName(const std::string_view name) {
+        const size_t size = name.size() + 1; // keep names NUL terminated
+        if (arena.empty() || ARENA_CHUNK - arenaUsed < size) {
+            arena.emplace_back(new char[size > ARENA_CHUNK ? size : ARENA_CHUNK]);
+            arenaUsed = 0;
+        }
+        char* text = arena.back().get() + arenaUsed;
+        std::memcpy(text, name.data(), name.size());
+        text[name.size()] = '\0';
+        arenaUsed += size;
+        if (size > ARENA_CHUNK) {
+            arenaUsed = ARENA_CHUNK; // oversized chunk is full
+        }
+        return {text, name.size()};
+    }
+
+    std::unordered_map<std::string_view, uint32_t> symbols; // keys view the arena
+    std::vector<std::string_view> names; // ID -> name
+    std::unordered_map<std::string_view, uint32_t> forgotten; // name -> ID, held back
+    std::vector<uint32_t> freeIds;
+    std::vector<std::unique_ptr<char[]>> arena;
+    size_t arenaUsed = 0;
 };
 
 
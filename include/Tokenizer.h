@@ -3,7 +3,10 @@
 
 #include <deque>
 #include "Singleton.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 
 #define MAX_INPUT 1024
@@ -34,68 +37,55 @@ typedef enum {
     TOKEN_CALL          // Optimized function calls (Tail call)
 } TokenType;
 
-// Token structure with all necessary constructors
+// Token structure, trivially copyable so token streams can be copied and
+// optimized without per-token heap allocations.
+// value views the source line (the caller keeps it alive while the tokens are in use),
+// or the symbol table arena for known words; optimized_op views the symbol table arena.
 struct ForthToken {
     TokenType type = TOKEN_UNKNOWN;
-    uint64_t int_value = 0;
-    double float_value = 0.0;
-    std::string value;
+    TokenType original_type = TOKEN_UNKNOWN;
+    uint32_t word_id = 0;
+    uint32_t word_len = 0;
+    union {
+        uint64_t int_value = 0;
+        double float_value; // TOKEN_FLOAT only
+    };
+    int64_t opt_value = 0;
+    std::string_view value;
+    std::string_view optimized_op;
 
     // Optimization-specific fields
     bool is_optimized = false;
     bool is_immediate = false;
     bool in_comment = false;
-    int64_t opt_value = 0;
-    TokenType original_type = TOKEN_UNKNOWN;
-    std::string optimized_op;
-    uint32_t word_id;
-    uint32_t word_len;
 
     // ✅ Default Constructor
     ForthToken() = default;
 
     // ✅ Constructor for regular tokens
-    ForthToken(TokenType t, std::string v = "", int i_val = 0, double f_val = 0.0)
-        : type(t), int_value(i_val), float_value(f_val), value(std::move(v)),
-          is_optimized(false), opt_value(0), original_type(t), optimized_op("") {}
-
-    // ✅ Constructor for optimized tokens
-    ForthToken(TokenType t, std::string op, int64_t opt_val)
-        : type(t), int_value(0), float_value(0.0), value(""),
-          is_optimized(true), opt_value(opt_val), original_type(t), optimized_op(std::move(op)) {}
+    ForthToken(TokenType t, std::string_view v = {}, int i_val = 0)
+        : type(t), original_type(t), int_value(static_cast<uint64_t>(static_cast<int64_t>(i_val))), value(v) {}
 
     ForthToken(TokenType t, int i_val)
-     : type(t), int_value(i_val), float_value(0.0), value(""),
-       is_optimized(false), opt_value(0), original_type(t), optimized_op("") {}
-
-    // Constructor for TokenType and std::string
-    ForthToken(TokenType t, const std::string& str_val)
-        : type(t), int_value(0), float_value(0.0), value(str_val),
-          is_optimized(false), opt_value(0), original_type(t), optimized_op("") {}
-
-
-
-    // ✅ Copy and move constructors
-    ForthToken(const ForthToken&) = default;
-    ForthToken(ForthToken&&) noexcept = default;
-    ForthToken& operator=(const ForthToken&) = default;
-    ForthToken& operator=(ForthToken&&) noexcept = default;
-
+        : type(t), original_type(t), int_value(static_cast<uint64_t>(static_cast<int64_t>(i_val))) {}
 
     // ✅ Reset method
     void reset() {
-        type = TOKEN_UNKNOWN;
-        int_value = 0;
-        float_value = 0.0;
-        value.clear();
-        in_comment = false;
-        is_optimized = false;
-        opt_value = 0;
-        original_type = TOKEN_UNKNOWN;
-        optimized_op.clear();
+        *this = ForthToken();
     }
 };
 
+static_assert(std::is_trivially_copyable_v<ForthToken>, "ForthToken must stay trivially copyable");
+
+// A defining word (: CREATE VARIABLE ...) takes the next token's text as the new name.
+// Under HEX a name such as FACE or ADD is tokenized as a number, so numbers name words too.
+inline bool is_new_name(const ForthToken &token) {
+    return (token.type == TOKEN_UNKNOWN || token.type == TOKEN_NUMBER || token.type == TOKEN_FLOAT) &&
+           !token.value.empty();
+}
+
+// Non-throwing number parser, see Tokenizer.cpp for the accepted prefixes
+bool parse_number(const char *str, size_t len, int base, int64_t &result);
 
 
 
@@ -105,6 +95,10 @@ class Tokenizer : public Singleton<Tokenizer> {
 
 private:
     bool inComment = false;
+    int numberBase = 10; // BASE the line being tokenized is classified in
+    const int64_t *baseCell = nullptr; // BASE's data, looked up again once per line
+
+    int current_base();
 
 public:
 
@@ -119,6 +113,18 @@ public:
 
     int tokenize_forth(const std::string &input, std::deque<ForthToken> &tokens);
 
+    // The BASE tokenize_forth last classified a line in
+    [[nodiscard]] int token_base() const { return numberBase; }
+
+    // A line is tokenized before it runs, so HEX FF or 16 BASE ! FF on one line find BASE changed
+    // part way through: the number and unknown tokens still to run are classified again.
+    // base is the caller's own record of the BASE its tokens are in, so a nested INCLUDE,
+    // which tokenizes other lines meanwhile, does not lose it.
+    void rebase(std::deque<ForthToken> &tokens, int &base);
+
+    // A word was forgotten, BASE's data may have gone with it
+    void forget_base() { baseCell = nullptr; }
+
 
     Tokenizer() = default;
 
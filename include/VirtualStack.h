@@ -0,0 +1,39 @@
+#ifndef VIRTUAL_STACK_H
+#define VIRTUAL_STACK_H
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include "Singleton.h"
+#include "Tokenizer.h"
+
+// Compiles straight line runs of stack words (DUP SWAP OVER ROT ...), + - AND OR and
+// literals against a symbolic model of the data stack.
+// Values computed in the run live in scratch registers, values that are only shuffled
+// are never moved; the canonical R13/R12/[R15] layout is written back once, at the end
+// of the run, which is before any call, branch or the end of the word.
+class VirtualStack : public Singleton<VirtualStack> {
+    friend class Singleton<VirtualStack>;
+
+public:
+    // Compiles the run at the front of tokens if that beats the primitives,
+    // returns the number of tokens compiled, 0 if none.
+    size_t compile_region(const std::deque<ForthToken> &tokens);
+
+    // Counters for the definition being compiled
+    void reset_counts();
+
+    // With SET LOGGING ON, what the pass saved in this definition
+    void report(const std::string &word_name) const;
+
+private:
+    VirtualStack() = default;
+    ~VirtualStack() = default;
+
+    size_t regions = 0;
+    size_t words = 0;
+    size_t primitiveInstructions = 0; // the primitives' own code for the runs
+    size_t emittedInstructions = 0;
+};
+
+#endif // VIRTUAL_STACK_H
@@ -0,0 +1,140 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <x86intrin.h>
+
+// Calls a word count times. Words load rbp with their dictionary entry and use rbx as scratch,
+// so both are saved here; r12-r15 are the Forth stacks and pass from call to call.
+// The word and the count live on the machine stack, which is 16 byte aligned at each call.
+__attribute__((naked)) static void call_word(ForthFunction, uint64_t) {
+    asm volatile(
+        "pushq %rbp\n"
+        "pushq %rbx\n"
+        "pushq %rdi\n"
+        "pushq %rsi\n"
+        "subq $8, %rsp\n"
+        "testq %rsi, %rsi\n"
+        "jz 2f\n"
+        "1:\n"
+        "callq *16(%rsp)\n"
+        "decq 8(%rsp)\n"
+        "jnz 1b\n"
+        "2:\n"
+        "addq $24, %rsp\n"
+        "popq %rbx\n"
+        "popq %rbp\n"
+        "ret\n"
+    );
+}
+
+namespace {
+    // ns in the largest unit that keeps it at least 1
+    void displayTime(const double ns) {
+        if (ns < 1e3) {
+            std::cout << std::setprecision(2) << ns << " ns";
+        } else if (ns < 1e6) {
+            std::cout << std::setprecision(2) << ns / 1e3 << " us";
+        } else if (ns < 1e9) {
+            std::cout << std::setprecision(2) << ns / 1e6 << " ms";
+        } else {
+            std::cout << std::setprecision(3) << ns / 1e9 << " s";
+        }
+    }
+}
+
+uint64_t Benchmark::nanoseconds() {
+    timespec now{};
+#ifdef __APPLE__
+    clock_gettime(CLOCK_UPTIME_RAW, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+#endif
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+uint64_t Benchmark::ticks() {
+    unsigned int processor;
+    return __rdtscp(&processor);
+}
+
+void Benchmark::call(const ForthFunction word, const uint64_t count) {
+    call_word(word, count);
+}
+
+Benchmark::Result Benchmark::run(const ForthFunction word, const size_t samples, const bool count) {
+    Result result;
+    if (!word || samples == 0) return lastResult = result;
+
+    // double the batch until it takes BATCH_NS, then keep running it until warmed up
+    const uint64_t warmupStart = nanoseconds();
+    uint64_t batch = 1;
+    for (;;) {
+        const uint64_t start = nanoseconds();
+        call(word, batch);
+        const uint64_t elapsed = nanoseconds() - start;
+        if (elapsed >= BATCH_NS) break;
+        // grow at least twice and at most 16 times, a first call may be slow
+        const uint64_t scaled = elapsed == 0 ? batch * 16 : batch * BATCH_NS / elapsed + 1;
+        batch = std::min(std::max(scaled, batch * 2), batch * 16);
+    }
+    while (nanoseconds() - warmupStart < WARMUP_NS) {
+        call(word, batch);
+    }
+
+    auto &counters = PerfCounters::instance();
+    if (count) counters.start();
+
+    std::vector<double> times(samples);
+    std::vector<double> tickCounts(samples);
+    for (size_t i = 0; i < samples; i++) {
+        const uint64_t startTicks = ticks();
+        const uint64_t start = nanoseconds();
+        call(word, batch);
+        const uint64_t elapsed = nanoseconds() - start;
+        const uint64_t elapsedTicks = ticks() - startTicks;
+        result.totalNs += elapsed;
+        times[i] = static_cast<double>(elapsed) / static_cast<double>(batch);
+        tickCounts[i] = static_cast<double>(elapsedTicks) / static_cast<double>(batch);
+    }
+    if (count) result.counts = counters.stop();
+
+    result.samples = samples;
+    result.iterations = batch;
+    double sum = 0;
+    for (const double t: times) sum += t;
+    result.mean = sum / static_cast<double>(samples);
+    double squares = 0;
+    for (const double t: times) squares += (t - result.mean) * (t - result.mean);
+    result.stddev = samples > 1 ? std::sqrt(squares / static_cast<double>(samples - 1)) : 0;
+
+    std::sort(times.begin(), times.end());
+    std::sort(tickCounts.begin(), tickCounts.end());
+    result.min = times.front();
+    result.median = times[samples / 2];
+    result.p99 = times[static_cast<size_t>(std::ceil(0.99 * static_cast<double>(samples))) - 1];
+    result.ticks = tickCounts[samples / 2];
+    return lastResult = result;
+}
+
+void Benchmark::display(const Result &result) {
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed;
+    std::cout << "  min ";
+    displayTime(result.min);
+    std::cout << "  median ";
+    displayTime(result.median);
+    std::cout << "  p99 ";
+    displayTime(result.p99);
+    std::cout << "  mean ";
+    displayTime(result.mean);
+    std::cout << " +/- ";
+    displayTime(result.stddev);
+    std::cout << " per iteration, " << std::setprecision(1) << result.ticks << " ticks" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
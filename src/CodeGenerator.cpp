@@ -8,6 +8,8 @@
 #include "LabelManager.h"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <cstdlib>
 #include <StringsStorage.h>
 #include <unistd.h>
@@ -15,9 +17,14 @@
 #include "SignalHandler.h"
 #include "Settings.h"
 #include <csignal>
-#include <mach/mach_time.h>
 #include "Interpreter.h"
+#include "Peephole.h"
+#include "Compiler.h"
+#include "MathKernels.h"
+#include "Profiler.h"
+#include "Benchmark.h"
 #include <fcntl.h>
+#include <chrono>
 
 
 void *code_generator_heap_start = nullptr;
@@ -138,7 +145,7 @@ bool initialize_assembler(asmjit::x86::Assembler *&assembler) {
 // set the code for an entry to stack its own address.
 // used by a vocabulary entry etc
 void set_stack_self(const ForthDictionaryEntry *e) {
-    code_generator_startFunction(e->getWordName());
+    code_generator_startFunction(std::string(e->getWordName()));
 
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
@@ -151,8 +158,8 @@ void set_stack_self(const ForthDictionaryEntry *e) {
     labels.createLabel(*assembler, "exit_function");
     labels.bindLabel(*assembler, "exit_function");
     compile_return();
-    const auto fn = code_generator_finalizeFunction(e->getWordName());
-    e->executable = fn;
+    const auto fn = code_generator_finalizeFunction(std::string(e->getWordName()));
+    ForthDictionary::instance().setExecutable(e, fn);
 }
 
 
@@ -217,7 +224,11 @@ void unpinThread() {
 }
 
 
+// time taken by code_generator_initialize, see SHOW TIMINGS
+static std::chrono::steady_clock::duration startupTime{};
+
 void code_generator_initialize() {
+    const auto startupStart = std::chrono::steady_clock::now();
     track_heap();
     optimizer = true;
 
@@ -251,6 +262,9 @@ void code_generator_initialize() {
     dict.setVocabulary("FORTH");
     dict.setSearchOrder({"FORTH", "UNSAFE", "FRAGMENTS"});
     code_generator_add_variables();
+
+    // the primitive set is assembled as one batch, nothing runs until it is committed
+    code_generator_begin_batch();
     code_generator_add_memory_words();
     code_generator_add_stack_words();
     code_generator_add_operator_words();
@@ -259,6 +273,7 @@ void code_generator_initialize() {
     code_generator_add_control_flow_words();
     code_generator_add_vocab_words();
     code_generator_add_float_words();
+    code_generator_commit_batch();
 
     // compiler has started lets directly compile some small core words.
 
@@ -391,6 +406,7 @@ void code_generator_initialize() {
     Interpreter::instance().execute(
         R"( CLS ." MacForth" )");
 
+    startupTime = std::chrono::steady_clock::now() - startupStart;
 
     // std::cout << "FORTH dictionary created." << std::endl;
 }
@@ -686,6 +702,42 @@ void compile_pushConstantValue(const int64_t literal, const std::string &name) {
     assembler->add(asmjit::x86::r14, 8);
 }
 
+// An innermost DO loop that leaves the return stack alone keeps its index in r10 and its
+// limit in r11; its RS frame stays in place, the index cell is only written before calls.
+static bool planDoLoopInRegisters = false; // set by the compiler for the next DO
+
+void code_generator_plan_do_loop(const bool registers) {
+    planDoLoopInRegisters = registers;
+}
+
+// a CASE with only literal OF keys is dispatched at CASE, see genCase
+static std::vector<int64_t> plannedCaseKeys; // set by the compiler for the next CASE
+
+void code_generator_plan_case(const std::vector<int64_t> &keys) {
+    plannedCaseKeys = keys;
+}
+
+static void spill_loop_registers(asmjit::x86::Assembler *assembler) {
+    if (!doLoopInRegisters) return;
+    assembler->comment("; -- spill loop index");
+    assembler->mov(asmjit::x86::qword_ptr(asmjit::x86::r14), asmjit::x86::r10);
+}
+
+static void reload_loop_registers(asmjit::x86::Assembler *assembler) {
+    if (!doLoopInRegisters) return;
+    assembler->comment("; -- reload loop index and limit");
+    assembler->mov(asmjit::x86::r10, asmjit::x86::qword_ptr(asmjit::x86::r14));
+    assembler->mov(asmjit::x86::r11, asmjit::x86::qword_ptr(asmjit::x86::r14, 8));
+}
+
+// every call out of generated code, the callee may use r10/r11
+template<typename Target>
+static void call_out(asmjit::x86::Assembler *assembler, const Target &target) {
+    spill_loop_registers(assembler);
+    assembler->call(target);
+    reload_loop_registers(assembler);
+}
+
 
 // genFetch - fetch the contents of the address
 [[maybe_unused]] static void genFetch(uint64_t address) {
@@ -743,11 +795,40 @@ static void spit_cls() {
     std::cout << "\033c";
 }
 
+// SET FSTACK SEPARATE, the top two floats of the word being compiled are cached in XMM registers,
+// see float_push; floatCached counts them
+static const asmjit::x86::Xmm FTOS = asmjit::x86::xmm8;
+static const asmjit::x86::Xmm FNOS = asmjit::x86::xmm9;
+static const asmjit::x86::Gp FSP = asmjit::x86::r8; // float stack pointer, once loaded
+static int floatCached = 0;
+static bool floatPointerLoaded = false;
+
+// SET TIERING ON, the profile of the word being compiled, its loops count iterations
+static TierProfile *countedProfile = nullptr;
+
+static void count_loop_iteration(asmjit::x86::Assembler *assembler) {
+    if (!countedProfile) return;
+    assembler->comment("; -- count loop iteration");
+    assembler->mov(asmjit::x86::rax, asmjit::imm(&countedProfile->counters.loops));
+    assembler->inc(asmjit::x86::qword_ptr(asmjit::x86::rax));
+}
+
 // call at function start
 void code_generator_startFunction(const std::string &name) {
     JitContext::instance().initialize();
+    doLoopInRegisters = false;
+    planDoLoopInRegisters = false;
+    plannedCaseKeys.clear();
+    countedProfile = nullptr;
+    code_generator_enterFunction(name);
+}
+
+// function prologue, into the current assembler, returns the entry label
+asmjit::Label code_generator_enterFunction(const std::string &name) {
     asmjit::x86::Assembler *assembler;
-    if (initialize_assembler(assembler)) return;
+    if (initialize_assembler(assembler)) return {};
+    floatCached = 0;
+    floatPointerLoaded = false;
     assembler->align(asmjit::AlignMode::kCode, 16);
     assembler->commentf("; -- enter function: %s ", name.c_str());
     labels.clearLabels();
@@ -770,6 +851,7 @@ void code_generator_startFunction(const std::string &name) {
     assembler->mov(asmjit::x86::rax, asmjit::imm(entry->getAddress()));
     // Copy the value from rax into rbp
     assembler->mov(asmjit::x86::rbp, asmjit::x86::rax);
+    return funcLabels.entryLabel;
 }
 
 
@@ -785,6 +867,7 @@ void compile_return() {
         SignalHandler::instance().raise(10);
         return;
     }
+    code_generator_flush_floats();
     labels.bindLabel(*assembler, "exit_label");
     loopStack.pop();
     assembler->ret();
@@ -796,7 +879,7 @@ ForthFunction code_generator_finalizeFunction(const std::string &name) {
     asmjit::x86::Assembler *assembler;
     initialize_assembler(assembler);
     assembler->comment(funcName.c_str());
-    return JitContext::instance().finalize();
+    return JitContext::instance().finalize(name);
 }
 
 void code_generator_reset() {
@@ -808,7 +891,7 @@ void compile_call_C(void (*func)()) {
     initialize_assembler(assembler);
     assembler->comment("; --- call c code");
     assembler->push(asmjit::x86::rdi);
-    assembler->call(func);
+    call_out(assembler, func);
     assembler->pop(asmjit::x86::rdi);
 }
 
@@ -817,17 +900,51 @@ void compile_call_forth(void (*func)(), const std::string &forth_word) {
     initialize_assembler(assembler);
     // keep stack 16 byte aligned.
     assembler->commentf("; --- call forth %s", forth_word.c_str());
+    JitContext::instance().noteReference(reinterpret_cast<const void *>(func));
+    assembler->sub(asmjit::x86::rsp, 8);
+    call_out(assembler, func);
+    assembler->add(asmjit::x86::rsp, 8);
+}
+
+// call in tail position, the callee returns straight to our caller.
+// rsp is as it was on entry, so the callee sees the same alignment as after a call.
+// Inside a DO loop EXIT has to drop the loop parameters first, refuse.
+bool compile_tail_call_forth(void (*func)(), const std::string &forth_word) {
+    if (doLoopDepth > 0) return false;
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->commentf("; --- tail call forth %s", forth_word.c_str());
+    JitContext::instance().noteReference(reinterpret_cast<const void *>(func));
+    assembler->jmp(asmjit::imm(reinterpret_cast<uint64_t>(func)));
+    return true;
+}
+
+void compile_call_forth_entry(const ForthDictionaryEntry *entry, const std::string &forth_word) {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->commentf("; --- call forth %s through its entry", forth_word.c_str());
     assembler->sub(asmjit::x86::rsp, 8);
-    assembler->call(func);
+    assembler->mov(asmjit::x86::rax, asmjit::imm(&entry->executable));
+    call_out(assembler, asmjit::x86::qword_ptr(asmjit::x86::rax));
     assembler->add(asmjit::x86::rsp, 8);
 }
 
+bool compile_tail_call_forth_entry(const ForthDictionaryEntry *entry, const std::string &forth_word) {
+    if (doLoopDepth > 0) return false;
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->commentf("; --- tail call forth %s through its entry", forth_word.c_str());
+    assembler->mov(asmjit::x86::rax, asmjit::imm(&entry->executable));
+    assembler->jmp(asmjit::x86::qword_ptr(asmjit::x86::rax));
+    return true;
+}
+
 void compile_call_C_char(void (*func)(char *)) {
     asmjit::x86::Assembler *assembler;
     initialize_assembler(assembler);
     assembler->push(asmjit::x86::rdi);
     assembler->mov(asmjit::x86::rdi, asmjit::x86::r13);
-    assembler->call(func);
+    call_out(assembler, func);
     assembler->pop(asmjit::x86::rdi);
 }
 
@@ -1121,7 +1238,21 @@ void cpush(int64_t value) {
 }
 
 
+// SET FSTACK SEPARATE, floats have a stack of their own, full descending like the data stack.
+// Compiled code keeps its top two items in XMM registers, see float_push.
+constexpr size_t FLOAT_STACK_SIZE = 1024;
+alignas(16) static double floatStack[FLOAT_STACK_SIZE];
+static double *floatStackPointer = floatStack + FLOAT_STACK_SIZE;
+
 void cfpush(double value) {
+    if (floatStackSeparate) {
+        if (floatStackPointer == floatStack) {
+            SignalHandler::instance().raise(2);
+            return;
+        }
+        *--floatStackPointer = value;
+        return;
+    }
     __asm__ __volatile__ (
 
         "subq $8, %%r15 \n" // Allocate 8 bytes on the stack (R15 points downward)
@@ -1150,6 +1281,13 @@ int64_t cpop() {
 }
 
 double cfpop() {
+    if (floatStackSeparate) {
+        if (floatStackPointer == floatStack + FLOAT_STACK_SIZE) {
+            SignalHandler::instance().raise(1);
+            return 0.0;
+        }
+        return *floatStackPointer++;
+    }
     double result;
     __asm__ __volatile__ (
         "movq %%r13, %0 \n"
@@ -1743,7 +1881,7 @@ void code_generator_add_memory_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_PlusStore),
-                     code_generator_build_forth(compile_PlusStore),
+                     code_generator_build_forth(compile_PlusStore, "+!"),
                      nullptr);
 
 
@@ -1751,21 +1889,21 @@ void code_generator_add_memory_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_MOVE),
-                     code_generator_build_forth(compile_MOVE),
+                     code_generator_build_forth(compile_MOVE, "MOVE"),
                      nullptr);
 
     dict.addCodeWord("PLACE", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_PLACE),
-                     code_generator_build_forth(compile_PLACE),
+                     code_generator_build_forth(compile_PLACE, "PLACE"),
                      nullptr);
 
     dict.addCodeWord("+PLACE", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_PLUS_PLACE),
-                     code_generator_build_forth(compile_PLUS_PLACE),
+                     code_generator_build_forth(compile_PLUS_PLACE, "+PLACE"),
                      nullptr);
 
 
@@ -1773,7 +1911,7 @@ void code_generator_add_memory_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_COMPARE),
-                     code_generator_build_forth(compile_COMPARE),
+                     code_generator_build_forth(compile_COMPARE, "COMPARE"),
                      nullptr);
 
 
@@ -1781,35 +1919,35 @@ void code_generator_add_memory_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_CMOVE),
-                     code_generator_build_forth(compile_CMOVE),
+                     code_generator_build_forth(compile_CMOVE, "CMOVE"),
                      nullptr);
 
     dict.addCodeWord("CMOVE>", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_CMOVEREV),
-                     code_generator_build_forth(compile_CMOVEREV),
+                     code_generator_build_forth(compile_CMOVEREV, "CMOVE>"),
                      nullptr);
 
     dict.addCodeWord("FILL", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_FILL),
-                     code_generator_build_forth(compile_FILL),
+                     code_generator_build_forth(compile_FILL, "FILL"),
                      nullptr);
 
     // dict.addCodeWord("BLANK", "UNSAFE",
     //                  ForthState::EXECUTABLE,
     //                  ForthWordType::WORD,
     //                  static_cast<ForthFunction>(&compile_BLANK),
-    //                  code_generator_build_forth(compile_BLANK),
+    //                  code_generator_build_forth(compile_BLANK, "BLANK"),
     //                  nullptr);
     //
     // dict.addCodeWord("ERASE", "UNSAFE",
     //                  ForthState::EXECUTABLE,
     //                  ForthWordType::WORD,
     //                  static_cast<ForthFunction>(&compile_ERASE),
-    //                  code_generator_build_forth(compile_ERASE),
+    //                  code_generator_build_forth(compile_ERASE, "ERASE"),
     //                  nullptr);
 
     dict.addCodeWord("DUMP", "UNSAFE",
@@ -2020,18 +2158,63 @@ void *rdepth() {
 }
 
 
+// generators assembled into the open batch, and their entry labels
+static std::unordered_map<ForthFunction, asmjit::Label> batchedGenerators;
+
 // Used to build a working forth word, that can be executed by the compiler.
-ForthFunction code_generator_build_forth(const ForthFunction fn) {
+// While a batch is open the word is only assembled, its executable is
+// filled in by code_generator_commit_batch.
+// name is the word the code is built for; it labels the code for perf
+ForthFunction code_generator_build_forth(const ForthFunction fn, const std::string &name) {
     // we need to start a new function
-    ForthDictionary &dict = ForthDictionary::instance();
+    auto &jc = JitContext::instance();
+
+    if (jc.batching()) {
+        if (!batchedGenerators.count(fn)) {
+            jc.beginBatchWord();
+            batchedGenerators[fn] = code_generator_enterFunction(name);
+            fn();
+            compile_return();
+            jc.endBatchWord();
+        }
+        return nullptr;
+    }
 
-    code_generator_startFunction(dict.getLatestName());
+    code_generator_startFunction(name);
     fn();
     compile_return();
-    const auto f = reinterpret_cast<ForthFunction>(JitContext::instance().finalize());
+    const auto f = reinterpret_cast<ForthFunction>(JitContext::instance().finalize(name));
     return f;
 }
 
+void code_generator_begin_batch() {
+    batchedGenerators.clear();
+    JitContext::instance().beginBatch();
+}
+
+// Commit the open batch and patch the executable of every word built in it.
+// Words sharing a generator share its code.
+void code_generator_commit_batch() {
+    auto &jc = JitContext::instance();
+    if (!jc.batching()) return;
+
+    if (!jc.commitBatch()) {
+        SignalHandler::instance().raise(12);
+        return;
+    }
+
+    std::map<uintptr_t, std::string_view> starts;
+    ForthDictionary::instance().forEachEntry([&jc, &starts](ForthDictionaryEntry *entry) {
+        if (entry->executable || !entry->generator) return;
+        if (const auto it = batchedGenerators.find(entry->generator); it != batchedGenerators.end()) {
+            ForthDictionary::instance().setExecutable(entry, jc.batchFunction(it->second));
+            starts.emplace(reinterpret_cast<uintptr_t>(entry->executable), entry->getWordName());
+        }
+    });
+    jc.nameBatchCode(starts);
+    batchedGenerators.clear();
+}
+
 
 // add stack words to dictionary
 void code_generator_add_stack_words() {
@@ -2043,7 +2226,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_r2Drop),
-                     code_generator_build_forth(Compile_r2Drop),
+                     code_generator_build_forth(Compile_r2Drop, "2RDROP"),
                      nullptr);
 
 
@@ -2052,7 +2235,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_rDrop),
-                     code_generator_build_forth(Compile_rDrop),
+                     code_generator_build_forth(Compile_rDrop, "RDROP"),
                      nullptr);
 
 
@@ -2061,7 +2244,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_rSwap),
-                     code_generator_build_forth(Compile_rSwap),
+                     code_generator_build_forth(Compile_rSwap, "R>R"),
                      nullptr);
 
     dict.addCodeWord("DEPTH", "FORTH",
@@ -2083,49 +2266,49 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&storeFromDS),
-                     code_generator_build_forth(storeFromDS),
+                     code_generator_build_forth(storeFromDS, "!"),
                      nullptr);
 
     dict.addCodeWord("C!", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&cstoreFromDS),
-                     code_generator_build_forth(cstoreFromDS),
+                     code_generator_build_forth(cstoreFromDS, "C!"),
                      nullptr);
 
     dict.addCodeWord("W!", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&wstoreFromDS),
-                     code_generator_build_forth(wstoreFromDS),
+                     code_generator_build_forth(wstoreFromDS, "W!"),
                      nullptr);
 
     dict.addCodeWord("L!", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&lstoreFromDS),
-                     code_generator_build_forth(lstoreFromDS),
+                     code_generator_build_forth(lstoreFromDS, "L!"),
                      nullptr);
 
     dict.addCodeWord("C@", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&cfetchFromDS),
-                     code_generator_build_forth(cfetchFromDS),
+                     code_generator_build_forth(cfetchFromDS, "C@"),
                      nullptr);
 
     dict.addCodeWord("W@", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&wfetchFromDS),
-                     code_generator_build_forth(wfetchFromDS),
+                     code_generator_build_forth(wfetchFromDS, "W@"),
                      nullptr);
 
     dict.addCodeWord("L@", "UNSAFE",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&lfetchFromDS),
-                     code_generator_build_forth(lfetchFromDS),
+                     code_generator_build_forth(lfetchFromDS, "L@"),
                      nullptr);
 
 
@@ -2133,7 +2316,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&fetchFromDS),
-                     code_generator_build_forth(fetchFromDS),
+                     code_generator_build_forth(fetchFromDS, "@"),
                      nullptr);
 
     // R@
@@ -2141,14 +2324,14 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_rFetch),
-                     code_generator_build_forth(Compile_rFetch),
+                     code_generator_build_forth(Compile_rFetch, "R@"),
                      nullptr);
 
     dict.addCodeWord("RP@", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_rpAt),
-                     code_generator_build_forth(Compile_rpAt),
+                     code_generator_build_forth(Compile_rpAt, "RP@"),
                      nullptr);
 
     // RP!
@@ -2156,7 +2339,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_rpStore),
-                     code_generator_build_forth(Compile_rpStore),
+                     code_generator_build_forth(Compile_rpStore, "RP!"),
                      nullptr);
 
     // >R
@@ -2164,7 +2347,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_toR),
-                     code_generator_build_forth(Compile_toR),
+                     code_generator_build_forth(Compile_toR, ">R"),
                      nullptr
     );
 
@@ -2172,7 +2355,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_2toR),
-                     code_generator_build_forth(Compile_2toR),
+                     code_generator_build_forth(Compile_2toR, "2>R"),
                      nullptr
     );
 
@@ -2181,7 +2364,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_2xtoR),
-                     code_generator_build_forth(Compile_2xtoR),
+                     code_generator_build_forth(Compile_2xtoR, "2X>R"),
                      nullptr
     );
 
@@ -2190,7 +2373,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_fromR),
-                     code_generator_build_forth(Compile_fromR),
+                     code_generator_build_forth(Compile_fromR, "R>"),
                      nullptr
     );
 
@@ -2198,7 +2381,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_2fromR),
-                     code_generator_build_forth(Compile_2fromR),
+                     code_generator_build_forth(Compile_2fromR, "2R>"),
                      nullptr
     );
 
@@ -2207,7 +2390,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&Compile_2xR),
-                     code_generator_build_forth(Compile_2xR),
+                     code_generator_build_forth(Compile_2xR, "2xR>"),
                      nullptr
     );
 
@@ -2217,7 +2400,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_DUP),
-                     code_generator_build_forth(compile_DUP),
+                     code_generator_build_forth(compile_DUP, "DUP"),
                      nullptr);
 
 
@@ -2226,7 +2409,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_DROP),
-                     code_generator_build_forth(compile_DROP),
+                     code_generator_build_forth(compile_DROP, "DROP"),
                      nullptr);
 
     // 2DROP
@@ -2234,7 +2417,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_2DROP),
-                     code_generator_build_forth(compile_2DROP),
+                     code_generator_build_forth(compile_2DROP, "2DROP"),
                      nullptr);
 
 
@@ -2243,7 +2426,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_3DROP),
-                     code_generator_build_forth(compile_3DROP),
+                     code_generator_build_forth(compile_3DROP, "3DROP"),
                      nullptr);
 
     // SWAP
@@ -2251,7 +2434,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_SWAP),
-                     code_generator_build_forth(compile_SWAP),
+                     code_generator_build_forth(compile_SWAP, "SWAP"),
                      nullptr);
 
     // OVER
@@ -2259,7 +2442,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_OVER),
-                     code_generator_build_forth(compile_OVER),
+                     code_generator_build_forth(compile_OVER, "OVER"),
                      nullptr);
 
     // ROT
@@ -2267,7 +2450,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_ROT),
-                     code_generator_build_forth(compile_ROT),
+                     code_generator_build_forth(compile_ROT, "ROT"),
                      nullptr);
 
     // -ROT
@@ -2275,7 +2458,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_MROT),
-                     code_generator_build_forth(compile_MROT),
+                     code_generator_build_forth(compile_MROT, "-ROT"),
                      nullptr);
 
     // NIP
@@ -2283,7 +2466,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_NIP),
-                     code_generator_build_forth(compile_NIP),
+                     code_generator_build_forth(compile_NIP, "NIP"),
                      nullptr);
 
     // TUCK
@@ -2291,7 +2474,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_TUCK),
-                     code_generator_build_forth(compile_TUCK),
+                     code_generator_build_forth(compile_TUCK, "TUCK"),
                      nullptr);
 
     // PICK
@@ -2299,7 +2482,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_PICK),
-                     code_generator_build_forth(compile_PICK),
+                     code_generator_build_forth(compile_PICK, "PICK"),
                      nullptr);
 
     // ROLL
@@ -2307,7 +2490,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_ROLL),
-                     code_generator_build_forth(compile_ROLL),
+                     code_generator_build_forth(compile_ROLL, "ROLL"),
                      nullptr);
 
     // 2DUP
@@ -2315,7 +2498,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_2DUP),
-                     code_generator_build_forth(compile_2DUP),
+                     code_generator_build_forth(compile_2DUP, "2DUP"),
                      nullptr);
 
     // 2OVER
@@ -2323,7 +2506,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compiler_2OVER),
-                     code_generator_build_forth(compiler_2OVER),
+                     code_generator_build_forth(compiler_2OVER, "2OVER"),
                      nullptr);
 
     // SP@
@@ -2331,7 +2514,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_AT),
-                     code_generator_build_forth(compile_AT),
+                     code_generator_build_forth(compile_AT, "SP@"),
                      nullptr);
 
     // SP!
@@ -2339,7 +2522,7 @@ void code_generator_add_stack_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_SP_STORE),
-                     code_generator_build_forth(compile_SP_STORE),
+                     code_generator_build_forth(compile_SP_STORE, "SP!"),
                      nullptr);
 }
 
@@ -2351,7 +2534,7 @@ static void compile_EXEC() {
     popDS(asmjit::x86::rax); //
     // balance RSP
     assembler->sub(asmjit::x86::rsp, 8);
-    assembler->call(asmjit::x86::rax);
+    call_out(assembler, asmjit::x86::rax);
     assembler->add(asmjit::x86::rsp, 8);
 }
 
@@ -2517,7 +2700,7 @@ static void compile_NEG_CHECK() {
     labels.jge(*assembler, "neg_check_end"); // If >= 0, skip the negative branch
     assembler->push(asmjit::x86::rdi);
     assembler->mov(asmjit::x86::rdi, '-');
-    assembler->call(spit_char);
+    call_out(assembler, spit_char);
     assembler->pop(asmjit::x86::rdi); // Restore RDI
     assembler->neg(asmjit::x86::r13); // Negate TOS if negative
     // Label: End of NEG_CHECK logic
@@ -2702,6 +2885,55 @@ static void compile_NEQ() {
 }
 
 
+static void compile_ZERO_EQ() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+
+    assembler->comment("; -- 0= (equal to zero)");
+
+    assembler->test(asmjit::x86::r13, asmjit::x86::r13);
+    assembler->sete(asmjit::x86::al);
+    assembler->movzx(asmjit::x86::r13, asmjit::x86::al);
+    assembler->neg(asmjit::x86::r13); // -1 (true) or 0 (false)
+}
+
+static void compile_ZERO_NEQ() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+
+    assembler->comment("; -- 0<> (not zero)");
+
+    assembler->test(asmjit::x86::r13, asmjit::x86::r13);
+    assembler->setne(asmjit::x86::al);
+    assembler->movzx(asmjit::x86::r13, asmjit::x86::al);
+    assembler->neg(asmjit::x86::r13);
+}
+
+static void compile_ZERO_LT() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+
+    assembler->comment("; -- 0< (negative)");
+
+    assembler->test(asmjit::x86::r13, asmjit::x86::r13);
+    assembler->setl(asmjit::x86::al);
+    assembler->movzx(asmjit::x86::r13, asmjit::x86::al);
+    assembler->neg(asmjit::x86::r13);
+}
+
+static void compile_ZERO_GT() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+
+    assembler->comment("; -- 0> (positive)");
+
+    assembler->test(asmjit::x86::r13, asmjit::x86::r13);
+    assembler->setg(asmjit::x86::al);
+    assembler->movzx(asmjit::x86::r13, asmjit::x86::al);
+    assembler->neg(asmjit::x86::r13);
+}
+
+
 void code_generator_add_operator_words() {
     ForthDictionary &dict = ForthDictionary::instance();
 
@@ -2709,7 +2941,7 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      compile_EXEC,
-                     code_generator_build_forth(compile_EXEC),
+                     code_generator_build_forth(compile_EXEC, "EXEC"),
                      nullptr);
 
 
@@ -2717,21 +2949,21 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_EQ),
-                     code_generator_build_forth(compile_EQ),
+                     code_generator_build_forth(compile_EQ, "="),
                      nullptr);
 
     dict.addCodeWord("<>", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_NEQ),
-                     code_generator_build_forth(compile_NEQ),
+                     code_generator_build_forth(compile_NEQ, "<>"),
                      nullptr);
 
     dict.addCodeWord("<", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_LT),
-                     code_generator_build_forth(compile_LT),
+                     code_generator_build_forth(compile_LT, "<"),
                      nullptr);
 
 
@@ -2739,7 +2971,7 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_GT),
-                     code_generator_build_forth(compile_GT),
+                     code_generator_build_forth(compile_GT, ">"),
                      nullptr);
 
 
@@ -2747,21 +2979,49 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_LE),
-                     code_generator_build_forth(compile_LE),
+                     code_generator_build_forth(compile_LE, "<="),
+                     nullptr);
+
+    dict.addCodeWord("0=", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&compile_ZERO_EQ),
+                     code_generator_build_forth(compile_ZERO_EQ, "0="),
+                     nullptr);
+
+    dict.addCodeWord("0<>", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&compile_ZERO_NEQ),
+                     code_generator_build_forth(compile_ZERO_NEQ, "0<>"),
+                     nullptr);
+
+    dict.addCodeWord("0<", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&compile_ZERO_LT),
+                     code_generator_build_forth(compile_ZERO_LT, "0<"),
+                     nullptr);
+
+    dict.addCodeWord("0>", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&compile_ZERO_GT),
+                     code_generator_build_forth(compile_ZERO_GT, "0>"),
                      nullptr);
 
     dict.addCodeWord("/MOD", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_DIVMOD),
-                     code_generator_build_forth(compile_DIVMOD),
+                     code_generator_build_forth(compile_DIVMOD, "/MOD"),
                      nullptr);
 
     dict.addCodeWord("*/", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
-                     nullptr,
-                     code_generator_build_forth(compile_SCALE),
+                     static_cast<ForthFunction>(&compile_SCALE),
+                     code_generator_build_forth(compile_SCALE, "*/"),
                      nullptr);
 
 
@@ -2769,7 +3029,7 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_SCALEMOD),
-                     code_generator_build_forth(compile_SCALEMOD),
+                     code_generator_build_forth(compile_SCALEMOD, "*/MOD"),
                      nullptr);
 
 
@@ -2777,21 +3037,21 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_SQRT),
-                     code_generator_build_forth(compile_SQRT),
+                     code_generator_build_forth(compile_SQRT, "SQRT"),
                      nullptr);
 
     dict.addCodeWord("XOR", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_XOR),
-                     code_generator_build_forth(compile_XOR),
+                     code_generator_build_forth(compile_XOR, "XOR"),
                      nullptr);
 
     dict.addCodeWord("NOT", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_NOT),
-                     code_generator_build_forth(compile_NOT),
+                     code_generator_build_forth(compile_NOT, "NOT"),
                      nullptr);
 
 
@@ -2799,14 +3059,14 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_ADD),
-                     code_generator_build_forth(compile_ADD),
+                     code_generator_build_forth(compile_ADD, "+"),
                      nullptr);
 
     dict.addCodeWord("-", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_SUB),
-                     code_generator_build_forth(compile_SUB),
+                     code_generator_build_forth(compile_SUB, "-"),
                      nullptr
     );
 
@@ -2814,7 +3074,7 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_NEG),
-                     code_generator_build_forth(compile_NEG),
+                     code_generator_build_forth(compile_NEG, "NEGATE"),
                      nullptr
     );
 
@@ -2822,7 +3082,7 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_NEG_CHECK),
-                     code_generator_build_forth(compile_NEG_CHECK),
+                     code_generator_build_forth(compile_NEG_CHECK, ".-"),
                      nullptr
     );
 
@@ -2830,7 +3090,7 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_ABS),
-                     code_generator_build_forth(compile_ABS),
+                     code_generator_build_forth(compile_ABS, "ABS"),
                      nullptr
     );
 
@@ -2839,14 +3099,14 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_MUL),
-                     code_generator_build_forth(compile_MUL),
+                     code_generator_build_forth(compile_MUL, "*"),
                      nullptr);
 
     dict.addCodeWord("/", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_DIV),
-                     code_generator_build_forth(compile_DIV),
+                     code_generator_build_forth(compile_DIV, "/"),
                      nullptr);
 
 
@@ -2854,21 +3114,21 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_UDIV),
-                     code_generator_build_forth(compile_UDIV),
+                     code_generator_build_forth(compile_UDIV, "U/"),
                      nullptr);
 
     dict.addCodeWord("MOD", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_MOD),
-                     code_generator_build_forth(compile_MOD),
+                     code_generator_build_forth(compile_MOD, "MOD"),
                      nullptr);
 
     dict.addCodeWord("UMOD", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_UMOD),
-                     code_generator_build_forth(compile_UMOD),
+                     code_generator_build_forth(compile_UMOD, "UMOD"),
                      nullptr);
 
 
@@ -2876,14 +3136,14 @@ void code_generator_add_operator_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_AND),
-                     code_generator_build_forth(compile_AND),
+                     code_generator_build_forth(compile_AND, "AND"),
                      nullptr);
 
     dict.addCodeWord("OR", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_OR),
-                     code_generator_build_forth(compile_OR),
+                     code_generator_build_forth(compile_OR, "OR"),
                      nullptr);
 }
 
@@ -2908,7 +3168,7 @@ void runImmediateString(std::deque<ForthToken> &tokens) {
         SignalHandler::instance().raise(11);
         return;
     }
-    code_generator_puts_no_crlf(first.value.c_str());
+    code_generator_puts_no_crlf(std::string(first.value).c_str());
     tokens.erase(tokens.begin());
 }
 
@@ -2957,7 +3217,7 @@ void runImmediateTICK(std::deque<ForthToken> &tokens) {
     if (tokens.empty()) return; // Exit early if no tokens to process
     // Get and remove the first token
     const ForthToken first = tokens.front();
-    const auto word_name = first.value;
+    const std::string word_name(first.value);
     tokens.erase(tokens.begin());
     auto &dict = ForthDictionary::instance();
     auto word = dict.findWord(word_name.c_str());
@@ -2969,13 +3229,15 @@ void runImmediateTICK(std::deque<ForthToken> &tokens) {
 
 void process_forth_file(const std::string &filename);
 
+void display_load_timings();
+
 extern std::unordered_set<std::string> loaded_files;
 
 void runImmediateFLOAD(std::deque<ForthToken> &tokens) {
     if (tokens.empty()) return; // Exit early if no tokens to process
     // Get and remove the first token
     const ForthToken first = tokens.front();
-    const auto file_name = first.value;
+    const std::string file_name(first.value);
     tokens.erase(tokens.begin());
     process_forth_file(file_name);
     loaded_files.clear();
@@ -2988,7 +3250,7 @@ void runImmediateINCLUDE(std::deque<ForthToken> &tokens) {
     if (tokens.empty()) return; // Exit early if no tokens to process
     // Get and remove the first token
     const ForthToken first = tokens.front();
-    const auto file_name = first.value;
+    const std::string file_name(first.value);
     tokens.erase(tokens.begin());
     include_file(file_name);
     loaded_files.clear();
@@ -3002,7 +3264,7 @@ void compileImmediateTICK(std::deque<ForthToken> &tokens) {
 
     tokens.erase(tokens.begin());
     const ForthToken second = tokens.front();
-    const auto word_name = second.value;
+    const std::string word_name(second.value);
     auto &dict = ForthDictionary::instance();
     auto word = dict.findWord(word_name.c_str());
     if (word == nullptr) {
@@ -3011,6 +3273,7 @@ void compileImmediateTICK(std::deque<ForthToken> &tokens) {
     asmjit::x86::Assembler *assembler;
     initialize_assembler(assembler);
     assembler->comment("; -- TICK");
+    JitContext::instance().noteReference(reinterpret_cast<const void *>(word->executable));
     compile_DUP();
     assembler->mov(asmjit::x86::r13, reinterpret_cast<uint64_t>(word->executable));
 }
@@ -3032,7 +3295,7 @@ void runImmediateCREATE(std::deque<ForthToken> &tokens) {
     // Get and remove the first token
     // when creating a new word a new symbol is expected.
     const ForthToken first = tokens.front();
-    if (first.type != TokenType::TOKEN_UNKNOWN) {
+    if (!is_new_name(first)) {
         SignalHandler::instance().raise(11); // Invalid token - raise an error
         return;
     }
@@ -3041,7 +3304,7 @@ void runImmediateCREATE(std::deque<ForthToken> &tokens) {
 
     // Create the dictionary entry WITHOUT setting the executable first
     auto entry = dict.addCodeWord(
-        first.value,
+        std::string(first.value),
         "FORTH",
         ForthState::EXECUTABLE,
         ForthWordType::WORD,
@@ -3060,12 +3323,12 @@ void runImmediateCREATE(std::deque<ForthToken> &tokens) {
     pushDS(asmjit::x86::rax);
     compile_return();
 
-    const auto func = JitContext::instance().finalize();
+    const auto func = JitContext::instance().finalize(entry->getWordName());
     if (!func) {
         SignalHandler::instance().raise(12); // Error finalizing the JIT-compiled function
         return;
     }
-    entry->executable = func;
+    ForthDictionary::instance().setExecutable(entry, func);
 }
 
 
@@ -3075,7 +3338,7 @@ void runImmediateCONSTANT(std::deque<ForthToken> &tokens) {
     // Get and remove the first token
     // when creating a new word a new symbol is expected.
     const ForthToken first = tokens.front();
-    if (first.type != TokenType::TOKEN_UNKNOWN) {
+    if (!is_new_name(first)) {
         SignalHandler::instance().raise(11); // Invalid token - raise an error
         return;
     }
@@ -3085,7 +3348,7 @@ void runImmediateCONSTANT(std::deque<ForthToken> &tokens) {
 
     // Create the dictionary entry WITHOUT setting the executable first
     const auto entry = dict.addCodeWord(
-        first.value,
+        std::string(first.value),
         "FORTH",
         ForthState::EXECUTABLE,
         ForthWordType::CONSTANT,
@@ -3111,7 +3374,7 @@ void runImmediateCONSTANT(std::deque<ForthToken> &tokens) {
     initialize_assembler(assembler);
 
     // Add runtime logic to resolve and push the variable's data pointer from entry->data
-    assembler->commentf("; CONSTANT %s", first.value.c_str());
+    assembler->commentf("; CONSTANT %s", std::string(first.value).c_str());
 
     // Push the constant value
     compile_DUP();
@@ -3121,14 +3384,14 @@ void runImmediateCONSTANT(std::deque<ForthToken> &tokens) {
 
     assembler->ret();
 
-    const auto func = JitContext::instance().finalize();
+    const auto func = JitContext::instance().finalize(entry->getWordName());
     if (!func) {
         SignalHandler::instance().raise(12); // Error finalizing the JIT-compiled function
         return;
     }
 
     // Assign the finalized function to the dictionary entry's executable field
-    entry->executable = func;
+    ForthDictionary::instance().setExecutable(entry, func);
 }
 
 
@@ -3138,7 +3401,7 @@ void runImmediateVARIABLE(std::deque<ForthToken> &tokens) {
     // Get and remove the first token
     // when creating a new word a new symbol is expected.
     const ForthToken first = tokens.front();
-    if (first.type != TokenType::TOKEN_UNKNOWN) {
+    if (!is_new_name(first)) {
         SignalHandler::instance().raise(11); // Invalid token - raise an error
         return;
     }
@@ -3148,7 +3411,7 @@ void runImmediateVARIABLE(std::deque<ForthToken> &tokens) {
 
     // Create the dictionary entry WITHOUT setting the executable first
     const auto entry = dict.addCodeWord(
-        first.value,
+        std::string(first.value),
         "FORTH",
         ForthState::EXECUTABLE,
         ForthWordType::VARIABLE,
@@ -3186,14 +3449,14 @@ void runImmediateVARIABLE(std::deque<ForthToken> &tokens) {
 
     assembler->ret();
 
-    const auto func = JitContext::instance().finalize();
+    const auto func = JitContext::instance().finalize(entry->getWordName());
     if (!func) {
         SignalHandler::instance().raise(12); // Error finalizing the JIT-compiled function
         return;
     }
 
     // Assign the finalized function to the dictionary entry's executable field
-    entry->executable = func;
+    ForthDictionary::instance().setExecutable(entry, func);
 }
 
 // used to allow c to create variable
@@ -3243,14 +3506,14 @@ bool create_variable(const std::string &name, int64_t initialValue) {
     assembler->ret(); // Return from the function
 
     // Finalize the compiled function
-    const auto func = JitContext::instance().finalize();
+    const auto func = JitContext::instance().finalize(entry->getWordName());
     if (!func) {
         SignalHandler::instance().raise(12); // Handle function finalization error
         return false;
     }
 
     // Assign the finalized function to the entry's executable field
-    entry->executable = func;
+    ForthDictionary::instance().setExecutable(entry, func);
 
     return true; // Successfully created the variable
 }
@@ -3302,14 +3565,14 @@ bool create_variable_allot(const std::string &name, size_t byteCount) {
     assembler->ret(); // Return from the function
 
     // Finalize the compiled function
-    const auto func = JitContext::instance().finalize();
+    const auto func = JitContext::instance().finalize(entry->getWordName());
     if (!func) {
         SignalHandler::instance().raise(12); // Handle function finalization error
         return false;
     }
 
     // Assign the finalized function to the entry's executable field
-    entry->executable = func;
+    ForthDictionary::instance().setExecutable(entry, func);
 
     return true; // Successfully created the variable with allotted memory
 }
@@ -3320,7 +3583,7 @@ void runImmediateVAR_AT(std::deque<ForthToken> &tokens) {
     // Get and remove the first token
     const ForthToken &first = tokens.front();
     const auto &dict = ForthDictionary::instance();
-    auto var_word = dict.findWord(first.value.c_str());
+    auto var_word = dict.findWord(first.value);
 
     if (!var_word || var_word->type != ForthWordType::VARIABLE) {
         std::cout << "Error: " << first.value << " is not a variable" << std::endl;
@@ -3330,11 +3593,11 @@ void runImmediateVAR_AT(std::deque<ForthToken> &tokens) {
 
     asmjit::x86::Assembler *assembler;
     initialize_assembler(assembler);
-    assembler->commentf("; %s @ ", first.value.c_str());
+    assembler->commentf("; %s @ ", std::string(first.value).c_str());
     assembler->mov(asmjit::x86::rax, asmjit::imm(address));
     compile_DUP();
     assembler->mov(asmjit::x86::r13, asmjit::x86::ptr(asmjit::x86::rax));
-    assembler->commentf("; TOS holds [%s]", first.value.c_str());
+    assembler->commentf("; TOS holds [%s]", std::string(first.value).c_str());
 }
 
 
@@ -3344,7 +3607,7 @@ void runImmediateVAR_STORE(std::deque<ForthToken> &tokens) {
     // Get and remove the first token
     const ForthToken &first = tokens.front();
     const auto &dict = ForthDictionary::instance();
-    const auto var_word = dict.findWord(first.value.c_str());
+    const auto var_word = dict.findWord(first.value);
 
     if (!var_word || var_word->type != ForthWordType::VARIABLE) {
         std::cout << "Error: " << first.value << " is not a variable" << std::endl;
@@ -3354,7 +3617,7 @@ void runImmediateVAR_STORE(std::deque<ForthToken> &tokens) {
 
     asmjit::x86::Assembler *assembler;
     initialize_assembler(assembler);
-    assembler->commentf("; %s ! ", first.value.c_str());
+    assembler->commentf("; %s ! ", std::string(first.value).c_str());
     assembler->mov(asmjit::x86::rax, asmjit::imm(address));
     assembler->mov(asmjit::x86::ptr(asmjit::x86::rax), asmjit::x86::r13);
     compile_DROP();
@@ -3370,7 +3633,7 @@ void runImmediateCAT_EMIT(std::deque<ForthToken> &tokens) {
     assembler->comment("; -- C@ EMIT");
     assembler->push(asmjit::x86::rdi);
     assembler->mov(asmjit::x86::rdi, asmjit::x86::ptr(asmjit::x86::r13));
-    assembler->call(spit_char);
+    call_out(assembler, spit_char);
     assembler->pop(asmjit::x86::rdi);
     compile_DROP();
 }
@@ -3397,7 +3660,7 @@ void runImmediateDEFER(std::deque<ForthToken> &tokens) {
     // Get and remove the first token
     // when creating a new word a new symbol is expected.
     const ForthToken first = tokens.front();
-    if (first.type != TokenType::TOKEN_UNKNOWN) {
+    if (!is_new_name(first)) {
         SignalHandler::instance().raise(11); // Invalid token - raise an error
         return;
     }
@@ -3406,7 +3669,7 @@ void runImmediateDEFER(std::deque<ForthToken> &tokens) {
 
     // Create the dictionary entry WITHOUT setting the executable first
     dict.addCodeWord(
-        first.value,
+        std::string(first.value),
         "FORTH",
         ForthState::EXECUTABLE,
         ForthWordType::WORD,
@@ -3425,7 +3688,7 @@ void runImmediateIS(std::deque<ForthToken> &tokens) {
     // The first word is the new action
     const ForthToken first = tokens.front();
     tokens.erase(tokens.begin()); // Remove the processed token
-    auto word_name = first.value;
+    std::string word_name(first.value);
     auto &dict = ForthDictionary::instance();
     auto second_word = dict.findWord(word_name.c_str());
     if (!second_word) {
@@ -3466,7 +3729,7 @@ void runImmediateALLOT_TO(std::deque<ForthToken> &tokens) {
     tokens.erase(tokens.begin()); // Remove the processed token
 
     const auto &dict = ForthDictionary::instance();
-    const auto first_word = dict.findWord(first.value.c_str());
+    const auto first_word = dict.findWord(first.value);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3484,9 +3747,11 @@ void display_show_help() {
     std::cout << " chain" << std::endl;
     std::cout << " allot" << std::endl;
     std::cout << " memory" << std::endl;
+    std::cout << " optimizer" << std::endl;
     std::cout << " usage" << std::endl;
     std::cout << " strings" << std::endl;
     std::cout << " stack" << std::endl;
+    std::cout << " timings" << std::endl;
     std::cout << " words_detailed" << std::endl;
 }
 
@@ -3515,7 +3780,7 @@ void runImmediateSHOW(std::deque<ForthToken> &tokens) {
     } else if (thing == "ALLOT" && size == 3) {
         const ForthToken &next_token = tokens.front();
         auto &dict = ForthDictionary::instance();
-        auto first_word = dict.findWord(next_token.value.c_str());
+        auto first_word = dict.findWord(next_token.value);
         if (!first_word) { return; }
         auto id = first_word->getID();
         WordHeap::instance().listAllocation(id);
@@ -3524,8 +3789,15 @@ void runImmediateSHOW(std::deque<ForthToken> &tokens) {
         for (int i = 0; i < 16; i++) {
             dict.displayWordChain(i);
         }
+    } else if (thing == "OPTIMIZER") {
+        Peephole::instance().display();
     } else if (thing == "MEMORY") {
         JitContext::instance().displayAsmJitMemoryUsage();
+    } else if (thing == "TIMINGS") {
+        std::cout << "Startup: "
+                  << std::chrono::duration<double, std::milli>(startupTime).count() << " ms" << std::endl;
+        JitContext::instance().displayBatchStatistics();
+        display_load_timings();
     } else if (thing == "USAGE") {
         JitContext::instance().reportMemoryUsage();
     } else if (thing == "STACK") {
@@ -3549,20 +3821,6 @@ void runImmediateSHOW(std::deque<ForthToken> &tokens) {
 // time word
 
 
-void initializeTimer() {
-    mach_timebase_info_data_t timebase;
-    kern_return_t kr = mach_timebase_info(&timebase);
-    if (kr != KERN_SUCCESS) {
-        std::cerr << "Failed to initialize timer. Error: " << kr << std::endl;
-    }
-    // std::cout << "Timebase info: numer = " << timebase.numer << ", denom = " << timebase.denom << std::endl;
-    // If the values are always 1, this indicates we're natively getting nanoseconds.
-    if (timebase.numer == 1 && timebase.denom == 1) {
-        //std::cout << "mach_absolute_time values are already in nanoseconds." << std::endl;
-    }
-}
-
-
 void displayDuration(uint64_t durationNs) {
     if (durationNs < 1e6) {
         // Case 1: Less than 1 millisecond
@@ -3592,7 +3850,7 @@ void runImmediateTIMEIT(std::deque<ForthToken> &tokens) {
     tokens.erase(tokens.begin()); // Remove the processed token
 
     auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.value.c_str());
+    auto first_word = dict.findWord(first.value);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3601,8 +3859,9 @@ void runImmediateTIMEIT(std::deque<ForthToken> &tokens) {
         std::cout << "Word not executable" << std::endl;
         return;
     }
-    initializeTimer();
-    const uint64_t start_time = mach_absolute_time();
+    auto &counters = PerfCounters::instance();
+    if (hardwareCounters) counters.start();
+    const uint64_t start_time = Benchmark::nanoseconds();
     // Save the value of RBP
     asm volatile(
         "pushq %%rbp" // Push RBP onto the stack
@@ -3617,14 +3876,105 @@ void runImmediateTIMEIT(std::deque<ForthToken> &tokens) {
         : // No inputs
         : "memory" // Inform the compiler that memory is being changed
     );
-    uint64_t end = mach_absolute_time();
+    uint64_t end = Benchmark::nanoseconds();
+    const auto counts = hardwareCounters ? counters.stop() : PerfCounters::Counts{};
     uint64_t durationNs = (end - start_time);
     std::cout << "Duration: ";
     std::cout << std::dec;
     displayDuration(durationNs);
+    if (hardwareCounters) PerfCounters::display(counts, 1);
+}
+
+// BENCH word n, times n batches of calls to a word and prints the statistics
+// a word that changes the depth of the stack is not timed, the batches would overflow the stack
+void runImmediateBENCH(std::deque<ForthToken> &tokens) {
+    if (tokens.empty()) return;
+
+    const ForthToken first = tokens.front();
+    if (first.type != TokenType::TOKEN_WORD) {
+        SignalHandler::instance().raise(11);
+        return;
+    }
+    tokens.erase(tokens.begin());
+
+    size_t samples = Benchmark::DEFAULT_SAMPLES;
+    if (!tokens.empty() && tokens.front().type == TokenType::TOKEN_NUMBER) {
+        samples = static_cast<size_t>(std::max<int64_t>(1, static_cast<int64_t>(tokens.front().int_value)));
+        tokens.erase(tokens.begin());
+    }
+
+    const auto word = ForthDictionary::instance().findWord(first.value);
+    if (!word) {
+        SignalHandler::instance().raise(14);
+        return;
+    }
+    if (word->executable == nullptr) {
+        std::cout << "Word not executable" << std::endl;
+        return;
+    }
+
+    const auto stackDepth = [] { return (static_cast<int64_t>(stack_top) - static_cast<int64_t>(fetchR15())) / 8; };
+    const int64_t before = stackDepth();
+    Benchmark::call(word->executable, 1);
+    const int64_t after = stackDepth();
+    if (after != before) {
+        std::cout << "BENCH: " << first.value << " is unbalanced, stack depth " << before << " -> " << after
+                << ", not timed" << std::endl;
+        return;
+    }
+    // time the tiered code, if the first call made the word hot
+    code_generator_run_pending_tier_ups();
+
+    const auto result = Benchmark::instance().run(word->executable, samples, hardwareCounters);
+    code_generator_run_pending_tier_ups();
+    if (stackDepth() != before) {
+        std::cout << "BENCH: " << first.value << " is unbalanced, stack depth " << before << " -> " << stackDepth()
+                << " after the run" << std::endl;
+    }
+    std::cout << "BENCH " << first.value << ": " << result.samples << " samples of " << result.iterations
+            << " iterations in ";
+    std::cout << std::dec;
+    displayDuration(result.totalNs);
+    Benchmark::display(result);
+    if (hardwareCounters) PerfCounters::display(result.counts, result.iterations * result.samples);
+}
+
+// PROFILE word, runs the word once under the sampling profiler and reports
+void runImmediatePROFILE(std::deque<ForthToken> &tokens) {
+    if (tokens.empty()) return;
+
+    const ForthToken first = tokens.front();
+    if (first.type != TokenType::TOKEN_WORD) {
+        SignalHandler::instance().raise(11);
+        return;
+    }
+    tokens.erase(tokens.begin());
+
+    const auto word = ForthDictionary::instance().findWord(first.value);
+    if (!word) {
+        SignalHandler::instance().raise(14);
+        return;
+    }
+    if (word->executable == nullptr) {
+        std::cout << "Word not executable" << std::endl;
+        return;
+    }
+    Profiler::instance().start();
+    word->executable();
+    Profiler::instance().report();
+}
+
+// PROFILE-START, samples everything run until PROFILE-REPORT
+void runImmediatePROFILE_START(std::deque<ForthToken> &) {
+    Profiler::instance().start();
+}
+
+void runImmediatePROFILE_REPORT(std::deque<ForthToken> &) {
+    Profiler::instance().report();
 }
 
 
+
 // introspection
 
 void runImmediateSEE(std::deque<ForthToken> &tokens) {
@@ -3640,7 +3990,7 @@ void runImmediateSEE(std::deque<ForthToken> &tokens) {
     tokens.erase(tokens.begin()); // Remove the processed token
 
     const auto &dict = ForthDictionary::instance();
-    const auto first_word = dict.findWord(first.value.c_str());
+    const auto first_word = dict.findWord(first.value);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3669,7 +4019,7 @@ void runImmediateADD_IMM(std::deque<ForthToken> &tokens) {
     }
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3694,7 +4044,7 @@ void runImmediateCMP_LT_IMM(std::deque<ForthToken> &tokens) {
     }
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3714,7 +4064,7 @@ void runImmediateCMP_LT_IMM(std::deque<ForthToken> &tokens) {
     assembler->cmp(asmjit::x86::r13, asmjit::imm(first.int_value));
 
     // Set the result (1 for true, 0 for false) into r13
-    assembler->setb(asmjit::x86::al); // Set AL (lower byte of RAX) if "below" (unsigned less than)
+    assembler->setl(asmjit::x86::al); // Set AL (lower byte of RAX) if less, signed like <
     assembler->movzx(asmjit::x86::rax, asmjit::x86::al); // Zero-extend AL into r13 (TOS)
     assembler->neg(asmjit::x86::rax);
 
@@ -3736,7 +4086,7 @@ void runImmediateSUB_IMM(std::deque<ForthToken> &tokens) {
 
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3763,7 +4113,7 @@ void runImmediateCMP_GT_IMM(std::deque<ForthToken> &tokens) {
     }
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3783,7 +4133,7 @@ void runImmediateCMP_GT_IMM(std::deque<ForthToken> &tokens) {
     assembler->cmp(asmjit::x86::r13, asmjit::imm(first.int_value));
 
     // Set AL to 1 if r13 > imm, otherwise 0
-    assembler->seta(asmjit::x86::al); // "Set Above" for unsigned greater than
+    assembler->setg(asmjit::x86::al); // signed greater than, like >
 
     // Move AL to TOS (r13) and extend it into a full register
     assembler->movzx(asmjit::x86::r13, asmjit::x86::al);
@@ -3807,7 +4157,7 @@ void runImmediateCMP_EQ_IMM(std::deque<ForthToken> &tokens) {
     }
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3851,7 +4201,7 @@ void runImmediateSHL_IMM(std::deque<ForthToken> &tokens) {
 
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3880,7 +4230,7 @@ void runImmediateSHR_IMM(std::deque<ForthToken> &tokens) {
 
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3909,7 +4259,7 @@ void runImmediateMUL_IMM(std::deque<ForthToken> &tokens) {
 
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3938,7 +4288,7 @@ void runImmediateDIV_IMM(std::deque<ForthToken> &tokens) {
 
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3980,7 +4330,7 @@ void runImmediateLEA_TOS(std::deque<ForthToken> &tokens) {
 
 
     const auto &dict = ForthDictionary::instance();
-    auto first_word = dict.findWord(first.optimized_op.c_str());
+    auto first_word = dict.findWord(first.optimized_op);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -3993,6 +4343,36 @@ void runImmediateLEA_TOS(std::deque<ForthToken> &tokens) {
     assembler->lea(asmjit::x86::r13, asmjit::x86::ptr(asmjit::x86::r13, asmjit::x86::r13));
 }
 
+void runImmediateMOV_TOS_1(std::deque<ForthToken> &tokens) {
+    if (tokens.empty()) return; // Exit early if no tokens to process
+
+    const ForthToken &first = tokens.front();
+    if (first.type != TokenType::TOKEN_OPTIMIZED) {
+        SignalHandler::instance().raise(11); // Invalid token - raise an error
+        return;
+    }
+
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    //
+    assembler->comment("; Optimized SWAP DROP = NIP, TOS stays, TOS-2 into TOS-1");
+    assembler->mov(asmjit::x86::r12, asmjit::x86::ptr(asmjit::x86::r15));
+    assembler->add(asmjit::x86::r15, 8);
+}
+
+// PEEPHOLE: pattern => replacement, the rest of the line is the rule
+void runImmediatePEEPHOLE(std::deque<ForthToken> &tokens) {
+    std::string rule;
+    while (!tokens.empty() && tokens.front().type != TokenType::TOKEN_END) {
+        if (!rule.empty()) rule += ' ';
+        rule += tokens.front().value;
+        tokens.pop_front();
+    }
+    if (!Peephole::instance().add_rule(rule)) {
+        SignalHandler::instance().raise(11);
+    }
+}
+
 // safer alternative to VOCAB DEFINITIONS
 void runImmediateSETCURRENT(std::deque<ForthToken> &tokens) {
     if (tokens.empty()) return; // Exit early if no tokens to process
@@ -4007,7 +4387,7 @@ void runImmediateSETCURRENT(std::deque<ForthToken> &tokens) {
 
 
     auto &dict = ForthDictionary::instance();
-    const auto first_word = dict.findWord(first.value.c_str());
+    const auto first_word = dict.findWord(first.value);
     if (!first_word) {
         SignalHandler::instance().raise(14); // Invalid token - raise an error
         return;
@@ -4099,7 +4479,7 @@ void runImmediateLIT_VAR_Store(std::deque<ForthToken> &tokens) {
         return;
     }
 
-    const auto varname = first.value;
+    const std::string varname(first.value);
     const auto &dict = ForthDictionary::instance();
     const auto first_word = dict.findWord(varname.c_str());
     if (!first_word) {
@@ -4134,7 +4514,7 @@ void runImmediateVAR_AT_TOR(std::deque<ForthToken> &tokens) {
         return;
     }
 
-    const auto varname = first.value;
+    const std::string varname(first.value);
     const auto &dict = ForthDictionary::instance();
     auto first_word = dict.findWord(varname.c_str());
     if (!first_word) {
@@ -4161,7 +4541,7 @@ void runImmediateVAR_TOR(std::deque<ForthToken> &tokens) {
         return;
     }
 
-    const auto varname = first.value;
+    const std::string varname(first.value);
     const auto &dict = ForthDictionary::instance();
     auto first_word = dict.findWord(varname.c_str());
     if (!first_word) {
@@ -4204,6 +4584,108 @@ void Forget() {
     dict.forgetLastWord();
 }
 
+// A MARKER word only records itself here, the rollback runs once it has returned,
+// so no code is released while it is still executing.
+static const ForthDictionaryEntry *pendingMarker = nullptr;
+
+static void marker_request(const ForthDictionaryEntry *marker) {
+    pendingMarker = marker;
+}
+
+void code_generator_run_pending_marker() {
+    if (!pendingMarker) return;
+    const auto marker = pendingMarker;
+    pendingMarker = nullptr;
+    ForthDictionary::instance().forgetTo(marker);
+}
+
+// A word that became hot only queues itself, it is recompiled once the interpreter
+// has its result, never while it or its caller is being run or compiled.
+static std::vector<TierProfile *> pendingTierUps;
+
+static void tier_request(TierProfile *profile) {
+    profile->counters.limit = UINT64_MAX; // ask once
+    profile->pending = true;
+    pendingTierUps.push_back(profile);
+}
+
+void code_generator_run_pending_tier_ups() {
+    while (!pendingTierUps.empty()) {
+        TierProfile *profile = pendingTierUps.back();
+        pendingTierUps.pop_back();
+        profile->pending = false;
+        if (!profile->entry) {
+            delete profile; // forgotten while it waited
+            continue;
+        }
+        Compiler::instance().recompile(*profile);
+    }
+}
+
+// prologue: count the call, ask for a recompile when calls + loop iterations reach the limit
+void code_generator_count_calls(TierProfile *profile) {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    countedProfile = profile;
+    profile->counters.limit = tierLimit > 0 ? static_cast<uint64_t>(tierLimit) : 1;
+
+    const asmjit::Label cold = assembler->newLabel();
+    assembler->comment("; -- count call");
+    assembler->mov(asmjit::x86::rax, asmjit::imm(&profile->counters));
+    assembler->mov(asmjit::x86::rcx, asmjit::x86::qword_ptr(asmjit::x86::rax, offsetof(TierCounters, calls)));
+    assembler->add(asmjit::x86::rcx, 1);
+    assembler->mov(asmjit::x86::qword_ptr(asmjit::x86::rax, offsetof(TierCounters, calls)), asmjit::x86::rcx);
+    assembler->add(asmjit::x86::rcx, asmjit::x86::qword_ptr(asmjit::x86::rax, offsetof(TierCounters, loops)));
+    assembler->cmp(asmjit::x86::rcx, asmjit::x86::qword_ptr(asmjit::x86::rax, offsetof(TierCounters, limit)));
+    assembler->jb(cold);
+    assembler->push(asmjit::x86::rdi);
+    assembler->mov(asmjit::x86::rdi, asmjit::imm(profile));
+    call_out(assembler, tier_request);
+    assembler->pop(asmjit::x86::rdi);
+    assembler->bind(cold);
+}
+
+// MARKER name, running name forgets name and every word defined after it
+void runImmediateMARKER(std::deque<ForthToken> &tokens) {
+    if (tokens.empty()) return; // Exit early if no tokens to process
+
+    // when creating a new word a new symbol is expected.
+    const ForthToken first = tokens.front();
+    if (!is_new_name(first)) {
+        SignalHandler::instance().raise(11); // Invalid token - raise an error
+        return;
+    }
+    tokens.erase(tokens.begin()); // Remove the processed token
+
+    auto &dict = ForthDictionary::instance();
+    const auto entry = dict.addCodeWord(
+        std::string(first.value),
+        dict.getCurrentVocabularyName(),
+        ForthState::EXECUTABLE,
+        ForthWordType::WORD,
+        nullptr,
+        nullptr,
+        nullptr);
+
+    code_generator_startFunction("NEW_MARKER");
+
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->commentf("; MARKER %s", std::string(first.value).c_str());
+    assembler->push(asmjit::x86::rdi);
+    assembler->mov(asmjit::x86::rdi, asmjit::imm(entry->getAddress()));
+    call_out(assembler, marker_request);
+    assembler->pop(asmjit::x86::rdi);
+    compile_return();
+
+    const auto func = code_generator_finalizeFunction("NEW_MARKER");
+    if (!func) {
+        SignalHandler::instance().raise(12);
+        return;
+    }
+    ForthDictionary::instance().setExecutable(entry, func);
+}
+
 
 // words run immediately by the compiler to generate code.
 
@@ -4218,6 +4700,13 @@ void code_generator_add_immediate_words() {
                      Forget,
                      nullptr);
 
+    dict.addCodeWord("MARKER", "FORTH",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::WORD,
+                     nullptr,
+                     nullptr,
+                     runImmediateMARKER);
+
 
     dict.addCodeWord("SETCURRENT", "FORTH",
                      ForthState::IMMEDIATE,
@@ -4310,6 +4799,20 @@ void code_generator_add_immediate_words() {
                      nullptr,
                      runImmediateLEA_TOS);
 
+    dict.addCodeWord("MOV_TOS_1", "FRAGMENTS",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::MACRO,
+                     nullptr,
+                     nullptr,
+                     runImmediateMOV_TOS_1);
+
+    dict.addCodeWord("PEEPHOLE:", "FORTH",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::WORD,
+                     nullptr,
+                     nullptr,
+                     runImmediatePEEPHOLE);
+
     dict.addCodeWord("DIV_IMM", "FRAGMENTS",
                      ForthState::IMMEDIATE,
                      ForthWordType::MACRO,
@@ -4392,50 +4895,82 @@ void code_generator_add_immediate_words() {
                      runImmediateTIMEIT);
 
 
-    dict.addCodeWord("SHOW", "FORTH",
+    dict.addCodeWord("BENCH", "FORTH",
                      ForthState::IMMEDIATE,
                      ForthWordType::WORD,
                      nullptr,
                      nullptr,
-                     runImmediateSHOW);
+                     runImmediateBENCH);
 
 
-    dict.addCodeWord("SEE", "FORTH",
+    dict.addCodeWord("PROFILE", "FORTH",
                      ForthState::IMMEDIATE,
                      ForthWordType::WORD,
                      nullptr,
                      nullptr,
-                     runImmediateSEE);
+                     runImmediatePROFILE);
 
-    dict.addCodeWord("ALLOT", "FORTH",
+
+    dict.addCodeWord("PROFILE-START", "FORTH",
                      ForthState::IMMEDIATE,
                      ForthWordType::WORD,
                      nullptr,
-                     latest_word_allot_data,
-                     nullptr);
+                     nullptr,
+                     runImmediatePROFILE_START);
 
 
-    dict.addCodeWord("ALLOT>", "FORTH",
+    dict.addCodeWord("PROFILE-REPORT", "FORTH",
                      ForthState::IMMEDIATE,
                      ForthWordType::WORD,
                      nullptr,
                      nullptr,
-                     runImmediateALLOT_TO);
+                     runImmediatePROFILE_REPORT);
 
 
-    dict.addCodeWord("CREATE", "FORTH",
+    dict.addCodeWord("SHOW", "FORTH",
                      ForthState::IMMEDIATE,
                      ForthWordType::WORD,
                      nullptr,
                      nullptr,
-                     runImmediateCREATE);
+                     runImmediateSHOW);
 
-    dict.addCodeWord("VARIABLE", "FORTH",
+
+    dict.addCodeWord("SEE", "FORTH",
                      ForthState::IMMEDIATE,
                      ForthWordType::WORD,
                      nullptr,
                      nullptr,
-                     runImmediateVARIABLE
+                     runImmediateSEE);
+
+    dict.addCodeWord("ALLOT", "FORTH",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::WORD,
+                     nullptr,
+                     latest_word_allot_data,
+                     nullptr);
+
+
+    dict.addCodeWord("ALLOT>", "FORTH",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::WORD,
+                     nullptr,
+                     nullptr,
+                     runImmediateALLOT_TO);
+
+
+    dict.addCodeWord("CREATE", "FORTH",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::WORD,
+                     nullptr,
+                     nullptr,
+                     runImmediateCREATE);
+
+    dict.addCodeWord("VARIABLE", "FORTH",
+                     ForthState::IMMEDIATE,
+                     ForthWordType::WORD,
+                     nullptr,
+                     nullptr,
+                     runImmediateVARIABLE
     );
 
 
@@ -4531,7 +5066,7 @@ static void compile_DotString(std::deque<ForthToken> &tokens) {
     assembler->comment("; -- address of interned string");
     assembler->mov(asmjit::x86::rdi, asmjit::imm(addr1));
     assembler->comment("; call spit string ");
-    assembler->call(spit_str);
+    call_out(assembler, spit_str);
     assembler->pop(asmjit::x86::rdi); // Pop TOS off the stack
 }
 
@@ -4640,7 +5175,7 @@ static void compile_KEY() {
     initialize_assembler(assembler);
     assembler->comment("; -- KEY ");
     assembler->push(asmjit::x86::rdi);
-    assembler->call(slurp_char);
+    call_out(assembler, slurp_char);
     assembler->pop(asmjit::x86::rdi);
     compile_DUP();
     assembler->mov(asmjit::x86::r13, asmjit::x86::rax);
@@ -4679,7 +5214,7 @@ static void compile_EMIT() {
     assembler->push(asmjit::x86::rdi); // Push TOS onto the stack
     assembler->mov(asmjit::x86::rdi, asmjit::x86::r13); // TOS
     assembler->comment("; call spit_char");
-    assembler->call(spit_char);
+    call_out(assembler, spit_char);
     assembler->pop(asmjit::x86::rdi); // Pop TOS off the stack
 
     assembler->mov(asmjit::x86::r13, asmjit::x86::r12); // Move TOS-1 into TOS
@@ -4698,7 +5233,7 @@ static void compile_CR() {
     assembler->push(asmjit::x86::rdi); // Push TOS onto the stack
     assembler->mov(asmjit::x86::rdi, asmjit::x86::r13); // TOS
     assembler->comment("; call spit end line (CR)");
-    assembler->call(spit_end_line);
+    call_out(assembler, spit_end_line);
     assembler->pop(asmjit::x86::rdi); // Pop TOS off the stack
 }
 
@@ -4713,7 +5248,7 @@ static void compile_SPACE() {
     assembler->push(asmjit::x86::rdi); // Push TOS onto the stack
     assembler->mov(asmjit::x86::rdi, asmjit::imm(32)); // TOS
     assembler->comment("; call spit_char with space ");
-    assembler->call(spit_char);
+    call_out(assembler, spit_char);
     assembler->pop(asmjit::x86::rdi); // Pop TOS off the stack
 }
 
@@ -4727,7 +5262,7 @@ static void compile_CLS() {
     assembler->push(asmjit::x86::rdi); // Push TOS onto the stack
     assembler->mov(asmjit::x86::rdi, asmjit::imm(32)); // TOS
     assembler->comment("; send clear screen esc c");
-    assembler->call(spit_cls);
+    call_out(assembler, spit_cls);
     assembler->pop(asmjit::x86::rdi); // Pop TOS off the stack
 }
 
@@ -4742,7 +5277,7 @@ static void compile_PAGE() {
     assembler->push(asmjit::x86::rdi); // Push TOS onto the stack
     assembler->mov(asmjit::x86::rdi, asmjit::imm(12)); // TOS
     assembler->comment("; call spit_char with page (12) ");
-    assembler->call(spit_char);
+    call_out(assembler, spit_char);
     assembler->pop(asmjit::x86::rdi); // Pop TOS off the stack
 
     assembler->mov(asmjit::x86::r13, asmjit::x86::r12); // Move TOS-1 into TOS
@@ -4797,7 +5332,7 @@ static void compile_ZTYPE() {
 
     assembler->push(asmjit::x86::rsi);
     assembler->movzx(asmjit::x86::rdi, asmjit::x86::al);
-    assembler->call(spit_char);
+    call_out(assembler, spit_char);
     assembler->pop(asmjit::x86::rsi);
 
     // Increment RSI (move to the next character in the string)
@@ -4894,7 +5429,7 @@ void code_generator_add_io_words() {
     //                  ForthState::EXECUTABLE,
     //                  ForthWordType::WORD,
     //                  static_cast<ForthFunction>(&compile_DOT),
-    //                  code_generator_build_forth(compile_DOT),
+    //                  code_generator_build_forth(compile_DOT, "."),
     //                  nullptr);
 
 
@@ -4902,21 +5437,21 @@ void code_generator_add_io_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_SPACE),
-                     code_generator_build_forth(compile_SPACE),
+                     code_generator_build_forth(compile_SPACE, "SPACE"),
                      nullptr);
 
     dict.addCodeWord("(PAGE)", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_PAGE),
-                     code_generator_build_forth(compile_PAGE),
+                     code_generator_build_forth(compile_PAGE, "(PAGE)"),
                      nullptr);
 
     // dict.addCodeWord("COUNT", "FORTH",
     //                  ForthState::EXECUTABLE,
     //                  ForthWordType::WORD,
     //                  static_cast<ForthFunction>(&compile_COUNT),
-    //                  code_generator_build_forth(compile_COUNT),
+    //                  code_generator_build_forth(compile_COUNT, "COUNT"),
     //                  nullptr);
 
 
@@ -4924,35 +5459,35 @@ void code_generator_add_io_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_ZTYPE),
-                     code_generator_build_forth(compile_ZTYPE),
+                     code_generator_build_forth(compile_ZTYPE, "ZTYPE"),
                      nullptr);
 
     dict.addCodeWord("CLS", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_CLS),
-                     code_generator_build_forth(compile_CLS),
+                     code_generator_build_forth(compile_CLS, "CLS"),
                      nullptr);
 
     dict.addCodeWord("CR", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_CR),
-                     code_generator_build_forth(compile_CR),
+                     code_generator_build_forth(compile_CR, "CR"),
                      nullptr);
 
     dict.addCodeWord("EMIT", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_EMIT),
-                     code_generator_build_forth(compile_EMIT),
+                     code_generator_build_forth(compile_EMIT, "EMIT"),
                      nullptr);
 
     dict.addCodeWord("KEY", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_KEY),
-                     code_generator_build_forth(compile_KEY),
+                     code_generator_build_forth(compile_KEY, "KEY"),
                      nullptr);
 
     // accept using c hosted terminal line reader.
@@ -4981,7 +5516,7 @@ ForthFunction execDEFINITIONS() {
     }
     // entry->display();
     ForthDictionary::instance().setVocabulary(entry);
-    ForthDictionary::instance().setVocabulary(SymbolTable::instance().getSymbol(entry->id));
+    ForthDictionary::instance().setVocabulary(std::string(SymbolTable::instance().getSymbol(entry->word_id)));
 
     return nullptr;
 }
@@ -5016,6 +5551,32 @@ static void genExit() {
 
 static void genLeave();
 
+// Compare-and-branch fusion: a comparison right before IF, WHILE or UNTIL only sets the
+// flags, and the branch jumps on them instead of testing a flag popped off the stack.
+enum class BranchCondition { NONE, EQ, NE, LT, GT, LE };
+
+static BranchCondition pendingBranch = BranchCondition::NONE;
+
+// jump to target when the pending comparison is false, false if there is none
+static bool jump_unless_pending(asmjit::x86::Assembler *assembler, const asmjit::Label &target) {
+    const BranchCondition condition = pendingBranch;
+    pendingBranch = BranchCondition::NONE;
+    switch (condition) {
+        case BranchCondition::EQ: assembler->jne(target);
+            return true;
+        case BranchCondition::NE: assembler->je(target);
+            return true;
+        case BranchCondition::LT: assembler->jge(target);
+            return true;
+        case BranchCondition::GT: assembler->jle(target);
+            return true;
+        case BranchCondition::LE: assembler->jg(target);
+            return true;
+        default:
+            return false;
+    }
+}
+
 
 static void genDo() {
     asmjit::x86::Assembler *assembler;
@@ -5023,6 +5584,14 @@ static void genDo() {
     assembler->comment("; -- DO (start of LOOP)");
     assembler->comment("; -- ");
 
+    const bool inRegisters = planDoLoopInRegisters;
+    planDoLoopInRegisters = false;
+    if (inRegisters) {
+        assembler->comment("; -- index in r10, limit in r11");
+        assembler->mov(asmjit::x86::r10, asmjit::x86::r13);
+        assembler->mov(asmjit::x86::r11, asmjit::x86::r12);
+    }
+
     Compile_2toR(); // move loop,index to RS
 
     // Increment the DO loop depth counter
@@ -5037,7 +5606,10 @@ static void genDo() {
     doLoopLabel.loopLabel = assembler->newLabel();
     doLoopLabel.leaveLabel = assembler->newLabel();
     doLoopLabel.hasLeave = false;
+    doLoopLabel.inRegisters = inRegisters;
+    doLoopInRegisters = inRegisters;
     assembler->bind(doLoopLabel.doLabel);
+    count_loop_iteration(assembler);
 
     // Create a LoopLabel struct and push it onto the unified loopStack
     LoopLabel loopLabel;
@@ -5064,22 +5636,28 @@ static void genLoop() {
 
     const auto &loopLabel = std::get<DoLoopLabel>(loopLabelVariant.label);
 
-    assembler->comment("; -- LOOP index=rcx, limit=rdx");
-
     asmjit::x86::Gp currentIndex = asmjit::x86::rcx; // Current index
     asmjit::x86::Gp limit = asmjit::x86::rdx; // Limit
 
-    popRS(currentIndex);
-    popRS(limit);
-    assembler->comment("; Push limit back");
-    pushRS(limit);
-
-    assembler->comment("; Increment index");
-    assembler->add(currentIndex, 1);
-
-    // Push the updated index back onto RS
-    assembler->comment("; Push index back");
-    pushRS(currentIndex);
+    if (loopLabel.inRegisters) {
+        assembler->comment("; -- LOOP index=r10, limit=r11");
+        currentIndex = asmjit::x86::r10;
+        limit = asmjit::x86::r11;
+        assembler->add(currentIndex, 1);
+    } else {
+        assembler->comment("; -- LOOP index=rcx, limit=rdx");
+        popRS(currentIndex);
+        popRS(limit);
+        assembler->comment("; Push limit back");
+        pushRS(limit);
+
+        assembler->comment("; Increment index");
+        assembler->add(currentIndex, 1);
+
+        // Push the updated index back onto RS
+        assembler->comment("; Push index back");
+        pushRS(currentIndex);
+    }
 
     assembler->comment("; compare index, limit");
     // Check if current index is less than limit
@@ -5103,6 +5681,7 @@ static void genLoop() {
 
     // Decrement the DO loop depth counter
     doLoopDepth--;
+    doLoopInRegisters = false; // only innermost loops use the registers
 }
 
 static void genPlusLoop() {
@@ -5120,23 +5699,31 @@ static void genPlusLoop() {
         throw std::runtime_error("gen_loop: Current loop is not a DO loop");
 
     const auto &loopLabel = std::get<DoLoopLabel>(loopLabelVariant.label);
-    assembler->comment("; -- LOOP index=rcx, limit=rdx");
 
     asmjit::x86::Gp currentIndex = asmjit::x86::rcx; // Current index
     asmjit::x86::Gp limit = asmjit::x86::rdx; // Limit
 
-    popRS(currentIndex);
-    popRS(limit);
-    assembler->comment("; Push limit back");
-    pushRS(limit);
-
-    assembler->comment("; Increment index");
-    assembler->add(currentIndex, asmjit::x86::r13); // TOS
-    compile_DROP();
-
-    // Push the updated index back onto RS
-    assembler->comment("; Push index back");
-    pushRS(currentIndex);
+    if (loopLabel.inRegisters) {
+        assembler->comment("; -- +LOOP index=r10, limit=r11");
+        currentIndex = asmjit::x86::r10;
+        limit = asmjit::x86::r11;
+        assembler->add(currentIndex, asmjit::x86::r13); // TOS
+        compile_DROP();
+    } else {
+        assembler->comment("; -- +LOOP index=rcx, limit=rdx");
+        popRS(currentIndex);
+        popRS(limit);
+        assembler->comment("; Push limit back");
+        pushRS(limit);
+
+        assembler->comment("; Increment index");
+        assembler->add(currentIndex, asmjit::x86::r13); // TOS
+        compile_DROP();
+
+        // Push the updated index back onto RS
+        assembler->comment("; Push index back");
+        pushRS(currentIndex);
+    }
 
     assembler->comment("; compare index, limit");
     // Check if current index is less than limit
@@ -5158,6 +5745,7 @@ static void genPlusLoop() {
 
     // Decrement the DO loop depth counter
     doLoopDepth--;
+    doLoopInRegisters = false; // only innermost loops use the registers
 }
 
 
@@ -5173,7 +5761,11 @@ static void genI() {
     // Load the innermost loop index (top of the RS)
     assembler->comment("; -- making room");
     compile_DUP();
-    assembler->mov(asmjit::x86::r13, asmjit::x86::ptr(asmjit::x86::r14));
+    if (doLoopInRegisters) {
+        assembler->mov(asmjit::x86::r13, asmjit::x86::r10);
+    } else {
+        assembler->mov(asmjit::x86::r13, asmjit::x86::ptr(asmjit::x86::r14));
+    }
     assembler->comment("; -- I index to TOS");
 }
 
@@ -5286,6 +5878,7 @@ static void genBegin() {
 
     assembler->comment("; LABEL for BEGIN");
     assembler->bind(beginLabel.beginLabel);
+    count_loop_iteration(assembler);
 
     // Push the new label struct onto the unified stack
     loopStack.push({BEGIN_AGAIN_REPEAT_UNTIL, beginLabel});
@@ -5304,12 +5897,14 @@ static void genUntil() {
     // Get the label from the unified stack
     const auto &beginLabels = std::get<BeginAgainRepeatUntilLabel>(loopStack.top().label);
 
-    asmjit::x86::Gp topOfStack = asmjit::x86::rax;
-    popDS(topOfStack);
+    if (!jump_unless_pending(assembler, beginLabels.beginLabel)) {
+        asmjit::x86::Gp topOfStack = asmjit::x86::rax;
+        popDS(topOfStack);
 
-    assembler->comment("; Jump back if zero");
-    assembler->test(topOfStack, topOfStack);
-    assembler->jz(beginLabels.beginLabel);
+        assembler->comment("; Jump back if zero");
+        assembler->test(topOfStack, topOfStack);
+        assembler->jz(beginLabels.beginLabel);
+    }
 
     assembler->comment("; LABEL for REPEAT/UNTIL");
     // Bind the appropriate labels
@@ -5385,13 +5980,15 @@ static void genWhile() {
     assembler->comment("; -- WHILE ");
 
     auto beginLabel = std::get<BeginAgainRepeatUntilLabel>(loopStack.top().label);
-    asmjit::x86::Gp topOfStack = asmjit::x86::rax;
-    popDS(topOfStack);
-
-    assembler->comment("; check if zero");
-    assembler->test(topOfStack, topOfStack);
-    assembler->comment("; if zero jump past REPEAT");
-    assembler->jz(beginLabel.whileLabel);
+    if (!jump_unless_pending(assembler, beginLabel.whileLabel)) {
+        asmjit::x86::Gp topOfStack = asmjit::x86::rax;
+        popDS(topOfStack);
+
+        assembler->comment("; check if zero");
+        assembler->test(topOfStack, topOfStack);
+        assembler->comment("; if zero jump past REPEAT");
+        assembler->jz(beginLabel.whileLabel);
+    }
     assembler->comment("; WHILE body --- start ");
 }
 
@@ -5404,15 +6001,27 @@ static void genRedo() {
     labels.jmp(*assembler, "enter_function");
 }
 
+// RECURSE in tail position, reuse this activation
+bool compile_tail_recurse() {
+    if (doLoopDepth > 0) return false;
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->comment("; -- RECURSE (tail, jump to start of word) ");
+    labels.jmp(*assembler, "enter_function");
+    return true;
+}
+
 // recursion
 static void genRecurse() {
     asmjit::x86::Assembler *assembler;
     initialize_assembler(assembler);
     assembler->comment("; -- RECURSE ");
     // Generate a call to the entry label (self-recursion)
+    spill_loop_registers(assembler);
     assembler->push(asmjit::x86::rdi);
     labels.call(*assembler, "enter_function");
     assembler->pop(asmjit::x86::rdi);
+    reload_loop_registers(assembler);
 }
 
 static void genIf() {
@@ -5432,6 +6041,7 @@ static void genIf() {
     loopStack.push({IF_THEN_ELSE, branches});
 
     assembler->comment("; -- IF ");
+    if (jump_unless_pending(assembler, branches.ifLabel)) return;
 
     // Pop the condition flag from the data stack
     asmjit::x86::Gp flag = asmjit::x86::rax;
@@ -5491,6 +6101,242 @@ static void genThen() {
     }
 }
 
+// CASE ... x OF ... ENDOF ... ENDCASE
+// With the optimizer on, a CASE whose OF keys are all literals (or constants) is dispatched
+// once, at CASE: a bounds check and an indirect jump through a table when the keys are
+// dense, else a binary search of compares. Other CASEs test each OF in turn.
+static constexpr size_t CASE_TABLE_MINIMUM = 4; // fewer keys compare faster than a table
+
+static void compare_case_key(asmjit::x86::Assembler *assembler, const int64_t key) {
+    if (key >= INT32_MIN && key <= INT32_MAX) {
+        assembler->cmp(asmjit::x86::r13, asmjit::imm(key));
+    } else {
+        assembler->mov(asmjit::x86::rax, asmjit::imm(key));
+        assembler->cmp(asmjit::x86::r13, asmjit::x86::rax);
+    }
+}
+
+// binary search over sorted keys [lo, hi), short ranges are compared in turn
+static void compile_case_tree(asmjit::x86::Assembler *assembler,
+                              const std::vector<std::pair<int64_t, asmjit::Label> > &keys,
+                              const size_t lo, const size_t hi, const asmjit::Label &otherwise) {
+    if (hi - lo <= 3) {
+        for (size_t i = lo; i < hi; i++) {
+            compare_case_key(assembler, keys[i].first);
+            assembler->je(keys[i].second);
+        }
+        assembler->jmp(otherwise);
+        return;
+    }
+    const size_t mid = lo + (hi - lo) / 2;
+    const asmjit::Label below = assembler->newLabel();
+    compare_case_key(assembler, keys[mid].first);
+    assembler->je(keys[mid].second);
+    assembler->jl(below);
+    compile_case_tree(assembler, keys, mid + 1, hi, otherwise);
+    assembler->bind(below);
+    compile_case_tree(assembler, keys, lo, mid, otherwise);
+}
+
+// selector in TOS, jump to the arm of the first OF with its key, or to the default
+static void compile_case_dispatch(asmjit::x86::Assembler *assembler, CaseLabel &caseLabel,
+                                  const std::vector<int64_t> &keys) {
+    std::vector<std::pair<int64_t, asmjit::Label> > sorted;
+    for (size_t i = 0; i < keys.size(); i++) {
+        caseLabel.armLabels.push_back(assembler->newLabel());
+        sorted.emplace_back(keys[i], caseLabel.armLabels.back());
+    }
+    caseLabel.defaultLabel = assembler->newLabel();
+
+    // a repeated key can only ever select its first OF
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                             [](const auto &a, const auto &b) { return a.first == b.first; }),
+                 sorted.end());
+
+    const int64_t low = sorted.front().first;
+    const uint64_t range = static_cast<uint64_t>(sorted.back().first) - static_cast<uint64_t>(low);
+    if (sorted.size() < CASE_TABLE_MINIMUM || range >= 2 * sorted.size()) {
+        assembler->commentf("; -- CASE compare tree, %zu keys", sorted.size());
+        compile_case_tree(assembler, sorted, 0, sorted.size(), caseLabel.defaultLabel);
+        return;
+    }
+
+    assembler->commentf("; -- CASE jump table, %zu keys from %lld, %llu entries",
+                        sorted.size(), static_cast<long long>(low), static_cast<unsigned long long>(range + 1));
+    assembler->mov(asmjit::x86::rax, asmjit::x86::r13);
+    if (low >= INT32_MIN && low <= INT32_MAX) {
+        if (low != 0) assembler->sub(asmjit::x86::rax, asmjit::imm(low));
+    } else {
+        assembler->mov(asmjit::x86::rcx, asmjit::imm(low));
+        assembler->sub(asmjit::x86::rax, asmjit::x86::rcx);
+    }
+    assembler->cmp(asmjit::x86::rax, asmjit::imm(range));
+    assembler->ja(caseLabel.defaultLabel);
+    const asmjit::Label table = assembler->newLabel();
+    assembler->lea(asmjit::x86::rcx, asmjit::x86::ptr(table));
+    assembler->jmp(asmjit::x86::ptr(asmjit::x86::rcx, asmjit::x86::rax, 3));
+
+    assembler->align(asmjit::AlignMode::kData, 8);
+    assembler->bind(table);
+    size_t next = 0;
+    for (uint64_t slot = 0; slot <= range; slot++) {
+        if (static_cast<uint64_t>(sorted[next].first) - static_cast<uint64_t>(low) == slot) {
+            assembler->embedLabel(sorted[next++].second);
+        } else {
+            assembler->embedLabel(caseLabel.defaultLabel);
+        }
+    }
+}
+
+static void genCase() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->comment("; -- CASE ");
+
+    CaseLabel caseLabel;
+    caseLabel.end_case_label = assembler->newLabel();
+    if (!plannedCaseKeys.empty()) {
+        caseLabel.keyed = true;
+        compile_case_dispatch(assembler, caseLabel, plannedCaseKeys);
+        plannedCaseKeys.clear();
+    }
+    loopStack.push({CASE_CONTROL, caseLabel});
+}
+
+static void genOf() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    if (loopStack.empty() || loopStack.top().type != CASE_CONTROL) {
+        throw std::runtime_error("genOf: No matching CASE structure on the stack");
+    }
+    auto &caseLabel = std::get<CaseLabel>(loopStack.top().label);
+    assembler->comment("; -- OF ");
+
+    if (caseLabel.keyed) {
+        if (static_cast<size_t>(caseLabel.ofCount) >= caseLabel.armLabels.size()) {
+            throw std::runtime_error("genOf: More OFs than the CASE was planned with");
+        }
+        assembler->bind(caseLabel.armLabels[caseLabel.ofCount]);
+    } else {
+        // ( x1 x2 -- | x1 ) drop x2, then x1 too if they were equal
+        caseLabel.endOfLabels.push_back(assembler->newLabel());
+        assembler->cmp(asmjit::x86::r12, asmjit::x86::r13);
+        assembler->mov(asmjit::x86::r13, asmjit::x86::r12);
+        assembler->mov(asmjit::x86::r12, asmjit::x86::ptr(asmjit::x86::r15));
+        assembler->lea(asmjit::x86::r15, asmjit::x86::ptr(asmjit::x86::r15, 8));
+        assembler->jne(caseLabel.endOfLabels.back());
+    }
+    caseLabel.ofCount++;
+    compile_DROP();
+}
+
+static void genEndOf() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    if (loopStack.empty() || loopStack.top().type != CASE_CONTROL) {
+        throw std::runtime_error("genEndOf: No matching CASE structure on the stack");
+    }
+    auto &caseLabel = std::get<CaseLabel>(loopStack.top().label);
+    assembler->comment("; -- ENDOF ");
+    assembler->jmp(caseLabel.end_case_label);
+
+    if (caseLabel.keyed) {
+        if (static_cast<size_t>(caseLabel.ofCount) == caseLabel.armLabels.size() && !caseLabel.defaultBound) {
+            assembler->comment("; LABEL for CASE default");
+            assembler->bind(caseLabel.defaultLabel);
+            caseLabel.defaultBound = true;
+        }
+    } else if (!caseLabel.endOfLabels.empty()) {
+        assembler->bind(caseLabel.endOfLabels.back());
+    }
+}
+
+static void genEndCase() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    if (loopStack.empty() || loopStack.top().type != CASE_CONTROL) {
+        throw std::runtime_error("genEndCase: No matching CASE structure on the stack");
+    }
+    const auto caseLabel = std::get<CaseLabel>(loopStack.top().label);
+    loopStack.pop();
+
+    assembler->comment("; -- ENDCASE ");
+    if (caseLabel.keyed && !caseLabel.defaultBound) {
+        assembler->bind(caseLabel.defaultLabel);
+    }
+    compile_DROP(); // the selector, no OF matched
+    assembler->comment("; LABEL for ENDCASE");
+    assembler->bind(caseLabel.end_case_label);
+}
+
+// Compiles a comparison followed by IF, WHILE or UNTIL as cmp and a conditional jump.
+// Only the comparison is compiled here, it leaves the flags for the branch word.
+bool code_generator_compare_and_branch(const ForthToken &compare, const ForthToken &branch) {
+    const auto &dict = ForthDictionary::instance();
+    if (branch.type != TokenType::TOKEN_WORD) return false;
+    const auto branchWord = dict.findWord(branch.value);
+    if (!branchWord || (branchWord->generator != static_cast<ForthFunction>(&genIf)
+                        && branchWord->generator != static_cast<ForthFunction>(&genWhile)
+                        && branchWord->generator != static_cast<ForthFunction>(&genUntil))) {
+        return false;
+    }
+
+    enum { TWO_CELLS, LITERAL, ZERO } operands = TWO_CELLS;
+    BranchCondition condition = BranchCondition::NONE;
+    const auto literal = static_cast<int64_t>(compare.int_value);
+
+    if (compare.type == TokenType::TOKEN_OPTIMIZED) {
+        if (literal < INT32_MIN || literal > INT32_MAX) return false;
+        operands = LITERAL;
+        if (compare.optimized_op == "CMP_LT_IMM") condition = BranchCondition::LT;
+        else if (compare.optimized_op == "CMP_GT_IMM") condition = BranchCondition::GT;
+        else if (compare.optimized_op == "CMP_EQ_IMM") condition = BranchCondition::EQ;
+    } else if (compare.type == TokenType::TOKEN_WORD) {
+        const auto word = dict.findWord(compare.value);
+        const ForthFunction generator = word ? word->generator : nullptr;
+        if (generator == static_cast<ForthFunction>(&compile_EQ)) condition = BranchCondition::EQ;
+        else if (generator == static_cast<ForthFunction>(&compile_NEQ)) condition = BranchCondition::NE;
+        else if (generator == static_cast<ForthFunction>(&compile_LT)) condition = BranchCondition::LT;
+        else if (generator == static_cast<ForthFunction>(&compile_GT)) condition = BranchCondition::GT;
+        else if (generator == static_cast<ForthFunction>(&compile_LE)) condition = BranchCondition::LE;
+        else {
+            operands = ZERO;
+            if (generator == static_cast<ForthFunction>(&compile_ZERO_EQ)) condition = BranchCondition::EQ;
+            else if (generator == static_cast<ForthFunction>(&compile_ZERO_NEQ)) condition = BranchCondition::NE;
+            else if (generator == static_cast<ForthFunction>(&compile_ZERO_LT)) condition = BranchCondition::LT;
+            else if (generator == static_cast<ForthFunction>(&compile_ZERO_GT)) condition = BranchCondition::GT;
+        }
+    }
+    if (condition == BranchCondition::NONE) return false;
+
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return false;
+    assembler->commentf("; -- %s %s (compare and branch)",
+                        std::string(compare.type == TokenType::TOKEN_OPTIMIZED ? compare.optimized_op : compare.value).c_str(),
+                        std::string(branch.value).c_str());
+
+    // drop the operands with mov and lea, which leave the flags alone
+    if (operands == TWO_CELLS) {
+        assembler->cmp(asmjit::x86::r12, asmjit::x86::r13);
+        assembler->mov(asmjit::x86::r13, asmjit::x86::ptr(asmjit::x86::r15));
+        assembler->mov(asmjit::x86::r12, asmjit::x86::ptr(asmjit::x86::r15, 8));
+        assembler->lea(asmjit::x86::r15, asmjit::x86::ptr(asmjit::x86::r15, 16));
+    } else {
+        if (operands == LITERAL) {
+            assembler->cmp(asmjit::x86::r13, asmjit::imm(literal));
+        } else {
+            assembler->test(asmjit::x86::r13, asmjit::x86::r13);
+        }
+        assembler->mov(asmjit::x86::r13, asmjit::x86::r12);
+        assembler->mov(asmjit::x86::r12, asmjit::x86::ptr(asmjit::x86::r15));
+        assembler->lea(asmjit::x86::r15, asmjit::x86::ptr(asmjit::x86::r15, 8));
+    }
+    pendingBranch = condition;
+    return true;
+}
+
 void code_generator_add_control_flow_words() {
     ForthDictionary &dict = ForthDictionary::instance();
 
@@ -5522,6 +6368,34 @@ void code_generator_add_control_flow_words() {
                      nullptr,
                      nullptr);
 
+    dict.addCodeWord("CASE", "FORTH",
+                     ForthState::GENERATOR,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genCase),
+                     nullptr,
+                     nullptr);
+
+    dict.addCodeWord("OF", "FORTH",
+                     ForthState::GENERATOR,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genOf),
+                     nullptr,
+                     nullptr);
+
+    dict.addCodeWord("ENDOF", "FORTH",
+                     ForthState::GENERATOR,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genEndOf),
+                     nullptr,
+                     nullptr);
+
+    dict.addCodeWord("ENDCASE", "FORTH",
+                     ForthState::GENERATOR,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genEndCase),
+                     nullptr,
+                     nullptr);
+
     dict.addCodeWord("BEGIN", "FORTH",
                      ForthState::GENERATOR,
                      ForthWordType::WORD,
@@ -5891,10 +6765,121 @@ static void compile_DIGIT() {
     labels.bindLabel(*assembler, "digit_end");
 }
 
+// Separate float stack.
+// Any token that is not a float word writes the cached floats back (code_generator_flush_floats),
+// so at calls, branches, labels and the end of a word the float stack is all in memory.
+static void load_float_pointer(asmjit::x86::Assembler *assembler) {
+    if (floatPointerLoaded) return;
+    assembler->mov(asmjit::x86::rax, asmjit::imm(&floatStackPointer));
+    assembler->mov(FSP, asmjit::x86::qword_ptr(asmjit::x86::rax));
+    floatPointerLoaded = true;
+}
+
+// at least n (1 or 2) items in XMM
+static void float_cache(asmjit::x86::Assembler *assembler, const int n) {
+    if (floatCached >= n) return;
+    load_float_pointer(assembler);
+    if (floatCached == 0) {
+        assembler->movsd(FTOS, asmjit::x86::qword_ptr(FSP));
+        assembler->add(FSP, 8);
+        floatCached = 1;
+    }
+    if (n == 2 && floatCached == 1) {
+        assembler->movsd(FNOS, asmjit::x86::qword_ptr(FSP));
+        assembler->add(FSP, 8);
+        floatCached = 2;
+    }
+}
+
+// value becomes the top float, the third item goes to memory
+static void float_push(asmjit::x86::Assembler *assembler, const asmjit::x86::Xmm &value) {
+    if (floatCached == 2) {
+        load_float_pointer(assembler);
+        assembler->sub(FSP, 8);
+        assembler->movsd(asmjit::x86::qword_ptr(FSP), FNOS);
+    }
+    if (floatCached >= 1) assembler->movapd(FNOS, FTOS);
+    if (value.id() != FTOS.id()) assembler->movapd(FTOS, value);
+    floatCached = floatCached == 2 ? 2 : floatCached + 1;
+}
+
+static void float_drop(asmjit::x86::Assembler *assembler) {
+    if (floatCached == 2) {
+        assembler->movapd(FTOS, FNOS);
+        floatCached = 1;
+    } else if (floatCached == 1) {
+        floatCached = 0;
+    } else {
+        load_float_pointer(assembler);
+        assembler->add(FSP, 8);
+    }
+}
+
+static void float_pop(asmjit::x86::Assembler *assembler, const asmjit::x86::Xmm &to) {
+    float_cache(assembler, 1);
+    assembler->movapd(to, FTOS);
+    float_drop(assembler);
+}
+
+// FNOS op FTOS replaces both
+template<typename Op>
+static void float_binary(asmjit::x86::Assembler *assembler, Op op) {
+    float_cache(assembler, 2);
+    op(FNOS, FTOS);
+    assembler->movapd(FTOS, FNOS);
+    floatCached = 1;
+}
+
+// the integer in rax onto the data stack
+static void push_rax() {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    compile_DUP();
+    assembler->mov(asmjit::x86::r13, asmjit::x86::rax);
+}
+
+void code_generator_flush_floats() {
+    if (floatCached == 0 && !floatPointerLoaded) return;
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+    assembler->comment("; -- write back float stack");
+    load_float_pointer(assembler);
+    if (floatCached == 2) {
+        assembler->sub(FSP, 16);
+        assembler->movsd(asmjit::x86::qword_ptr(FSP, 8), FNOS);
+        assembler->movsd(asmjit::x86::qword_ptr(FSP), FTOS);
+    } else if (floatCached == 1) {
+        assembler->sub(FSP, 8);
+        assembler->movsd(asmjit::x86::qword_ptr(FSP), FTOS);
+    }
+    assembler->mov(asmjit::x86::rax, asmjit::imm(&floatStackPointer));
+    assembler->mov(asmjit::x86::qword_ptr(asmjit::x86::rax), FSP);
+    floatCached = 0;
+    floatPointerLoaded = false;
+}
+
+// call a C double (double) function on the top float
+static void float_call(asmjit::x86::Assembler *assembler, double (*func)(double)) {
+    float_pop(assembler, asmjit::x86::xmm0);
+    code_generator_flush_floats(); // the callee may use any XMM register and r8
+    assembler->sub(asmjit::x86::rsp, 8);
+    call_out(assembler, reinterpret_cast<void *>(func));
+    assembler->add(asmjit::x86::rsp, 8);
+    float_push(assembler, asmjit::x86::xmm0);
+}
+
 void compile_pushLiteralFloat(const double literal) {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
 
+    if (floatStackSeparate) {
+        assembler->commentf("; -- float literal %f", literal);
+        assembler->mov(asmjit::x86::rax, asmjit::imm(*reinterpret_cast<const uint64_t *>(&literal)));
+        assembler->movq(asmjit::x86::xmm0, asmjit::x86::rax);
+        float_push(assembler, asmjit::x86::xmm0);
+        return;
+    }
+
     // Reserve space on the stack
     assembler->comment("; -- LITERAL float (make space for double)");
     compile_DUP();
@@ -5912,6 +6897,10 @@ void compile_pushLiteralFloat(const double literal) {
 static void genFPlus() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) { assembler->addsd(a, b); });
+        return;
+    }
     assembler->comment(" ; Add two floating point values from the stack");
     genFetchTwoXMMFromStack(assembler);
     assembler->addsd(asmjit::x86::xmm0, asmjit::x86::xmm1); // Add the two floating point values
@@ -5921,6 +6910,10 @@ static void genFPlus() {
 static void genFSub() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) { assembler->subsd(a, b); });
+        return;
+    }
     genFetchTwoXMMFromStack(assembler);
     assembler->comment(" ; floating point subtraction");
     assembler->subsd(asmjit::x86::xmm0, asmjit::x86::xmm1); // Subtract the floating point values
@@ -5931,6 +6924,10 @@ static void genFSub() {
 static void genFMul() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) { assembler->mulsd(a, b); });
+        return;
+    }
     assembler->comment(" ; Multiply");
     genFetchTwoXMMFromStack(assembler);
     assembler->mulsd(asmjit::x86::xmm0, asmjit::x86::xmm1); // Multiply the two floating point values
@@ -5941,6 +6938,10 @@ static void genFMul() {
 static void genFDiv() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) { assembler->divsd(a, b); });
+        return;
+    }
     assembler->comment(" ; Divide ");
     genFetchTwoXMMFromStack(assembler);
     assembler->divsd(asmjit::x86::xmm0, asmjit::x86::xmm1); // Divide the floating point values
@@ -5951,6 +6952,16 @@ static void genFDiv() {
 static void genFMod() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) {
+            assembler->movapd(asmjit::x86::xmm0, a);
+            assembler->divsd(asmjit::x86::xmm0, b);
+            assembler->roundsd(asmjit::x86::xmm0, asmjit::x86::xmm0, 1); // floor
+            assembler->mulsd(asmjit::x86::xmm0, b);
+            assembler->subsd(a, asmjit::x86::xmm0);
+        });
+        return;
+    }
     asmjit::x86::Gp firstVal = asmjit::x86::rax;
     asmjit::x86::Gp secondVal = asmjit::x86::rbx;
 
@@ -5974,6 +6985,10 @@ static void genFMod() {
 static void genFMax() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) { assembler->maxsd(a, b); });
+        return;
+    }
     assembler->comment(" ; Find the maximum of two floating point values from the stack");
     genFetchTwoXMMFromStack(assembler);
     assembler->maxsd(asmjit::x86::xmm0, asmjit::x86::xmm1); // Compute the maximum of the two values
@@ -5983,6 +6998,10 @@ static void genFMax() {
 static void genFMin() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_binary(assembler, [assembler](const auto &a, const auto &b) { assembler->minsd(a, b); });
+        return;
+    }
     assembler->comment(" ; Find the minimum of two floating point values from the stack");
     genFetchTwoXMMFromStack(assembler);
     assembler->minsd(asmjit::x86::xmm0, asmjit::x86::xmm1); // Compute the maximum of the two values
@@ -5990,45 +7009,120 @@ static void genFMin() {
 }
 
 
-static void genSin() {
+// the C library's name(x) on the top float, inlined under SET MATH PRECISE|FAST
+static void gen_math_unary(const char *name, double (*func)(double)) {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        if (mathAccuracy != MathAccuracy::LIBM) {
+            float_cache(assembler, 1);
+            const asmjit::x86::Xmm scratch[MATH_KERNEL_SCRATCH] = {
+                asmjit::x86::xmm0, asmjit::x86::xmm1, asmjit::x86::xmm2,
+                asmjit::x86::xmm3, asmjit::x86::xmm4, asmjit::x86::xmm5
+            };
+            math_kernel_emit(*assembler, name, mathAccuracy, FTOS, FTOS, FTOS, scratch);
+            return;
+        }
+        float_call(assembler, func);
+        return;
+    }
 
     asmjit::x86::Gp val = asmjit::x86::rax;
-    assembler->comment(" ; Compute the sine of a floating point value from the stack");
+    assembler->commentf(" ; Compute the %s of a floating point value from the stack", name);
     popDS(val); // Pop the floating point value from the stack
     assembler->movq(asmjit::x86::xmm0, val); // Move the value to XMM0
 
-    // Call the sin() function
-    assembler->sub(asmjit::x86::rsp, 8); // Reserve space on stack
-    assembler->call(reinterpret_cast<void *>(static_cast<double(*)(double)>(sin)));
-    assembler->add(asmjit::x86::rsp, 8); // Free reserved space
+    if (mathAccuracy != MathAccuracy::LIBM) {
+        const asmjit::x86::Xmm scratch[MATH_KERNEL_SCRATCH] = {
+            asmjit::x86::xmm1, asmjit::x86::xmm2, asmjit::x86::xmm3,
+            asmjit::x86::xmm4, asmjit::x86::xmm5, asmjit::x86::xmm6
+        };
+        math_kernel_emit(*assembler, name, mathAccuracy, asmjit::x86::xmm0, asmjit::x86::xmm0,
+                         asmjit::x86::xmm0, scratch);
+    } else {
+        // Call the C function
+        assembler->sub(asmjit::x86::rsp, 8); // Reserve space on stack
+        call_out(assembler, reinterpret_cast<void *>(func));
+        assembler->add(asmjit::x86::rsp, 8); // Free reserved space
+    }
 
     assembler->movq(val, asmjit::x86::xmm0); // Move the result back to a general-purpose register
     pushDS(val); // Push the result back onto the stack
 }
 
+static void genSin() {
+    gen_math_unary("sin", static_cast<double(*)(double)>(sin));
+}
+
 static void genCos() {
-    asmjit::x86::Assembler *assembler;
-    if (initialize_assembler(assembler)) return;
+    gen_math_unary("cos", static_cast<double(*)(double)>(cos));
+}
 
-    asmjit::x86::Gp val = asmjit::x86::rax;
-    assembler->comment(" ; Compute the cos of a floating point value from the stack");
-    popDS(val); // Pop the floating point value from the stack
-    assembler->movq(asmjit::x86::xmm0, val); // Move the value to XMM0
+static void genFExp() {
+    gen_math_unary("exp", static_cast<double(*)(double)>(exp));
+}
 
-    // Call the cos() function
-    assembler->sub(asmjit::x86::rsp, 8); // Reserve space on stack
-    assembler->call(reinterpret_cast<void *>(static_cast<double(*)(double)>(cos)));
-    assembler->add(asmjit::x86::rsp, 8); // Free reserved space
+static void genFLn() {
+    gen_math_unary("log", static_cast<double(*)(double)>(log));
+}
 
-    assembler->movq(val, asmjit::x86::xmm0); // Move the result back to a general-purpose register
-    pushDS(val); // Push the result back onto the stack
+static void genFTanh() {
+    gen_math_unary("tanh", static_cast<double(*)(double)>(tanh));
+}
+
+// x y f** x to the power y
+static void genFPow() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    const auto libm = reinterpret_cast<void *>(static_cast<double(*)(double, double)>(pow));
+    if (floatStackSeparate) {
+        if (mathAccuracy != MathAccuracy::LIBM) {
+            float_binary(assembler, [assembler](const auto &a, const auto &b) {
+                const asmjit::x86::Xmm scratch[MATH_KERNEL_SCRATCH] = {
+                    asmjit::x86::xmm0, asmjit::x86::xmm1, asmjit::x86::xmm2,
+                    asmjit::x86::xmm3, asmjit::x86::xmm4, asmjit::x86::xmm5
+                };
+                math_kernel_emit(*assembler, "pow", mathAccuracy, a, a, b, scratch);
+            });
+            return;
+        }
+        float_pop(assembler, asmjit::x86::xmm1);
+        float_pop(assembler, asmjit::x86::xmm0);
+        code_generator_flush_floats();
+        assembler->sub(asmjit::x86::rsp, 8);
+        call_out(assembler, libm);
+        assembler->add(asmjit::x86::rsp, 8);
+        float_push(assembler, asmjit::x86::xmm0);
+        return;
+    }
+
+    assembler->comment(" ; Raise a floating point value to a power");
+    genFetchTwoXMMFromStack(assembler);
+    if (mathAccuracy != MathAccuracy::LIBM) {
+        const asmjit::x86::Xmm scratch[MATH_KERNEL_SCRATCH] = {
+            asmjit::x86::xmm2, asmjit::x86::xmm3, asmjit::x86::xmm4,
+            asmjit::x86::xmm5, asmjit::x86::xmm6, asmjit::x86::xmm7
+        };
+        math_kernel_emit(*assembler, "pow", mathAccuracy, asmjit::x86::xmm0, asmjit::x86::xmm0,
+                         asmjit::x86::xmm1, scratch);
+    } else {
+        assembler->sub(asmjit::x86::rsp, 8);
+        call_out(assembler, libm);
+        assembler->add(asmjit::x86::rsp, 8);
+    }
+    genPushXmm0(assembler);
 }
 
 static void genFAbs() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_cache(assembler, 1);
+        assembler->mov(asmjit::x86::rax, asmjit::imm(0x7FFFFFFFFFFFFFFF));
+        assembler->movq(asmjit::x86::xmm0, asmjit::x86::rax);
+        assembler->andpd(FTOS, asmjit::x86::xmm0);
+        return;
+    }
 
     asmjit::x86::Gp val = asmjit::x86::rax;
     asmjit::x86::Gp mask = asmjit::x86::rbx;
@@ -6044,6 +7138,17 @@ static void genFAbs() {
 static void genFLess() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_cache(assembler, 2);
+        assembler->comisd(FNOS, FTOS);
+        float_drop(assembler);
+        float_drop(assembler);
+        assembler->setb(asmjit::x86::al);
+        assembler->movzx(asmjit::x86::rax, asmjit::x86::al);
+        assembler->neg(asmjit::x86::rax);
+        push_rax();
+        return;
+    }
     const asmjit::x86::Gp firstVal = asmjit::x86::rax;
     const asmjit::x86::Gp secondVal = asmjit::x86::rbx;
 
@@ -6068,6 +7173,17 @@ static void genFLess() {
 static void genFGreater() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_cache(assembler, 2);
+        assembler->comisd(FTOS, FNOS);
+        float_drop(assembler);
+        float_drop(assembler);
+        assembler->setb(asmjit::x86::al);
+        assembler->movzx(asmjit::x86::rax, asmjit::x86::al);
+        assembler->neg(asmjit::x86::rax);
+        push_rax();
+        return;
+    }
     asmjit::x86::Gp firstVal = asmjit::x86::rax;
     asmjit::x86::Gp secondVal = asmjit::x86::rbx;
 
@@ -6092,6 +7208,12 @@ static void genFGreater() {
 static void genIntToFloat() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        assembler->cvtsi2sd(asmjit::x86::xmm0, asmjit::x86::r13);
+        compile_DROP();
+        float_push(assembler, asmjit::x86::xmm0);
+        return;
+    }
     asmjit::x86::Gp intVal = asmjit::x86::rax;
     assembler->comment(" ; Convert integer to floating point");
     popDS(intVal); // Pop integer value from the stack
@@ -6104,6 +7226,12 @@ static void genIntToFloat() {
 static void genFloatToInt() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_pop(assembler, asmjit::x86::xmm0);
+        assembler->cvttsd2si(asmjit::x86::rax, asmjit::x86::xmm0);
+        push_rax();
+        return;
+    }
 
     asmjit::x86::Gp floatVal = asmjit::x86::rax;
 
@@ -6118,6 +7246,13 @@ static void genFloatToInt() {
 static void genFloatToIntRounding() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_pop(assembler, asmjit::x86::xmm0);
+        assembler->roundsd(asmjit::x86::xmm0, asmjit::x86::xmm0, 0b00);
+        assembler->cvtsd2si(asmjit::x86::rax, asmjit::x86::xmm0);
+        push_rax();
+        return;
+    }
 
     asmjit::x86::Gp floatVal = asmjit::x86::rax;
 
@@ -6132,6 +7267,13 @@ static void genFloatToIntRounding() {
 static void genFloatToIntFloor() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_pop(assembler, asmjit::x86::xmm0);
+        assembler->roundsd(asmjit::x86::xmm0, asmjit::x86::xmm0, 0b01);
+        assembler->cvtsd2si(asmjit::x86::rax, asmjit::x86::xmm0);
+        push_rax();
+        return;
+    }
 
     asmjit::x86::Gp floatVal = asmjit::x86::rax;
 
@@ -6146,6 +7288,11 @@ static void genFloatToIntFloor() {
 static void genSqrt() {
     asmjit::x86::Assembler *assembler;
     if (initialize_assembler(assembler)) return;
+    if (floatStackSeparate) {
+        float_cache(assembler, 1);
+        assembler->sqrtsd(FTOS, FTOS);
+        return;
+    }
 
     asmjit::x86::Gp val = asmjit::x86::rax;
     assembler->comment(" ; Compute the square root of a floating point value from the stack");
@@ -6154,7 +7301,7 @@ static void genSqrt() {
 
     // Call the sqrt() function
     assembler->sub(asmjit::x86::rsp, 8); // Reserve space on the stack
-    assembler->call(reinterpret_cast<void *>(static_cast<double(*)(double)>(sqrt)));
+    call_out(assembler, reinterpret_cast<void *>(static_cast<double(*)(double)>(sqrt)));
     assembler->add(asmjit::x86::rsp, 8); // Free reserved space
 
     assembler->movq(val, asmjit::x86::xmm0); // Move the result back to a general-purpose register
@@ -6173,6 +7320,113 @@ static void genFEquals() {
 }
 
 
+// Float stack words, on the data stack they are the integer words
+static void genFFetch() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    if (!floatStackSeparate) {
+        fetchFromDS();
+        return;
+    }
+    assembler->comment("; -- f@");
+    assembler->movsd(asmjit::x86::xmm0, asmjit::x86::qword_ptr(asmjit::x86::r13));
+    compile_DROP();
+    float_push(assembler, asmjit::x86::xmm0);
+}
+
+static void genFStore() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    if (!floatStackSeparate) {
+        storeFromDS();
+        return;
+    }
+    assembler->comment("; -- f!");
+    float_pop(assembler, asmjit::x86::xmm0);
+    assembler->movsd(asmjit::x86::qword_ptr(asmjit::x86::r13), asmjit::x86::xmm0);
+    compile_DROP();
+}
+
+static void genFDup() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    if (!floatStackSeparate) {
+        compile_DUP();
+        return;
+    }
+    float_cache(assembler, 1);
+    float_push(assembler, FTOS);
+}
+
+static void genFDrop() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    if (!floatStackSeparate) {
+        compile_DROP();
+        return;
+    }
+    float_drop(assembler);
+}
+
+static void genFSwap() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    if (!floatStackSeparate) {
+        compile_SWAP();
+        return;
+    }
+    float_cache(assembler, 2);
+    assembler->movapd(asmjit::x86::xmm0, FTOS);
+    assembler->movapd(FTOS, FNOS);
+    assembler->movapd(FNOS, asmjit::x86::xmm0);
+}
+
+static void genFOver() {
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return;
+    if (!floatStackSeparate) {
+        compile_OVER();
+        return;
+    }
+    float_cache(assembler, 2);
+    assembler->movapd(asmjit::x86::xmm0, FNOS);
+    float_push(assembler, asmjit::x86::xmm0);
+}
+
+// the generators that compile against the float cache
+static const ForthFunction floatGenerators[] = {
+    genFPlus, genFSub, genFMul, genFDiv, genFMod, genFMax, genFMin, genSin, genCos, genFExp, genFLn, genFTanh,
+    genFPow, genSqrt, genFAbs,
+    genFLess, genFGreater, genFEquals, genIntToFloat, genFloatToInt, genFloatToIntRounding, genFloatToIntFloor,
+    genFFetch, genFStore, genFDup, genFDrop, genFSwap, genFOver
+};
+
+static bool float_generator(const ForthFunction generator) {
+    return std::find(std::begin(floatGenerators), std::end(floatGenerators), generator) != std::end(floatGenerators);
+}
+
+bool code_generator_float_token(const ForthToken &token) {
+    if (!floatStackSeparate) return false;
+    if (token.type == TokenType::TOKEN_FLOAT) return true;
+    if (token.type != TokenType::TOKEN_WORD && token.type != TokenType::TOKEN_CALL) return false;
+    const auto entry = ForthDictionary::instance().findWord(token.value);
+    return entry && entry->generator && float_generator(entry->generator);
+}
+
+// SET FSTACK, the float words run by the interpreter use the stack just selected
+void code_generator_rebuild_float_words() {
+    auto &jit = JitContext::instance();
+    auto &dict = ForthDictionary::instance();
+    dict.forEachEntry([&jit, &dict](ForthDictionaryEntry *entry) {
+        if (!entry->generator || !float_generator(entry->generator)) return;
+        const auto old = reinterpret_cast<const void *>(entry->executable);
+        dict.setExecutable(entry, code_generator_build_forth(entry->generator, std::string(entry->getWordName())));
+        if (old && jit.codeUsers(old) == 0 && jit.ownsCode(old) && !dict.executableInUse(old)) {
+            jit.releaseCode(old);
+        }
+    });
+}
+
 void code_generator_add_float_words() {
     ForthDictionary &dict = ForthDictionary::instance();
 
@@ -6181,14 +7435,14 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&compile_DIGIT),
-                     code_generator_build_forth(compile_DIGIT),
+                     code_generator_build_forth(compile_DIGIT, "DIGIT"),
                      nullptr);
 
     dict.addCodeWord("f=", "FORTH",
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFEquals),
-                     code_generator_build_forth(genFEquals),
+                     code_generator_build_forth(genFEquals, "f="),
                      nullptr
     );
 
@@ -6196,7 +7450,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genSqrt),
-                     code_generator_build_forth(genSqrt),
+                     code_generator_build_forth(genSqrt, "fsqrt"),
                      nullptr
     );
 
@@ -6204,7 +7458,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFloatToIntFloor),
-                     code_generator_build_forth(genFloatToIntFloor),
+                     code_generator_build_forth(genFloatToIntFloor, "floor"),
                      nullptr
     );
 
@@ -6212,7 +7466,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFloatToIntRounding),
-                     code_generator_build_forth(genFloatToIntRounding),
+                     code_generator_build_forth(genFloatToIntRounding, "fround"),
                      nullptr
     );
 
@@ -6221,7 +7475,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFloatToInt),
-                     code_generator_build_forth(genFloatToInt),
+                     code_generator_build_forth(genFloatToInt, "ftruncate"),
                      nullptr
     );
 
@@ -6229,7 +7483,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFloatToInt),
-                     code_generator_build_forth(genFloatToInt),
+                     code_generator_build_forth(genFloatToInt, "f>s"),
                      nullptr
     );
 
@@ -6237,7 +7491,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genIntToFloat),
-                     code_generator_build_forth(genIntToFloat),
+                     code_generator_build_forth(genIntToFloat, "s>f"),
                      nullptr
     );
 
@@ -6246,7 +7500,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFGreater),
-                     code_generator_build_forth(genFGreater),
+                     code_generator_build_forth(genFGreater, "f>"),
                      nullptr
     );
 
@@ -6255,7 +7509,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFLess),
-                     code_generator_build_forth(genFLess),
+                     code_generator_build_forth(genFLess, "f<"),
                      nullptr
     );
 
@@ -6264,7 +7518,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genSin),
-                     code_generator_build_forth(genSin),
+                     code_generator_build_forth(genSin, "sin"),
                      nullptr
     );
 
@@ -6272,7 +7526,39 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genCos),
-                     code_generator_build_forth(genCos),
+                     code_generator_build_forth(genCos, "cos"),
+                     nullptr
+    );
+
+    dict.addCodeWord("fexp", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFExp),
+                     code_generator_build_forth(genFExp, "fexp"),
+                     nullptr
+    );
+
+    dict.addCodeWord("fln", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFLn),
+                     code_generator_build_forth(genFLn, "fln"),
+                     nullptr
+    );
+
+    dict.addCodeWord("ftanh", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFTanh),
+                     code_generator_build_forth(genFTanh, "ftanh"),
+                     nullptr
+    );
+
+    dict.addCodeWord("f**", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFPow),
+                     code_generator_build_forth(genFPow, "f**"),
                      nullptr
     );
 
@@ -6281,7 +7567,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFAbs),
-                     code_generator_build_forth(genFAbs),
+                     code_generator_build_forth(genFAbs, "fabs"),
                      nullptr
     );
 
@@ -6290,7 +7576,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFMin),
-                     code_generator_build_forth(genFMin),
+                     code_generator_build_forth(genFMin, "fmin"),
                      nullptr
     );
 
@@ -6299,7 +7585,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFMax),
-                     code_generator_build_forth(genFMax),
+                     code_generator_build_forth(genFMax, "fmax"),
                      nullptr
     );
 
@@ -6308,7 +7594,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFMod),
-                     code_generator_build_forth(genFMod),
+                     code_generator_build_forth(genFMod, "fmod"),
                      nullptr
     );
 
@@ -6317,7 +7603,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFDiv),
-                     code_generator_build_forth(genFDiv),
+                     code_generator_build_forth(genFDiv, "f/"),
                      nullptr
     );
 
@@ -6326,7 +7612,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFMul),
-                     code_generator_build_forth(genFMul),
+                     code_generator_build_forth(genFMul, "f*"),
                      nullptr
     );
 
@@ -6335,7 +7621,7 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFSub),
-                     code_generator_build_forth(genFSub),
+                     code_generator_build_forth(genFSub, "f-"),
                      nullptr
     );
 
@@ -6352,7 +7638,55 @@ void code_generator_add_float_words() {
                      ForthState::EXECUTABLE,
                      ForthWordType::WORD,
                      static_cast<ForthFunction>(&genFPlus),
-                     code_generator_build_forth(genFPlus),
+                     code_generator_build_forth(genFPlus, "f+"),
+                     nullptr
+    );
+
+    dict.addCodeWord("f@", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFFetch),
+                     code_generator_build_forth(genFFetch, "f@"),
+                     nullptr
+    );
+
+    dict.addCodeWord("f!", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFStore),
+                     code_generator_build_forth(genFStore, "f!"),
+                     nullptr
+    );
+
+    dict.addCodeWord("fdup", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFDup),
+                     code_generator_build_forth(genFDup, "fdup"),
+                     nullptr
+    );
+
+    dict.addCodeWord("fdrop", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFDrop),
+                     code_generator_build_forth(genFDrop, "fdrop"),
+                     nullptr
+    );
+
+    dict.addCodeWord("fswap", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFSwap),
+                     code_generator_build_forth(genFSwap, "fswap"),
+                     nullptr
+    );
+
+    dict.addCodeWord("fover", "FORTH",
+                     ForthState::EXECUTABLE,
+                     ForthWordType::WORD,
+                     static_cast<ForthFunction>(&genFOver),
+                     code_generator_build_forth(genFOver, "fover"),
                      nullptr
     );
 }
@@ -1,11 +1,17 @@
 #include "Compiler.h"
 #include <ForthDictionary.h>
 #include <iostream>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 #include "ControlFlow.h"
 #include "CodeGenerator.h"
 #include  "LetCodeGenerator.h"
+#include "LetMapGenerator.h"
 #include "Tokenizer.h"
 #include "Optimizer.h"
+#include "VirtualStack.h"
 
 #include "SignalHandler.h"
 #include "Settings.h"
@@ -50,6 +56,10 @@ void Compiler::compile_let(const std::string &input) {
     std::transform(letString.begin(), letString.end(), letString.begin(),
                    [](unsigned char c) { return std::tolower(c); });
 
+    // LET-MAP parses as a LET, and compiles into a loop over arrays
+    const bool letMap = letString.rfind("let-map", 0) == 0;
+    if (letMap) letString.replace(0, 7, "let");
+
     code_generator_startFunction(functionName);
 
     const auto tokens = tokenize(letString);
@@ -70,9 +80,13 @@ void Compiler::compile_let(const std::string &input) {
     try {
 
 
-        LetCodeGenerator::instance().initialize();
+        if (letMap) {
+            LetMapGenerator::instance().generateCode(dynamic_cast<const LetStatement *>(ast.get()));
+        } else {
+            LetCodeGenerator::instance().initialize();
 
-        LetCodeGenerator::instance().generateCode(ast.get());
+            LetCodeGenerator::instance().generateCode(ast.get());
+        }
 
 
 
@@ -116,11 +130,45 @@ void Compiler::compile_let(const std::string &input) {
 
  
 void Compiler::compile_words(std::deque<ForthToken> &input_tokens) {
+    // Keep the tokens to compile the word again once it is hot
+    std::unique_ptr<TierProfile> profile = tiering ? capture_tier_profile(input_tokens) : nullptr;
+    // Replace calls to small words by their bodies, so the optimizer sees them
+    if (inlining) {
+        expand_inline_calls(input_tokens);
+    }
+    // Keep this definition's body if it is small enough to be inlined later
+    std::unique_ptr<InlineBody> inlineBody = capture_inline_body(input_tokens);
+
+    std::string word_name;
+    ForthFunction f = compile_definition(input_tokens, word_name, profile.get());
+
+    // Step 5: add it to the dictionary
+    auto &dict = ForthDictionary::instance();
+    const auto entry = dict.addCodeWord(word_name, dict.getCurrentVocabularyName(),
+                                        ForthState::EXECUTABLE,
+                                        ForthWordType::WORD,
+                                        nullptr,
+                                        f,
+                                        nullptr);
+    entry->inlineBody = inlineBody.release();
+    if (profile) {
+        profile->entry = entry;
+        profile->baseline = f;
+        entry->tierProfile = profile.release();
+    }
+}
+
+// Compiles : NAME ... ; from input_tokens, which it empties; profile, if given, is counted
+ForthFunction Compiler::compile_definition(std::deque<ForthToken> &input_tokens, std::string &word_name,
+                                           TierProfile *profile) {
     ForthToken token;
-    // Create a copy of tokens and optimize if necessary
-    std::deque<ForthToken> tokens = input_tokens;
+
+    // Take over the tokens, optimizing them on the way if enabled
+    std::deque<ForthToken> tokens;
     if (optimizer == true) {
         Optimizer::instance().optimize(input_tokens, tokens);
+    } else {
+        tokens.swap(input_tokens);
     }
     input_tokens.clear();
 
@@ -128,7 +176,7 @@ void Compiler::compile_words(std::deque<ForthToken> &input_tokens) {
     validate_compiler_state(tokens);
 
     // Step 2: Extract the word name
-    std::string word_name = extract_word_name(tokens);
+    word_name = extract_word_name(tokens);
 
     // Step 2 b - skip the stack effect comment
     token = tokens.front();
@@ -143,6 +191,10 @@ void Compiler::compile_words(std::deque<ForthToken> &input_tokens) {
 
     // Step 3: Start code generation for the function
     code_generator_startFunction(word_name);
+    VirtualStack::instance().reset_counts();
+    if (profile) {
+        code_generator_count_calls(profile);
+    }
 
     // Step 4: Process tokens
     while (!tokens.empty()) {
@@ -153,20 +205,190 @@ void Compiler::compile_words(std::deque<ForthToken> &input_tokens) {
             break;
         }
 
+        // Floats cached in XMM registers go back to the float stack before any other word
+        if (!code_generator_float_token(token)) {
+            code_generator_flush_floats();
+        }
+
+        // A comparison feeding IF, WHILE or UNTIL only sets the flags for the branch
+        if (optimizer == true && tokens.size() > 1 && code_generator_compare_and_branch(token, tokens[1])) {
+            tokens.pop_front();
+            continue;
+        }
+
+        // Runs of stack words and literals are compiled against a model of the stack
+        if (optimizer == true) {
+            if (const size_t used = VirtualStack::instance().compile_region(tokens)) {
+                tokens.erase(tokens.begin(), tokens.begin() + static_cast<std::ptrdiff_t>(used));
+                continue;
+            }
+        }
+
         process_token(token, tokens, word_name);
         tokens.pop_front(); // Remove the processed token
     }
 
-    // Step 5: Finalize the function and add it to the dictionary
+    VirtualStack::instance().report(word_name);
+
+    // Step 5: Finalize the function
     compile_return();
-    ForthFunction f = code_generator_finalizeFunction(word_name);
-    auto &dict = ForthDictionary::instance();
-    dict.addCodeWord(word_name, dict.getCurrentVocabularyName(),
-                     ForthState::EXECUTABLE,
-                     ForthWordType::WORD,
-                     nullptr,
-                     f,
-                     nullptr);
+    return code_generator_finalizeFunction(word_name);
+}
+
+// Tokens of : NAME ... ; with their text copied, they outlive the input line
+std::unique_ptr<TierProfile> Compiler::capture_tier_profile(const std::deque<ForthToken> &tokens) {
+    if (tokens.size() < 3 || tokens[0].type != TokenType::TOKEN_COMPILING) return nullptr;
+
+    size_t end = 0;
+    while (end < tokens.size() && tokens[end].type != TokenType::TOKEN_INTERPRETING) end++;
+    if (end == tokens.size()) return nullptr; // no ;
+    end++;
+
+    size_t size = 0;
+    for (size_t i = 0; i < end; i++) size += tokens[i].value.size() + tokens[i].optimized_op.size();
+
+    const auto &dict = ForthDictionary::instance();
+    auto profile = std::make_unique<TierProfile>();
+    profile->floatStackSeparate = floatStackSeparate;
+    profile->mathAccuracy = mathAccuracy;
+    profile->text.reserve(size); // never reallocated below, the views stay valid
+    auto keep = [&profile](const std::string_view text) {
+        const size_t at = profile->text.size();
+        profile->text.append(text);
+        return std::string_view(profile->text).substr(at, text.size());
+    };
+    for (size_t i = 0; i < end; i++) {
+        ForthToken token = tokens[i];
+        token.value = keep(token.value);
+        token.optimized_op = keep(token.optimized_op);
+        const bool word = token.type == TokenType::TOKEN_WORD || token.type == TokenType::TOKEN_VARIABLE;
+        profile->tokens.push_back(token);
+        profile->words.push_back(word ? dict.findWord(token.value) : nullptr);
+    }
+    return profile;
+}
+
+// The hot word again, with the optimizer and inlining on, swapped in under its callers.
+// Not if a word it calls was redefined since, its callers must keep the meaning they had.
+// The float stack and math settings are those it was first compiled under, not today's.
+void Compiler::recompile(TierProfile &profile) {
+    profile.recompiled = true; // hot once, recompiled once
+    const auto &dict = ForthDictionary::instance();
+    for (size_t i = 0; i < profile.tokens.size(); i++) {
+        if (profile.words[i] && dict.findWord(profile.tokens[i].value) != profile.words[i]) {
+            if (jitLogging) {
+                std::cout << "Tiering: " << profile.entry->getWordName() << " not recompiled, "
+                          << profile.tokens[i].value << " was redefined" << std::endl;
+            }
+            return;
+        }
+    }
+
+    const bool savedOptimizer = optimizer;
+    const bool savedInlining = inlining;
+    const bool savedFloatStackSeparate = floatStackSeparate;
+    const MathAccuracy savedMathAccuracy = mathAccuracy;
+    optimizer = true;
+    inlining = true;
+    floatStackSeparate = profile.floatStackSeparate;
+    mathAccuracy = profile.mathAccuracy;
+    std::deque<ForthToken> tokens(profile.tokens.begin(), profile.tokens.end());
+    expand_inline_calls(tokens);
+    std::string word_name;
+    const ForthFunction f = compile_definition(tokens, word_name, nullptr);
+    optimizer = savedOptimizer;
+    inlining = savedInlining;
+    floatStackSeparate = savedFloatStackSeparate;
+    mathAccuracy = savedMathAccuracy;
+    if (!f) return;
+
+    if (jitLogging) {
+        std::cout << "Tiering: recompiled " << word_name << " after " << profile.counters.calls << " calls, "
+                  << profile.counters.loops << " loop iterations" << std::endl;
+    }
+    ForthDictionary::instance().setExecutable(profile.entry, f);
+}
+
+// A word token may be part of an inlined body if it compiles the same way
+// wherever it appears: no control flow, no immediate words, no EXIT or RECURSE.
+static bool inlinable_word(const ForthDictionaryEntry *entry) {
+    return entry && entry->state == ForthState::EXECUTABLE
+           && !entry->immediate_interpreter && !entry->immediate_compiler
+           && (entry->type == ForthWordType::WORD || entry->type == ForthWordType::VARIABLE
+               || entry->type == ForthWordType::CONSTANT);
+}
+
+// Tokens of : NAME ( comment ) body ; if the body is straight line and within INLINELIMIT
+std::unique_ptr<InlineBody> Compiler::capture_inline_body(const std::deque<ForthToken> &tokens) {
+    if (tokens.size() < 3 || tokens[0].type != TokenType::TOKEN_COMPILING) return nullptr;
+
+    size_t i = 2;
+    if (tokens[i].type == TokenType::TOKEN_BEGINCOMMENT) {
+        while (i < tokens.size() && tokens[i].type != TokenType::TOKEN_ENDCOMMENT) i++;
+        i++;
+    }
+
+    const auto &dict = ForthDictionary::instance();
+    auto body = std::make_unique<InlineBody>();
+    for (; i < tokens.size(); i++) {
+        const ForthToken &token = tokens[i];
+        if (token.type == TokenType::TOKEN_INTERPRETING) {
+            return body->tokens.size() <= static_cast<size_t>(inlineLimit) ? std::move(body) : nullptr;
+        }
+        if (token.type == TokenType::TOKEN_NUMBER || token.type == TokenType::TOKEN_FLOAT) {
+            ForthToken literal = token;
+            literal.value = {}; // views the input line, the value is all a literal needs
+            body->tokens.push_back(literal);
+            body->words.push_back(nullptr);
+        } else if (token.type == TokenType::TOKEN_WORD || token.type == TokenType::TOKEN_VARIABLE) {
+            const auto entry = dict.findWord(token.value);
+            if (!inlinable_word(entry)) return nullptr;
+            body->tokens.push_back(token);
+            body->words.push_back(entry);
+        } else {
+            return nullptr;
+        }
+        if (body->tokens.size() > static_cast<size_t>(inlineLimit)) return nullptr;
+    }
+    return nullptr; // no ;
+}
+
+// Splice inline bodies in place of calls, after the word name.
+// A word right after an immediate word (' POSTPONE IS ...) is left alone, it may be its argument.
+void Compiler::expand_inline_calls(std::deque<ForthToken> &tokens) {
+    if (tokens.size() < 3 || tokens[0].type != TokenType::TOKEN_COMPILING) return;
+
+    const auto &dict = ForthDictionary::instance();
+    std::deque<ForthToken> expanded;
+    const ForthDictionaryEntry *previous = nullptr;
+    size_t index = 0;
+    for (const ForthToken &token: tokens) {
+        const ForthDictionaryEntry *entry = nullptr;
+        if (index++ >= 2 && (token.type == TokenType::TOKEN_WORD || token.type == TokenType::TOKEN_VARIABLE)) {
+            entry = dict.findWord(token.value);
+        }
+
+        const bool argument = previous && (previous->immediate_interpreter || previous->immediate_compiler);
+        const InlineBody *body = entry && !argument ? entry->inlineBody : nullptr;
+
+        // the body's words must still resolve as they did when it was compiled
+        for (size_t i = 0; body && i < body->tokens.size(); i++) {
+            if (body->words[i] && dict.findWord(body->tokens[i].value) != body->words[i]) {
+                body = nullptr;
+            }
+        }
+
+        if (body) {
+            if (jitLogging) {
+                std::cout << "Inlining " << token.value << " (" << body->tokens.size() << " tokens)" << std::endl;
+            }
+            expanded.insert(expanded.end(), body->tokens.begin(), body->tokens.end());
+        } else {
+            expanded.push_back(token);
+        }
+        previous = entry;
+    }
+    tokens.swap(expanded);
 }
 
 // Helper Method: Validate Compiler State
@@ -184,14 +406,14 @@ void Compiler::validate_compiler_state(std::deque<ForthToken> &tokens) {
 // Helper Method: Extract Word Name
 std::string Compiler::extract_word_name(std::deque<ForthToken> &tokens) {
     auto token = tokens.front();
-    if (token.type != TokenType::TOKEN_UNKNOWN) {
+    if (!is_new_name(token)) {
         SignalHandler::instance().raise(17); // "New name expected"
     }
     tokens.pop_front();
     if (tokens.empty()) {
         SignalHandler::instance().raise(6);
     }
-    return token.value; // Extract word name
+    return std::string(token.value); // Extract word name
 }
 
 // Helper Method: Process Token
@@ -214,6 +436,10 @@ void Compiler::process_token(const ForthToken &token, std::deque<ForthToken> &to
             compile_token_optimized(token, tokens);
             break;
 
+        case TokenType::TOKEN_CALL:
+            compile_token_call(token, tokens, word_name);
+            break;
+
         default:
             std::cerr << "Compiler: Unhandled token type: " << token.value << std::endl;
             Tokenizer::instance().print_token(token);
@@ -233,18 +459,101 @@ void Compiler::compile_token_float(const ForthToken &token) {
     compile_pushLiteralFloat(token.float_value);
 }
 
+// A DO loop can keep index and limit in registers if it is innermost and its body
+// leaves the return stack alone; tokens starts at the DO.
+static bool do_loop_in_registers(const std::deque<ForthToken> &tokens) {
+    static const std::unordered_set<std::string_view> returnStackWords = {
+        ">R", "R>", "R@", "2>R", "2R>", "2X>R", "2XR>", "RDROP", "2RDROP", "R>R", "RP@", "RP!", "RDEPTH",
+        "UNLOOP", "VAR_TOR", "R@_!", "R@_C!", "INC_R@", "DEC_R@"
+    };
+    for (size_t i = 1; i < tokens.size(); i++) {
+        const ForthToken &token = tokens[i];
+        std::string_view name;
+        if (token.type == TokenType::TOKEN_OPTIMIZED) {
+            name = token.optimized_op;
+        } else if (token.type == TokenType::TOKEN_WORD || token.type == TokenType::TOKEN_CALL) {
+            name = token.value;
+        } else if (token.type == TokenType::TOKEN_END || token.type == TokenType::TOKEN_INTERPRETING) {
+            return false;
+        } else {
+            continue;
+        }
+        if (name == "LOOP" || name == "+LOOP") return true;
+        if (name == "DO" || returnStackWords.count(name)) return false;
+    }
+    return false;
+}
+
+// The key of an OF, if the token before it is a literal or a constant.
+static bool case_key(const ForthToken &token, int64_t &key) {
+    if (token.type == TokenType::TOKEN_NUMBER) {
+        key = static_cast<int64_t>(token.int_value);
+        return true;
+    }
+    if (token.type == TokenType::TOKEN_WORD) {
+        const auto entry = ForthDictionary::instance().findWord(token.value);
+        if (entry && entry->type == ForthWordType::CONSTANT && entry->data) {
+            key = *static_cast<int64_t *>(entry->data);
+            return true;
+        }
+    }
+    return false;
+}
+
+// If every OF of the CASE at the front of tokens has a single literal key, as in
+// CASE 1 OF ... ENDOF 2 OF ... ENDOF ... ENDCASE, the keys are removed from the
+// tokens and returned in OF order so the CASE can dispatch on them; otherwise none.
+static std::vector<int64_t> take_case_keys(std::deque<ForthToken> &tokens) {
+    std::vector<int64_t> keys;
+    std::vector<size_t> positions;
+    int depth = 0;
+    bool armStart = true; // just after CASE or ENDOF of this CASE
+    for (size_t i = 1; i < tokens.size(); i++) {
+        const ForthToken &token = tokens[i];
+        if (token.type == TokenType::TOKEN_END || token.type == TokenType::TOKEN_INTERPRETING) return {};
+        const std::string_view name = token.type == TokenType::TOKEN_WORD ? token.value : std::string_view();
+
+        if (depth == 0 && armStart) {
+            armStart = false;
+            int64_t key;
+            if (i + 1 < tokens.size() && tokens[i + 1].type == TokenType::TOKEN_WORD
+                && tokens[i + 1].value == "OF" && case_key(token, key)) {
+                keys.push_back(key);
+                positions.push_back(i);
+                i++;
+                continue;
+            }
+        }
+
+        if (name == "CASE") {
+            depth++;
+        } else if (name == "ENDCASE" && depth-- == 0) {
+            if (keys.empty()) return {};
+            for (auto p = positions.rbegin(); p != positions.rend(); ++p) {
+                tokens.erase(tokens.begin() + static_cast<std::ptrdiff_t>(*p));
+            }
+            return keys;
+        } else if (depth == 0 && name == "OF") {
+            return {}; // a key computed at run time
+        } else if (depth == 0 && name == "ENDOF") {
+            armStart = true;
+        }
+    }
+    return {};
+}
+
 // Helper Method: Compile Word Token
 void Compiler::compile_token_word(const ForthToken &token, std::deque<ForthToken> &tokens, [[maybe_unused]] std::string &word_name) {
 
 
-    auto word_found = ForthDictionary::instance().findWord(token.value.c_str());
+    auto word_found = ForthDictionary::instance().findWord(token.value);
     if (word_found == nullptr) {
         std::cerr << "Word not found: " << token.value << std::endl;
         SignalHandler::instance().raise(6);
         return;
     }
 
-    const std::string called_word_name = token.value;
+    const std::string called_word_name(token.value);
 
     // variable, avoid calling the word, when compiling.
     if (word_found->type == ForthWordType::VARIABLE ) {
@@ -257,7 +566,14 @@ void Compiler::compile_token_word(const ForthToken &token, std::deque<ForthToken
 
     } else if (word_found->generator) {
 
+        if (token.value == "DO") {
+            code_generator_plan_do_loop(do_loop_in_registers(tokens));
+        } else if (token.value == "CASE" && optimizer == true) {
+            code_generator_plan_case(take_case_keys(tokens));
+        }
         word_found->generator();
+    } else if (word_found->tierProfile && !word_found->tierProfile->recompiled) {
+        compile_call_forth_entry(word_found, called_word_name);
     } else if (word_found->executable) {
         compile_call_forth(word_found->executable, called_word_name);
     } else if (word_found->immediate_compiler) {
@@ -266,10 +582,23 @@ void Compiler::compile_token_word(const ForthToken &token, std::deque<ForthToken
     }
 }
 
+// Helper Method: Compile Tail Call Token, an ordinary call where a jump is not possible
+void Compiler::compile_token_call(const ForthToken &token, std::deque<ForthToken> &tokens, std::string &word_name) {
+    const auto word_found = ForthDictionary::instance().findWord(token.value);
+    if (token.value == "RECURSE") {
+        if (compile_tail_recurse()) return;
+    } else if (word_found && word_found->tierProfile && !word_found->tierProfile->recompiled) {
+        if (compile_tail_call_forth_entry(word_found, std::string(token.value))) return;
+    } else if (word_found && word_found->executable && !word_found->generator) {
+        if (compile_tail_call_forth(word_found->executable, std::string(token.value))) return;
+    }
+    compile_token_word(token, tokens, word_name);
+}
+
 // Helper Method: Compile Optimized Token
 void Compiler::compile_token_optimized(const ForthToken &token, std::deque<ForthToken> &tokens) {
     // Tokenizer::instance().print_token(token);
-    auto word_found = ForthDictionary::instance().findWord(token.optimized_op.c_str());
+    auto word_found = ForthDictionary::instance().findWord(token.optimized_op);
     if (word_found && word_found->immediate_interpreter) {
         word_found->immediate_interpreter(tokens);
     }
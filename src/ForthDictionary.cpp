@@ -2,14 +2,16 @@
 #include <cstring>
 #include <iostream>
 #include <JitContext.h>
-#include <unordered_set>
+#include <algorithm>
 #include <asmjit/core/jitruntime.h>
 
+#include "Peephole.h"
 #include "Quit.h"
 #include "SymbolTable.h"
 #include "Tokenizer.h"
 #include "SignalHandler.h"
 #include <map>
+#include <unordered_set>
 
 // Define a helper function to retrieve color codes
 std::string getColorCode(ForthWordType type) {
@@ -108,6 +110,8 @@ ForthDictionaryEntry *ForthDictionary::addCodeWord(
 
     // Update the head of the list for this word length
     dictionaryLists[length] = newWord;
+    indexEntry(newWord);
+    JitContext::instance().shareCode(reinterpret_cast<const void *>(executable));
     latestWordAdded = newWord; // Update the latest word
     latestWordName = wordName; // Update the latest word name
     wordOrder.push_back(newWord); // Track addition order
@@ -159,50 +163,55 @@ ForthDictionaryEntry *ForthDictionary::addCodeWord(
 
     // Update the head of the list for this word length
     dictionaryLists[length] = newWord;
+    indexEntry(newWord);
+    JitContext::instance().shareCode(reinterpret_cast<const void *>(executable));
     latestWordAdded = newWord; // Update the latest word
     latestWordName = wordName; // Update the latest word name
     wordOrder.push_back(newWord); // Track addition order
     return newWord; // Return the newly added entry
 }
 
+// Copy name upper cased into buffer, false if it does not fit a word name
+static bool foldWordName(const char *name, char (&buffer)[MAX_WORD_LENGTH], size_t &length) {
+    length = 0;
+    while (name[length]) {
+        if (length >= MAX_WORD_LENGTH - 1) {
+            return false;
+        }
+        buffer[length] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[length])));
+        ++length;
+    }
+    buffer[length] = '\0';
+    return true;
+}
+
 ForthDictionaryEntry *ForthDictionary::findWord(const char *name) const {
     if (!name) {
         throw std::invalid_argument("Name cannot be null!");
     }
 
-    // uppercase the name
-    std::string nameStr(name);
-    std::transform(nameStr.begin(), nameStr.end(), nameStr.begin(), ::toupper);
-    name = nameStr.c_str();
-
-
-    size_t length = std::strlen(name);
-    if (length >= MAX_WORD_LENGTH) {
+    // uppercase the name, on the stack
+    char folded[MAX_WORD_LENGTH];
+    size_t length;
+    if (!foldWordName(name, folded, length)) {
         return nullptr; // Word is too long, invalid
     }
+    return findWord(std::string_view(folded, length));
+}
 
-    auto word_id = SymbolTable::instance().addSymbol(name);
-
-    // Create a set of vocab IDs prioritized by search order
-    std::unordered_set<size_t> vocabSet;
-    for (const auto &vocab: searchOrder) {
-        if (vocab != nullptr) {
-            vocabSet.insert(vocab->vocab_id);
-        }
+ForthDictionaryEntry *ForthDictionary::findWord(const std::string_view name) const {
+    if (name.size() >= MAX_WORD_LENGTH) {
+        return nullptr; // Word is too long, invalid
     }
 
-    // Iterate over words of the same length
-    ForthDictionaryEntry *current = dictionaryLists[length];
-    while (current) {
-        // Check both word ID and vocab ID
-        if (current->word_id == word_id && vocabSet.count(current->vocab_id) > 0) {
-            latestWordFound = current; // Update latest found word
-            return current;
-        }
-        current = current->previous;
-    }
+    // a miss must not add the name to the symbol table
+    const auto word_id = SymbolTable::instance().findSymbol(name);
 
-    return nullptr; // Word not found
+    ForthDictionaryEntry *found = lookup(word_id);
+    if (found) {
+        latestWordFound = found; // Update latest found word
+    }
+    return found;
 }
 
 
@@ -211,38 +220,19 @@ bool ForthDictionary::isVariable(const char *name) const {
         throw std::invalid_argument("Name cannot be null!");
     }
 
-    // uppercase the name
-    std::string nameStr(name);
-    std::transform(nameStr.begin(), nameStr.end(), nameStr.begin(), ::toupper);
-    name = nameStr.c_str();
-
-    size_t length = std::strlen(name);
-    if (length >= MAX_WORD_LENGTH) {
+    // uppercase the name, on the stack
+    char folded[MAX_WORD_LENGTH];
+    size_t length;
+    if (!foldWordName(name, folded, length)) {
         return false; // Word is too long, invalid
     }
 
-    auto word_id = SymbolTable::instance().findSymbol(name);
-    if (word_id == 0) return false;
-
-    // Create a set of vocab IDs prioritized by search order
-    std::unordered_set<size_t> vocabSet;
-    for (const auto &vocab: searchOrder) {
-        if (vocab != nullptr) {
-            vocabSet.insert(vocab->vocab_id);
-        }
-    }
-
-    // Iterate over words of the same length
-    ForthDictionaryEntry *current = dictionaryLists[length];
-    while (current) {
-        // Check both word ID and vocab ID
-        if (current->word_id == word_id && vocabSet.count(current->vocab_id) > 0) {
-            return (current->type == ForthWordType::VARIABLE);
-        }
-        current = current->previous;
-    }
+    return isVariable(SymbolTable::instance().findSymbol(std::string_view(folded, length)));
+}
 
-    return false; // Word not found
+bool ForthDictionary::isVariable(const uint32_t word_id) const {
+    const ForthDictionaryEntry *found = lookup(word_id);
+    return found && found->type == ForthWordType::VARIABLE;
 }
 
 
@@ -268,26 +258,66 @@ ForthDictionaryEntry *ForthDictionary::findWordByToken(const ForthToken &word) c
         return nullptr; // Word length is invalid
     }
 
-    // Create a set of vocab IDs from the search order for fast lookup
-    std::unordered_set<size_t> vocabSet;
-    for (const auto &vocab: searchOrder) {
-        if (vocab != nullptr) {
-            vocabSet.insert(vocab->vocab_id);
+    ForthDictionaryEntry *found = lookup(word.word_id);
+    if (found) {
+        latestWordFound = found; // Update latest found word
+    }
+    return found;
+}
+
+
+ForthDictionaryEntry *ForthDictionary::findWordById(const uint32_t word_id) const {
+    return lookup(word_id);
+}
+
+
+ForthDictionaryEntry *ForthDictionary::lookup(const uint32_t word_id) const {
+    if (word_id == 0) {
+        return nullptr;
+    }
+    // First vocabulary in the search order wins, within a vocabulary the newest entry
+    for (const uint32_t vocab_id: searchVocabIds) {
+        if (ForthDictionaryEntry *entry = index.find(makeId(word_id, vocab_id))) {
+            return entry;
         }
     }
+    return nullptr;
+}
 
-    // Traverse the linked list for the given word length
-    ForthDictionaryEntry *current = dictionaryLists[word.word_len];
-    while (current) {
-        // Check for both vocab ID and word ID match
-        if (vocabSet.count(current->vocab_id) > 0 && current->word_id == word.word_id) {
-            latestWordFound = current; // Update latest found word
-            return current; // Found the word
+void ForthDictionary::indexEntry(ForthDictionaryEntry *entry) {
+    index.insert(entry->id, entry);
+    ++entryUsers[entry->id];
+    ++nameUsers[entry->word_id];
+}
+
+// Remove an entry from the index, re-exposing any older entry it shadowed.
+void ForthDictionary::unindexEntry(ForthDictionaryEntry *entry) {
+    if (const auto it = entryUsers.find(entry->id); it != entryUsers.end() && --it->second == 0) {
+        entryUsers.erase(it);
+    }
+    if (const auto it = nameUsers.find(entry->word_id); it != nameUsers.end() && --it->second == 0) {
+        nameUsers.erase(it);
+    }
+    if (index.find(entry->id) != entry) {
+        return; // already shadowed by a newer definition
+    }
+    for (ForthDictionaryEntry *older = entry->previous; older; older = older->previous) {
+        if (older->id == entry->id) {
+            index.insert(older->id, older);
+            return;
         }
-        current = current->previous;
     }
+    index.erase(entry->id);
+}
 
-    return nullptr; // Word not found
+void ForthDictionary::rebuildSearchCache() {
+    searchVocabIds.clear();
+    for (const auto *vocab: searchOrder) {
+        if (vocab != nullptr &&
+            std::find(searchVocabIds.begin(), searchVocabIds.end(), vocab->vocab_id) == searchVocabIds.end()) {
+            searchVocabIds.push_back(vocab->vocab_id);
+        }
+    }
 }
 
 
@@ -307,25 +337,22 @@ ForthDictionaryEntry *ForthDictionary::addWord(const char *name, ForthState stat
         throw std::invalid_argument("Name or vocabulary cannot be empty!");
     }
 
-    // uppercase the name
-    std::string nameStr(name);
-    std::transform(nameStr.begin(), nameStr.end(), nameStr.begin(), ::toupper);
-    name = nameStr.c_str();
-
-    // uppercase the vocab name
-    std::string vocabNameStr(vocabName);
-    std::transform(vocabNameStr.begin(), vocabNameStr.end(), vocabNameStr.begin(), ::toupper);
-
-
-    size_t length = std::strlen(name);
-    if (length >= MAX_WORD_LENGTH) {
+    // uppercase the name and vocab name, on the stack
+    char folded[MAX_WORD_LENGTH];
+    size_t length;
+    if (!foldWordName(name, folded, length)) {
         throw std::length_error("Word length exceeds the maximum allowed size.");
     }
+    char foldedVocab[MAX_WORD_LENGTH];
+    size_t vocabLength;
+    if (!foldWordName(vocabName.c_str(), foldedVocab, vocabLength)) {
+        throw std::invalid_argument("Vocabulary not found!");
+    }
 
     // Get the current head of the list for this word length
     ForthDictionaryEntry *oldHead = dictionaryLists[length]; // Current head of the chain
 
-    ForthDictionaryEntry *vocab = findVocab(vocabName.c_str());
+    ForthDictionaryEntry *vocab = findVocab(foldedVocab);
     if (!vocab) {
         throw std::invalid_argument("Vocabulary not found!");
     }
@@ -335,11 +362,13 @@ ForthDictionaryEntry *ForthDictionary::addWord(const char *name, ForthState stat
         throw std::bad_alloc{};
     }
 
-    auto *newWord = new(memory) ForthDictionaryEntry(oldHead, name, vocabName, state, type);
+    auto *newWord = new(memory) ForthDictionaryEntry(oldHead, std::string_view(folded, length),
+                                                     std::string_view(foldedVocab, vocabLength), state, type);
 
 
     // Update the head of the list for this word length
     dictionaryLists[length] = newWord;
+    indexEntry(newWord);
 
     latestWordAdded = newWord; // Update the latest word
 
@@ -352,19 +381,21 @@ ForthDictionaryEntry *ForthDictionary::findVocab(const char *name) {
     if (!name) {
         throw std::invalid_argument("Name cannot be null!");
     }
-    size_t length = std::strlen(name);
-    if (length >= MAX_WORD_LENGTH) {
+    // uppercase the name, on the stack, FORTH and forth are one vocabulary as for words
+    char folded[MAX_WORD_LENGTH];
+    size_t length;
+    if (!foldWordName(name, folded, length)) {
         return nullptr; // Word is too long, invalid
     }
-    auto vocab_id = SymbolTable::instance().addSymbol(name);
-    ForthDictionaryEntry *current = dictionaryLists[length]; // Start with the chain for the correct word length
-    while (current) {
-        // Compare word name and vocabulary address to find the match
-        if (current->vocab_id == vocab_id) {
-            latestVocabFound = current; // Update the latest vocabulary
-            return current; // Found the word
-        }
-        current = current->previous; // Traverse the chain backward
+    auto vocab_id = SymbolTable::instance().findSymbol(std::string_view(folded, length));
+    if (vocab_id == 0) {
+        return nullptr;
+    }
+    // A vocabulary entry is filed under its own name in itself
+    ForthDictionaryEntry *vocab = index.find(makeId(vocab_id, vocab_id));
+    if (vocab && vocab->type == ForthWordType::VOCABULARY) {
+        latestVocabFound = vocab; // Update the latest vocabulary
+        return vocab;
     }
     return nullptr; // Word not found
 }
@@ -419,7 +450,7 @@ void ForthDictionary::setVocabulary(const std::string &vocabName) {
     if (!findVocab(vocabName.c_str())) {
         throw std::invalid_argument("Vocabulary " + vocabName + " does not exist.");
     }
-    currentVocabulary = findWord(vocabName.c_str());
+    currentVocabulary = findVocab(vocabName.c_str());
     // std::cout << "Current vocabulary set to: " << vocabName << "\n";
 }
 
@@ -439,15 +470,17 @@ void ForthDictionary::setSearchOrder(const std::vector<std::string> &order) {
         ForthDictionaryEntry *vocab = findVocab(vocabName.c_str());
         searchOrder.push_back(vocab); // Add pointers to vocabularies to the search order
     }
+    rebuildSearchCache();
 }
 
 void ForthDictionary::addSearchOrder(const std::string &vocabName) {
-    ForthDictionaryEntry *vocab = findWord(vocabName.c_str());
+    ForthDictionaryEntry *vocab = findVocab(vocabName.c_str());
     if (!vocab) {
         throw std::invalid_argument("Vocabulary " + vocabName + " does not exist.");
     }
     if (std::find(searchOrder.begin(), searchOrder.end(), vocab) == searchOrder.end()) {
         searchOrder.push_back(vocab); // Add to the search order if not already present
+        rebuildSearchCache();
     } else {
         throw std::logic_error("Vocabulary already exists in the search order.");
     }
@@ -455,7 +488,8 @@ void ForthDictionary::addSearchOrder(const std::string &vocabName) {
 
 void ForthDictionary::resetSearchOrder() {
     searchOrder.clear();
-    searchOrder.push_back(findWord("FORTH"));
+    searchOrder.push_back(findVocab("FORTH"));
+    rebuildSearchCache();
 }
 
 
@@ -498,10 +532,12 @@ ForthDictionaryEntry *ForthDictionary::createVocabulary(const std::string &vocab
 
     vocabEntry->previous = oldHead; // Link to previous entry in the list
     dictionaryLists[length] = vocabEntry; // Update the head of the list
+    indexEntry(vocabEntry);
 
     // Automatically add to the search order
-    if (std::find(searchOrder.begin(), searchOrder.end(), findWord(vocabName.c_str())) == searchOrder.end()) {
-        searchOrder.push_back(findWord(vocabName.c_str()));
+    if (std::find(searchOrder.begin(), searchOrder.end(), vocabEntry) == searchOrder.end()) {
+        searchOrder.push_back(vocabEntry);
+        rebuildSearchCache();
     }
 
     // std::cout << "Created vocabulary: " << vocabName << "\n";
@@ -529,7 +565,7 @@ std::string ForthDictionary::getCurrentVocabularyName() {
     if (!currentVocabulary) {
         currentVocabulary = findVocab("FORTH");
     }
-    return {SymbolTable::instance().getSymbol(currentVocabulary->vocab_id)};
+    return std::string(SymbolTable::instance().getSymbol(currentVocabulary->vocab_id));
 }
 
 //
@@ -537,6 +573,39 @@ ForthDictionaryEntry *ForthDictionary::getLatestWordAdded() const {
     return latestWordAdded;
 }
 
+// Forget every word added after marker, and marker itself
+void ForthDictionary::forgetTo(const ForthDictionaryEntry *marker) {
+    if (std::find(wordOrder.begin(), wordOrder.end(), marker) == wordOrder.end()) {
+        std::cerr << "Error: Marker not found.\n";
+        return;
+    }
+    while (!wordOrder.empty()) {
+        const bool last = wordOrder.back() == marker;
+        forgetLastWord();
+        if (last) break;
+    }
+}
+
+void ForthDictionary::releaseForgottenSymbols() const {
+    auto &symbols = SymbolTable::instance();
+    if (!symbols.hasForgotten()) return;
+
+    std::unordered_set<uint32_t> named;
+    auto nameTokens = [&named](const std::vector<ForthToken> &tokens) {
+        for (const ForthToken &token: tokens) {
+            if (token.word_id) named.insert(token.word_id);
+        }
+    };
+    forEachEntry([&nameTokens](const ForthDictionaryEntry *entry) {
+        if (entry->inlineBody) nameTokens(entry->inlineBody->tokens);
+        if (entry->tierProfile) nameTokens(entry->tierProfile->tokens);
+    });
+    const Peephole &peephole = Peephole::instance();
+    symbols.releaseForgotten([&named, &peephole](const uint32_t id) {
+        return named.count(id) != 0 || peephole.usesSymbol(id);
+    });
+}
+
 // get latest WordName
 std::string ForthDictionary::getLatestName() {
     return latestWordName;
@@ -560,6 +629,25 @@ void ForthDictionary::addToCache(const std::string &name, ForthDictionaryEntry *
     wordCache.push_back({name, entry});
 }
 
+void ForthDictionary::setExecutable(const ForthDictionaryEntry *entry, const ForthFunction executable) {
+    auto &jit = JitContext::instance();
+    jit.unshareCode(reinterpret_cast<const void *>(entry->executable));
+    jit.shareCode(reinterpret_cast<const void *>(executable));
+    __atomic_store_n(&entry->executable, executable, __ATOMIC_RELEASE);
+}
+
+bool ForthDictionary::executableInUse(const void *code, const ForthDictionaryEntry *except) const {
+    bool used = false;
+    forEachEntry([code, except, &used](const ForthDictionaryEntry *entry) {
+        if (entry == except) return;
+        if (reinterpret_cast<const void *>(entry->executable) == code ||
+            (entry->tierProfile && reinterpret_cast<const void *>(entry->tierProfile->baseline) == code)) {
+            used = true;
+        }
+    });
+    return used;
+}
+
 void ForthDictionary::forgetLastWord() {
     if (wordOrder.empty()) {
         std::cerr << "Error: No word to forget.\n";
@@ -572,25 +660,32 @@ void ForthDictionary::forgetLastWord() {
 
     std::cout << "Forgetting word: " << latestWordName << "\n";
 
-    const size_t length = latestWordName.size();
-
-    if (wordToForget->executable) {
-        // free asmjit memory
-        if (const auto runtime = &JitContext::instance()._rt) {
-            runtime->release(wordToForget->executable);
-            wordToForget->executable = nullptr;
-            runtime->release(wordToForget->immediate_interpreter);
-            wordToForget->immediate_interpreter = nullptr;
-            runtime->release(wordToForget->generator);
-            wordToForget->generator = nullptr;
-            runtime->release(wordToForget->immediate_compiler);
-            wordToForget->immediate_compiler = nullptr;
-        }
-    }
+    const size_t length = wordToForget->getWordName().size();
 
+    // Another live entry may share the code or, under the same id, the WordHeap allocation
+    // A recompiled word also owns the code it was first compiled to
+    TierProfile *profile = wordToForget->tierProfile;
+    const ForthFunction baseline = profile && profile->baseline != wordToForget->executable ? profile->baseline : nullptr;
+    const auto code = reinterpret_cast<const void *>(wordToForget->executable);
+    setExecutable(wordToForget, nullptr);
+
+    // free asmjit memory, only JIT code this word owns; the other fields are C++ functions
+    auto &jit = JitContext::instance();
+    if (code && jit.codeUsers(code) == 0 && jit.ownsCode(code) && !executableInUse(code, wordToForget)) {
+        jit.releaseCode(code);
+    }
+    const auto baselineCode = reinterpret_cast<const void *>(baseline);
+    if (baseline && jit.codeUsers(baselineCode) == 0 && jit.ownsCode(baselineCode) &&
+        !executableInUse(baselineCode, wordToForget)) {
+        jit.releaseCode(baselineCode);
+    }
 
     // Free any associated memory from WordHeap
-    WordHeap::instance().deallocate(wordToForget->word_id);
+    const auto dataUsers = entryUsers.find(wordToForget->id);
+    if (dataUsers == entryUsers.end() || dataUsers->second <= 1) {
+        WordHeap::instance().deallocate(wordToForget->id);
+        Tokenizer::instance().forget_base();
+    }
 
     // Update dictionaryLists to remove the entry
     auto removeFromChain = [](ForthDictionaryEntry *&head, ForthDictionaryEntry *entry) {
@@ -612,9 +707,12 @@ void ForthDictionary::forgetLastWord() {
     if (!removeFromChain(dictionaryLists[length], wordToForget)) {
         std::cerr << "Error: Word not found in dictionary lists.\n";
     }
+    unindexEntry(wordToForget);
 
-    // Forget the word's name from the SymbolTable
-    SymbolTable::instance().forgetSymbol(latestWordName);
+    // Forget the word's name from the SymbolTable, unless an older definition still uses it
+    if (nameUsers.count(wordToForget->word_id) == 0) {
+        SymbolTable::instance().forgetSymbol(wordToForget->getWordName());
+    }
 
     // Update the latest word
     if (!wordOrder.empty()) {
@@ -635,5 +733,11 @@ void ForthDictionary::forgetLastWord() {
         unusedVocabularyStorage.end());
 
     // Finally, delete the word itself
+    delete wordToForget->inlineBody;
+    if (profile && profile->pending) {
+        profile->entry = nullptr; // still queued, deleted by code_generator_run_pending_tier_ups
+    } else {
+        delete profile;
+    }
     delete wordToForget;
 }
@@ -33,18 +33,20 @@ void Interpreter::handle_word(std::deque<ForthToken> &tokens) {
         return;
 
     const ForthDictionary &dict = ForthDictionary::instance();
-    const ForthToken &first = tokens.front();
+    const ForthToken first = tokens.front(); // copy, pop_front destroys the element
     tokens.pop_front(); // Efficiently remove the first token
 
     if (first.type == TokenType::TOKEN_WORD || first.type == TokenType::TOKEN_VARIABLE) {
         auto word_found = dict.findWordByToken(first);
         if (word_found == nullptr) {
-            raise_error(5, "Word not found: " + first.value);
+            raise_error(5, "Word not found: " + std::string(first.value));
             return;
         }
 
         if (word_found->executable) {
             word_found->executable();
+            code_generator_run_pending_tier_ups();
+            code_generator_run_pending_marker();
         } else if (word_found->immediate_interpreter && word_found->type != ForthWordType::MACRO) {
             word_found->immediate_interpreter(tokens);
         }
@@ -75,6 +77,21 @@ void Interpreter::handle_unknown(const ForthToken &first) {
 
 // Main entry point for interpreting Forth code
 void Interpreter::execute(const std::string &input) {
+    depth++;
+    interpret(input);
+    // INCLUDE runs its lines inside the outer line, whose tokens may still hold forgotten ids
+    if (--depth == 0) {
+        ForthDictionary::instance().releaseForgottenSymbols();
+    }
+}
+
+// An error left the lines being interpreted, their tokens are gone
+void Interpreter::recover() {
+    depth = 0;
+    ForthDictionary::instance().releaseForgottenSymbols();
+}
+
+void Interpreter::interpret(const std::string &input) {
     // Check if the input contains "LET"
     if (input.find("LET") != std::string::npos) {
         Compiler::instance().compile_let(input);
@@ -86,8 +103,11 @@ void Interpreter::execute(const std::string &input) {
 
     // Tokenize the input into Forth tokens
     Tokenizer::instance().tokenize_forth(input, tokens);
+    int base = Tokenizer::instance().token_base();
 
     while (!tokens.empty()) {
+        // a word just run may have changed BASE
+        Tokenizer::instance().rebase(tokens, base);
         ForthToken &first = tokens.front();
 
         // Use a switch structure for token processing
@@ -1,4 +1,5 @@
 #include "LetCodeGenerator.h"
+#include "MathKernels.h"
 #include <asmjit/asmjit.h> // Include assembler support
 #include <immintrin.h>
 #include <cmath>
@@ -468,6 +469,11 @@ void LetCodeGenerator::generateFunctionExpr(const Expression *expr) {
         tracker.freeRegister("_one");
         tracker.freeRegister("_mask");
         // Free the registers for the argument names.
+    } else if (mathAccuracy != MathAccuracy::LIBM && math_kernel_available(funcName) &&
+               argNameToReg.size() == (funcName == "pow" ? 2u : 1u)) {
+        // polynomial kernel inline, nothing to spill
+        emitMathKernel(funcName, argNameToReg[0].second,
+                       argNameToReg.size() == 2 ? argNameToReg[1].second : argNameToReg[0].second);
     } else
 
     // Check argument count and call the appropriate math function
@@ -710,7 +716,11 @@ void LetCodeGenerator::emitExponentiation(asmjit::x86::Xmm exprReg,
 
     // Slow path: Using pow(x, y)
     assembler->bind(usePow);
-    callMathFunction("pow", lhsReg, rhsReg); // Call pow(lhs, rhs)
+    if (mathAccuracy != MathAccuracy::LIBM) {
+        emitMathKernel("pow", lhsReg, rhsReg);
+    } else {
+        callMathFunction("pow", lhsReg, rhsReg); // Call pow(lhs, rhs)
+    }
 
     // Store result into exprReg
     if (exprReg.id() != 0) {
@@ -723,6 +733,24 @@ void LetCodeGenerator::emitExponentiation(asmjit::x86::Xmm exprReg,
 }
 
 
+// name(arg1[, arg2]) into xmm0 by a MathKernels polynomial
+void LetCodeGenerator::emitMathKernel(const std::string &funcName, const asmjit::x86::Xmm &arg1Reg,
+                                      const asmjit::x86::Xmm &arg2Reg) {
+    asmjit::x86::Assembler *assembler;
+    initialize_assembler(assembler);
+
+    assembler->commentf("; ====== inline math: %s", funcName.c_str());
+    asmjit::x86::Xmm scratch[MATH_KERNEL_SCRATCH];
+    for (int i = 0; i < MATH_KERNEL_SCRATCH; i++) {
+        scratch[i] = tracker.allocateRegister("_kernel" + std::to_string(i));
+    }
+    math_kernel_emit(*assembler, funcName, mathAccuracy, asmjit::x86::xmm0, arg1Reg, arg2Reg, scratch);
+    for (int i = 0; i < MATH_KERNEL_SCRATCH; i++) {
+        tracker.freeRegister("_kernel" + std::to_string(i));
+    }
+}
+
+
 using FunctionPtr = double(*)(double);
 std::unordered_map<std::string, FunctionPtr> SingleFuncMap = {
     {"sin", &sin},
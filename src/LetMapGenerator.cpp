@@ -0,0 +1,510 @@
+#include "LetMapGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cpuid.h>
+#include <cstring>
+#include <iostream>
+#include "CodeGenerator.h"
+#include "RegisterTracker.h"
+#include "SignalHandler.h"
+
+// array addresses, in the order of the stack arguments
+static const asmjit::x86::Gp arrayRegisters[] = {
+    asmjit::x86::rsi, asmjit::x86::rdi, asmjit::x86::r8, asmjit::x86::r9,
+    asmjit::x86::r10, asmjit::x86::r11, asmjit::x86::rbx
+};
+
+LetMapGenerator::Isa LetMapGenerator::select_isa() {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        // AVX512DQ (bit 17 of EBX) for vandpd and vxorpd on ZMM, AVX512VL (bit 31) for XMM16-31 in the tail
+        if (RegisterTracker::isAVX512Supported() && (ebx & (1u << 17)) && (ebx & (1u << 31))) {
+            return Isa::AVX512;
+        }
+        // AVX2 (bit 5 of EBX) for vbroadcastsd from a register
+        if (ebx & (1u << 5)) {
+            return Isa::AVX2;
+        }
+    }
+    return Isa::SSE2;
+}
+
+int LetMapGenerator::lanes(const Isa isa) {
+    switch (isa) {
+        case Isa::AVX512: return 8;
+        case Isa::AVX2: return 4;
+        default: return 2;
+    }
+}
+
+void LetMapGenerator::limit_isa(const Isa widest) {
+    widestIsa = widest;
+}
+
+void LetMapGenerator::generateCode(const LetStatement *letStmt) {
+    using namespace asmjit::x86;
+    if (!letStmt) return;
+    if (initialize_assembler(assembler)) {
+        SignalHandler::instance().raise(10);
+        return;
+    }
+
+    isa = std::min(select_isa(), widestIsa);
+    const int registers = isa == Isa::AVX512 ? 32 : 16;
+    const int width = lanes(isa);
+
+    const int inputCount = static_cast<int>(letStmt->inputParams.size());
+    const int arrays = inputCount + static_cast<int>(letStmt->outputVars.size());
+    if (arrays > MAX_ARRAYS) {
+        std::cerr << "LET-MAP: at most " << MAX_ARRAYS << " input and output arrays" << std::endl;
+        SignalHandler::instance().raise(22);
+        return;
+    }
+    for (const auto &wc: letStmt->whereClauses) {
+        if (!vectorizable(wc->expr.get())) {
+            SignalHandler::instance().raise(22);
+            return;
+        }
+    }
+    for (const auto &expr: letStmt->expressions) {
+        if (!vectorizable(expr.get())) {
+            SignalHandler::instance().raise(22);
+            return;
+        }
+    }
+
+    // one register per input and WHERE variable, then the hoisted constants, then temporaries
+    inputs.clear();
+    invariantWheres.clear();
+    variables.clear();
+    constants.clear();
+    int next = 0;
+    for (const auto &param: letStmt->inputParams) {
+        inputs.insert(param);
+        variables[param] = next++;
+    }
+    std::set<uint64_t> bits;
+    for (const auto &wc: letStmt->whereClauses) {
+        variables[wc->varName] = next++;
+        if (invariant(wc->expr.get())) invariantWheres.insert(wc->varName);
+        collectConstants(wc->expr.get(), bits);
+    }
+    for (const auto &expr: letStmt->expressions) {
+        collectConstants(expr.get(), bits);
+    }
+
+    const auto temporariesNeeded = [&]() {
+        int needed = 0;
+        for (const auto &wc: letStmt->whereClauses) needed = std::max(needed, temporaries(wc->expr.get()));
+        for (const auto &expr: letStmt->expressions) needed = std::max(needed, temporaries(expr.get()));
+        return needed;
+    };
+    // keep the constants in registers if they fit, otherwise load them where they are used
+    hoisting = true;
+    if (next + static_cast<int>(bits.size()) + temporariesNeeded() > registers) hoisting = false;
+    firstTemporary = next + (hoisting ? static_cast<int>(bits.size()) : 0);
+    if (firstTemporary + temporariesNeeded() > registers) {
+        std::cerr << "LET-MAP: the statement needs more than " << registers << " vector registers" << std::endl;
+        SignalHandler::instance().raise(22);
+        return;
+    }
+    if (hoisting) {
+        for (const uint64_t b: bits) constants[b] = next++;
+    }
+
+    assembler->commentf("; -- LET-MAP, %d lanes per iteration", width);
+    for (int k = 0; k < arrays; k++) {
+        assembler->push(arrayRegisters[k]);
+    }
+
+    assembler->comment("; ( in-addr ... out-addr ... n -- )");
+    const int items = arrays + 1;
+    assembler->mov(rdx, r13);
+    for (int k = 0; k < arrays; k++) {
+        const int fromTop = items - 1 - k;
+        if (fromTop == 1) {
+            assembler->mov(arrayRegisters[k], r12);
+        } else {
+            assembler->mov(arrayRegisters[k], qword_ptr(r15, (fromTop - 2) * 8));
+        }
+    }
+    assembler->mov(r13, qword_ptr(r15, (items - 2) * 8));
+    assembler->mov(r12, qword_ptr(r15, (items - 1) * 8));
+    assembler->add(r15, items * 8);
+
+    packed = true;
+    if (!constants.empty()) assembler->comment("; -- hoisted constants");
+    for (const auto &[b, reg]: constants) {
+        loadConstant(b, reg);
+    }
+    for (const auto &wc: letStmt->whereClauses) {
+        if (invariantWheres.count(wc->varName) == 0) continue;
+        assembler->commentf("; -- hoisted WHERE %s", wc->varName.c_str());
+        const int reg = emit(wc->expr.get(), 0);
+        emitOp(Op::MOV, variables.at(wc->varName), reg, reg);
+    }
+    assembler->xor_(ecx, ecx);
+
+    const auto loop = [&](const int step) {
+        const asmjit::Label top = assembler->newLabel();
+        const asmjit::Label done = assembler->newLabel();
+        assembler->bind(top);
+        if (step > 1) {
+            assembler->lea(rax, ptr(rcx, step));
+            assembler->cmp(rax, rdx);
+            assembler->jg(done);
+        } else {
+            assembler->cmp(rcx, rdx);
+            assembler->jge(done);
+        }
+        for (int k = 0; k < inputCount; k++) {
+            load(k, arrayRegisters[k]);
+        }
+        for (const auto &wc: letStmt->whereClauses) {
+            if (invariantWheres.count(wc->varName) != 0) continue;
+            const int reg = emit(wc->expr.get(), 0);
+            emitOp(Op::MOV, variables.at(wc->varName), reg, reg);
+        }
+        for (size_t k = 0; k < letStmt->expressions.size(); k++) {
+            const int reg = emit(letStmt->expressions[k].get(), 0);
+            store(reg, arrayRegisters[inputCount + static_cast<int>(k)]);
+        }
+        assembler->add(rcx, step);
+        assembler->jmp(top);
+        assembler->bind(done);
+    };
+
+    assembler->comment("; -- packed loop");
+    loop(width);
+    if (isa != Isa::SSE2) assembler->vzeroupper();
+    assembler->comment("; -- one element at a time for the rest");
+    packed = false;
+    loop(1);
+
+    for (int k = arrays - 1; k >= 0; k--) {
+        assembler->pop(arrayRegisters[k]);
+    }
+}
+
+bool LetMapGenerator::vectorizable(const Expression *expr) const {
+    if (!expr) return false;
+    long exponent = 0;
+    switch (expr->type) {
+        case ExprType::LITERAL:
+        case ExprType::CONSTANT:
+        case ExprType::VARIABLE:
+            return true;
+        case ExprType::UNARY_OP:
+            return expr->value == "neg" && expr->children.size() == 1 && vectorizable(expr->children[0].get());
+        case ExprType::BINARY_OP:
+            if (expr->children.size() != 2) return false;
+            if (expr->value == "^") {
+                if (!integerExponent(expr->children[1].get(), exponent)) {
+                    std::cerr << "LET-MAP: ^ needs an integer literal exponent" << std::endl;
+                    return false;
+                }
+                return vectorizable(expr->children[0].get());
+            }
+            if (expr->value != "+" && expr->value != "-" && expr->value != "*" && expr->value != "/") {
+                std::cerr << "LET-MAP: unknown operator " << expr->value << std::endl;
+                return false;
+            }
+            return vectorizable(expr->children[0].get()) && vectorizable(expr->children[1].get());
+        case ExprType::FUNCTION: {
+            const std::string &name = expr->value;
+            if ((name == "sqrt" || name == "fabs" || name == "abs") && expr->children.size() == 1) {
+                return vectorizable(expr->children[0].get());
+            }
+            if ((name == "fmin" || name == "fmax") && expr->children.size() == 2) {
+                return vectorizable(expr->children[0].get()) && vectorizable(expr->children[1].get());
+            }
+            if (name == "pow" && expr->children.size() == 2) {
+                if (!integerExponent(expr->children[1].get(), exponent)) {
+                    std::cerr << "LET-MAP: pow needs an integer literal exponent" << std::endl;
+                    return false;
+                }
+                return vectorizable(expr->children[0].get());
+            }
+            std::cerr << "LET-MAP: " << name << " has no vector form, use LET" << std::endl;
+            return false;
+        }
+    }
+    return false;
+}
+
+bool LetMapGenerator::invariant(const Expression *expr) const {
+    switch (expr->type) {
+        case ExprType::LITERAL:
+            return true;
+        case ExprType::CONSTANT:
+        case ExprType::VARIABLE:
+            return inputs.count(expr->value) == 0 && invariantWheres.count(expr->value) != 0;
+        default:
+            return std::all_of(expr->children.begin(), expr->children.end(),
+                               [this](const auto &child) { return invariant(child.get()); });
+    }
+}
+
+void LetMapGenerator::collectConstants(const Expression *expr, std::set<uint64_t> &bits) const {
+    long exponent = 0;
+    switch (expr->type) {
+        case ExprType::LITERAL:
+            bits.insert(literalBits(expr));
+            return;
+        case ExprType::CONSTANT:
+        case ExprType::VARIABLE:
+            return;
+        case ExprType::UNARY_OP:
+            bits.insert(SIGN_BIT);
+            break;
+        case ExprType::BINARY_OP:
+        case ExprType::FUNCTION:
+            if (expr->value == "^" || expr->value == "pow") {
+                integerExponent(expr->children[1].get(), exponent);
+                if (exponent <= 0) bits.insert(ONE);
+                collectConstants(expr->children[0].get(), bits);
+                return;
+            }
+            if (expr->value == "fabs" || expr->value == "abs") bits.insert(ABS_MASK);
+            break;
+    }
+    for (const auto &child: expr->children) {
+        collectConstants(child.get(), bits);
+    }
+}
+
+int LetMapGenerator::temporaries(const Expression *expr) const {
+    long exponent = 0;
+    switch (expr->type) {
+        case ExprType::LITERAL:
+            return hoisting ? 0 : 1;
+        case ExprType::CONSTANT:
+        case ExprType::VARIABLE:
+            return 0;
+        case ExprType::UNARY_OP:
+            return std::max(temporaries(expr->children[0].get()), hoisting ? 1 : 2);
+        case ExprType::BINARY_OP:
+        case ExprType::FUNCTION: {
+            const std::string &name = expr->value;
+            if (name == "^" || name == "pow") {
+                integerExponent(expr->children[1].get(), exponent);
+                if (exponent == 0) return hoisting ? 0 : 1;
+                return std::max(temporaries(expr->children[0].get()), 2);
+            }
+            if (name == "sqrt") return std::max(temporaries(expr->children[0].get()), 1);
+            if (name == "fabs" || name == "abs") {
+                return std::max(temporaries(expr->children[0].get()), hoisting ? 1 : 2);
+            }
+            // + - * / fmin fmax, the right operand goes above the left's result
+            return std::max({temporaries(expr->children[0].get()), 1 + temporaries(expr->children[1].get()), 1});
+        }
+    }
+    return 0;
+}
+
+int LetMapGenerator::emit(const Expression *expr, const int depth) {
+    long exponent = 0;
+    switch (expr->type) {
+        case ExprType::LITERAL:
+            return constant(literalBits(expr), depth);
+        case ExprType::CONSTANT:
+        case ExprType::VARIABLE:
+            return variables.at(expr->value);
+        case ExprType::UNARY_OP: {
+            const int operand = emit(expr->children[0].get(), depth);
+            emitOp(Op::XOR, temp(depth), operand, constant(SIGN_BIT, depth + 1));
+            return temp(depth);
+        }
+        case ExprType::BINARY_OP:
+        case ExprType::FUNCTION: {
+            const std::string &name = expr->value;
+            if (name == "^" || name == "pow") {
+                integerExponent(expr->children[1].get(), exponent);
+                return emitPower(expr->children[0].get(), exponent, depth);
+            }
+            const int left = emit(expr->children[0].get(), depth);
+            if (name == "sqrt") {
+                emitOp(Op::SQRT, temp(depth), left, left);
+                return temp(depth);
+            }
+            if (name == "fabs" || name == "abs") {
+                emitOp(Op::AND, temp(depth), left, constant(ABS_MASK, depth + 1));
+                return temp(depth);
+            }
+            const int right = emit(expr->children[1].get(), depth + 1);
+            Op op = Op::ADD;
+            if (name == "-") op = Op::SUB;
+            else if (name == "*") op = Op::MUL;
+            else if (name == "/") op = Op::DIV;
+            else if (name == "fmin") op = Op::MIN;
+            else if (name == "fmax") op = Op::MAX;
+            emitOp(op, temp(depth), left, right);
+            return temp(depth);
+        }
+    }
+    return temp(depth);
+}
+
+// x^n by squaring: the result builds up in the temporary at depth, the powers of x above it
+int LetMapGenerator::emitPower(const Expression *base, const long exponent, const int depth) {
+    if (exponent == 0) return constant(ONE, depth);
+    const int x = emit(base, depth);
+    int result = x;
+    long n = std::labs(exponent);
+    if (n > 1) {
+        int power = x;
+        bool first = true;
+        while (n) {
+            if (n & 1) {
+                if (first) emitOp(Op::MOV, temp(depth), power, power);
+                else emitOp(Op::MUL, temp(depth), temp(depth), power);
+                first = false;
+            }
+            n >>= 1;
+            if (n) {
+                emitOp(Op::MUL, temp(depth + 1), power, power);
+                power = temp(depth + 1);
+            }
+        }
+        result = temp(depth);
+    }
+    if (exponent < 0) {
+        emitOp(Op::DIV, temp(depth + 1), constant(ONE, depth + 1), result);
+        emitOp(Op::MOV, temp(depth), temp(depth + 1), temp(depth + 1));
+        result = temp(depth);
+    }
+    return result;
+}
+
+int LetMapGenerator::constant(const uint64_t bits, const int depth) {
+    if (hoisting) return constants.at(bits);
+    loadConstant(bits, temp(depth));
+    return temp(depth);
+}
+
+// dst = a op b; b is never dst unless a is too, so SSE2's two operand forms can copy a first
+void LetMapGenerator::emitOp(const Op op, const int dst, const int a, const int b) {
+    using namespace asmjit::x86;
+    if (op == Op::MOV && dst == a) return;
+
+    if (isa == Isa::SSE2) {
+        const Xmm d = xmm(dst), x = xmm(a), y = xmm(b);
+        if (op == Op::SQRT) {
+            if (packed) assembler->sqrtpd(d, x);
+            else assembler->sqrtsd(d, x);
+            return;
+        }
+        if (dst != a) assembler->movapd(d, x);
+        switch (op) {
+            case Op::ADD: packed ? assembler->addpd(d, y) : assembler->addsd(d, y); break;
+            case Op::SUB: packed ? assembler->subpd(d, y) : assembler->subsd(d, y); break;
+            case Op::MUL: packed ? assembler->mulpd(d, y) : assembler->mulsd(d, y); break;
+            case Op::DIV: packed ? assembler->divpd(d, y) : assembler->divsd(d, y); break;
+            case Op::MIN: packed ? assembler->minpd(d, y) : assembler->minsd(d, y); break;
+            case Op::MAX: packed ? assembler->maxpd(d, y) : assembler->maxsd(d, y); break;
+            case Op::AND: assembler->andpd(d, y); break;
+            case Op::XOR: assembler->xorpd(d, y); break;
+            default: break;
+        }
+        return;
+    }
+
+    if (!packed) {
+        const Xmm d = xmm(dst), x = xmm(a), y = xmm(b);
+        switch (op) {
+            case Op::ADD: assembler->vaddsd(d, x, y); break;
+            case Op::SUB: assembler->vsubsd(d, x, y); break;
+            case Op::MUL: assembler->vmulsd(d, x, y); break;
+            case Op::DIV: assembler->vdivsd(d, x, y); break;
+            case Op::MIN: assembler->vminsd(d, x, y); break;
+            case Op::MAX: assembler->vmaxsd(d, x, y); break;
+            case Op::AND: assembler->vandpd(d, x, y); break;
+            case Op::XOR: assembler->vxorpd(d, x, y); break;
+            case Op::SQRT: assembler->vsqrtsd(d, x, x); break;
+            case Op::MOV: assembler->vmovapd(d, x); break;
+        }
+        return;
+    }
+
+    const auto vex = [&](const auto &d, const auto &x, const auto &y) {
+        switch (op) {
+            case Op::ADD: assembler->vaddpd(d, x, y); break;
+            case Op::SUB: assembler->vsubpd(d, x, y); break;
+            case Op::MUL: assembler->vmulpd(d, x, y); break;
+            case Op::DIV: assembler->vdivpd(d, x, y); break;
+            case Op::MIN: assembler->vminpd(d, x, y); break;
+            case Op::MAX: assembler->vmaxpd(d, x, y); break;
+            case Op::AND: assembler->vandpd(d, x, y); break;
+            case Op::XOR: assembler->vxorpd(d, x, y); break;
+            case Op::SQRT: assembler->vsqrtpd(d, x); break;
+            case Op::MOV: assembler->vmovapd(d, x); break;
+        }
+    };
+    if (isa == Isa::AVX512) vex(zmm(dst), zmm(a), zmm(b));
+    else vex(ymm(dst), ymm(a), ymm(b));
+}
+
+// every lane of reg = the double with these bits
+void LetMapGenerator::loadConstant(const uint64_t bits, const int reg) {
+    using namespace asmjit::x86;
+    assembler->mov(rax, asmjit::Imm(static_cast<int64_t>(bits)));
+    if (isa == Isa::SSE2) {
+        assembler->movq(xmm(reg), rax);
+        if (packed) assembler->unpcklpd(xmm(reg), xmm(reg));
+        return;
+    }
+    assembler->vmovq(xmm(reg), rax);
+    if (!packed) return;
+    if (isa == Isa::AVX512) assembler->vbroadcastsd(zmm(reg), xmm(reg));
+    else assembler->vbroadcastsd(ymm(reg), xmm(reg));
+}
+
+// element rcx of the array at base
+void LetMapGenerator::load(const int reg, const asmjit::x86::Gp &base) {
+    using namespace asmjit::x86;
+    if (!packed) {
+        if (isa == Isa::SSE2) assembler->movsd(xmm(reg), qword_ptr(base, rcx, 3));
+        else assembler->vmovsd(xmm(reg), qword_ptr(base, rcx, 3));
+    } else if (isa == Isa::AVX512) {
+        assembler->vmovupd(zmm(reg), zmmword_ptr(base, rcx, 3));
+    } else if (isa == Isa::AVX2) {
+        assembler->vmovupd(ymm(reg), ymmword_ptr(base, rcx, 3));
+    } else {
+        assembler->movupd(xmm(reg), xmmword_ptr(base, rcx, 3));
+    }
+}
+
+void LetMapGenerator::store(const int reg, const asmjit::x86::Gp &base) {
+    using namespace asmjit::x86;
+    if (!packed) {
+        if (isa == Isa::SSE2) assembler->movsd(qword_ptr(base, rcx, 3), xmm(reg));
+        else assembler->vmovsd(qword_ptr(base, rcx, 3), xmm(reg));
+    } else if (isa == Isa::AVX512) {
+        assembler->vmovupd(zmmword_ptr(base, rcx, 3), zmm(reg));
+    } else if (isa == Isa::AVX2) {
+        assembler->vmovupd(ymmword_ptr(base, rcx, 3), ymm(reg));
+    } else {
+        assembler->movupd(xmmword_ptr(base, rcx, 3), xmm(reg));
+    }
+}
+
+// a literal, or a negated literal, that is a whole number no larger than MAX_POWER
+bool LetMapGenerator::integerExponent(const Expression *expr, long &exponent) {
+    if (expr->type == ExprType::UNARY_OP && expr->children.size() == 1) {
+        if (!integerExponent(expr->children[0].get(), exponent)) return false;
+        exponent = -exponent;
+        return true;
+    }
+    if (expr->type != ExprType::LITERAL) return false;
+    const double value = std::stod(expr->value);
+    if (value != std::floor(value) || std::fabs(value) > MAX_POWER) return false;
+    exponent = static_cast<long>(value);
+    return true;
+}
+
+uint64_t LetMapGenerator::literalBits(const Expression *expr) {
+    const double value = std::stod(expr->value);
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
@@ -0,0 +1,559 @@
+#include "MathKernels.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Each kernel has two halves kept in step: the emitter, and a reference in C++ that
+// performs the same IEEE operations in the same order. Tests compare the JIT against the
+// reference bit for bit, and the reference against libm for the bounds in MathKernels.h.
+
+namespace {
+    using asmjit::x86::Assembler;
+    using asmjit::x86::Xmm;
+    namespace x86 = asmjit::x86;
+
+    double from_bits(const uint64_t bits) {
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d;
+    }
+
+    uint64_t to_bits(const double d) {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof bits);
+        return bits;
+    }
+
+    struct Poly {
+        const double *c;
+        int n;
+    };
+
+    template<int N>
+    Poly poly(const double (&c)[N]) { return {c, N}; }
+
+    constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+    constexpr uint64_t QUIET_NAN = 0x7FF8000000000000;
+    constexpr uint64_t MINUS_INFINITY = 0xFFF0000000000000;
+    constexpr uint64_t MANTISSA = 0x000FFFFFFFFFFFFF;
+    constexpr uint64_t TWO_54 = 0x4350000000000000; // scales a subnormal to a normal
+    constexpr uint64_t SQRT2_ROUND = 0x00095F619980C433; // 2^52 - mantissa of sqrt(2)
+
+    // pi/2 in three 33 bit parts, k * part is exact for |k| < 2^20
+    constexpr double INV_PIO2 = 6.36619772367581382433e-01;
+    constexpr double PIO2_1 = 1.57079632673412561417e+00;
+    constexpr double PIO2_2 = 6.07710050630396597660e-11;
+    constexpr double PIO2_3 = 2.02226624871116645580e-21;
+
+    // sin(r) = r + r^3 S(r^2), cos(r) = 1 - r^2/2 + r^4 C(r^2) for |r| <= pi/4;
+    // minimax, fdlibm's for PRECISE and single precision ones for FAST
+    constexpr double SIN_PRECISE[] = {
+        -1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04,
+        2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10
+    };
+    constexpr double COS_PRECISE[] = {
+        4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05,
+        -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11
+    };
+    constexpr double SIN_FAST[] = {-1.6666654611e-1, 8.3321608736e-3, -1.9515295891e-4};
+    constexpr double COS_FAST[] = {4.166664568298827e-2, -1.388731625493765e-3, 2.443315711809948e-5};
+
+    // exp(x) = 2^k exp(r), |r| <= ln2/2, exp(r) = 1 + r + r^2 E(r), Taylor
+    constexpr double INV_LN2 = 1.44269504088896338700e+00;
+    constexpr double LN2_HI = 6.93147180369123816490e-01;
+    constexpr double LN2_LO = 1.90821492927058770002e-10;
+    constexpr double EXP_LOW = -746.0; // below, exp underflows to 0
+    constexpr double EXP_HIGH = 710.0; // above, exp overflows to infinity
+    constexpr double EXP_PRECISE[] = {
+        1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320, 1.0 / 362880,
+        1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600, 1.0 / 6227020800, 1.0 / 87178291200
+    };
+    constexpr double EXP_FAST[] = {1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040};
+
+    // log(2^e (1+f)) = e ln2 + f - f^2/2 + s (f^2/2 + s^2 L(s^2)), s = f / (2+f), fdlibm's L
+    constexpr double LOG_PRECISE[] = {
+        6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01,
+        2.222219843214978396e-01, 1.818357216161805012e-01, 1.531383769920937332e-01,
+        1.479819860511658591e-01
+    };
+    constexpr double LOG_FAST[] = {
+        6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01,
+        2.222219843214978396e-01
+    };
+
+    // tanh(x) = m / (m + 2), m = exp(2|x|) - 1; below TANH_SMALL m = t M(t), Taylor
+    constexpr double TANH_SMALL = 1.0;
+    constexpr double TANH_LARGE = 40.0; // tanh is 1.0 from here
+    constexpr double EXPM1_PRECISE[] = {
+        1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320, 1.0 / 362880,
+        1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600, 1.0 / 6227020800, 1.0 / 87178291200,
+        1.0 / 1307674368000, 1.0 / 20922789888000, 1.0 / 355687428096000, 1.0 / 6402373705728000
+    };
+    constexpr double EXPM1_FAST[] = {
+        1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320, 1.0 / 362880,
+        1.0 / 3628800
+    };
+
+    bool precise(const MathAccuracy accuracy) { return accuracy != MathAccuracy::FAST; }
+
+    // ---- reference, one statement per instruction
+
+    double sse_max(const double a, const double b) { return a > b ? a : b; } // maxsd a, b
+    double sse_min(const double a, const double b) { return a < b ? a : b; } // minsd a, b
+
+    int64_t sse_cvt(const double d) { // cvtsd2si, out of range is 0x8000000000000000
+        return std::fabs(d) < 9.2e18 ? static_cast<int64_t>(d) : INT64_MIN;
+    }
+
+    double exponent(const uint64_t k) { return from_bits((k + 1023) << 52); }
+
+    double horner(const double z, const Poly &p) {
+        double acc = p.c[p.n - 1];
+        for (int i = p.n - 2; i >= 0; i--) {
+            acc = acc * z;
+            acc = acc + p.c[i];
+        }
+        return acc;
+    }
+
+    double reference_sincos(const double x, const bool cosine, const MathAccuracy accuracy) {
+        double kd = x * INV_PIO2;
+        kd = std::nearbyint(kd);
+        const auto k = static_cast<uint64_t>(sse_cvt(kd));
+        double r = x;
+        double t = PIO2_1 * kd;
+        r = r - t;
+        t = PIO2_2 * kd;
+        r = r - t;
+        t = PIO2_3 * kd;
+        r = r - t;
+        const double z = r * r;
+        double s = horner(z, precise(accuracy) ? poly(SIN_PRECISE) : poly(SIN_FAST));
+        s = s * z;
+        s = s * r;
+        s = s + r;
+        double c = horner(z, precise(accuracy) ? poly(COS_PRECISE) : poly(COS_FAST));
+        c = c * z;
+        c = c * z;
+        const double hz = 0.5 * z;
+        const double w = 1.0 - hz;
+        double v = 1.0 - w;
+        v = v - hz;
+        v = v + c;
+        v = v + w;
+        const uint64_t quadrant = k + (cosine ? 1 : 0);
+        uint64_t bits = quadrant & 1 ? to_bits(v) : to_bits(s);
+        bits ^= (quadrant & 2) << 62;
+        return from_bits(bits);
+    }
+
+    double reference_exp(const double x, const MathAccuracy accuracy) {
+        double u = sse_max(EXP_LOW, x);
+        u = sse_min(EXP_HIGH, u);
+        double kd = INV_LN2 * u;
+        kd = std::nearbyint(kd);
+        const auto k = static_cast<uint64_t>(sse_cvt(kd));
+        double t = LN2_HI * kd;
+        double r = u - t;
+        t = LN2_LO * kd;
+        r = r - t;
+        double e = horner(r, precise(accuracy) ? poly(EXP_PRECISE) : poly(EXP_FAST));
+        e = e * r;
+        e = e * r;
+        e = e + r;
+        e = e + 1.0;
+        const uint64_t k1 = static_cast<uint64_t>(static_cast<int64_t>(k) >> 1);
+        e = e * exponent(k1);
+        e = e * exponent(k - k1);
+        return e;
+    }
+
+    double reference_log(const double x, const MathAccuracy accuracy) {
+        uint64_t bits = to_bits(x);
+        uint64_t adjust = 0;
+        if ((bits >> 52) - 1 >= 0x7FE) {
+            if (bits << 1 == 0) return from_bits(MINUS_INFINITY);
+            if (bits >> 63) return from_bits(QUIET_NAN);
+            if (bits << 1 >> 53) return x;
+            bits = to_bits(from_bits(TWO_54) * x);
+            adjust = static_cast<uint64_t>(-54);
+        }
+        const uint64_t mantissa = bits & MANTISSA;
+        const uint64_t i = (mantissa + SQRT2_ROUND) >> 52;
+        const auto e = static_cast<int64_t>((bits >> 52) + adjust + i - 1023);
+        const double f = from_bits(mantissa | ((0x3FF - i) << 52)) - 1.0;
+        const double d = 2.0 + f;
+        const double s = f / d;
+        const double z = s * s;
+        double a = horner(z, precise(accuracy) ? poly(LOG_PRECISE) : poly(LOG_FAST));
+        a = a * z;
+        double h = f * f;
+        h = h * 0.5;
+        a = a + h;
+        a = a * s;
+        const auto ed = static_cast<double>(e);
+        double t = LN2_LO * ed;
+        a = a + t;
+        h = h - a;
+        h = h - f;
+        t = LN2_HI * ed;
+        return t - h;
+    }
+
+    double reference_tanh(const double x, const MathAccuracy accuracy) {
+        const double ax = from_bits(to_bits(x) & ~SIGN_BIT);
+        const double t = ax + ax;
+        double m;
+        if (t >= TANH_SMALL) {
+            m = reference_exp(sse_min(TANH_LARGE, t), accuracy);
+            m = m - 1.0;
+        } else {
+            m = horner(t, precise(accuracy) ? poly(EXPM1_PRECISE) : poly(EXPM1_FAST));
+            m = m * t;
+        }
+        const double d = 2.0 + m;
+        m = m / d;
+        return from_bits(to_bits(m) | (to_bits(x) & SIGN_BIT));
+    }
+
+    double reference_pow(const double x, const double y, const MathAccuracy accuracy) {
+        if (x == 1.0 || y == 0.0) return 1.0;
+        uint64_t sign = 0;
+        if (to_bits(x) >> 63) {
+            // a negative base needs an integer exponent, odd ones keep the sign
+            if (!(std::trunc(y) == y)) return from_bits(QUIET_NAN);
+            const double h = 0.5 * y;
+            if (!(std::trunc(h) == h)) sign = SIGN_BIT;
+        }
+        double l = reference_log(from_bits(to_bits(x) & ~SIGN_BIT), accuracy);
+        l = l * y;
+        return from_bits(to_bits(reference_exp(l, accuracy)) ^ sign);
+    }
+
+    // ---- emitters
+
+    constexpr int ROUND_NEAREST = 0;
+    constexpr int ROUND_TRUNCATE = 3;
+
+    void constant(Assembler &a, const Xmm &to, const double value) {
+        a.mov(x86::rax, asmjit::imm(to_bits(value)));
+        a.movq(to, x86::rax);
+    }
+
+    // acc = p(z), tmp holds the coefficients
+    void emit_horner(Assembler &a, const Xmm &acc, const Xmm &z, const Xmm &tmp, const Poly &p) {
+        constant(a, acc, p.c[p.n - 1]);
+        for (int i = p.n - 2; i >= 0; i--) {
+            a.mulsd(acc, z);
+            constant(a, tmp, p.c[i]);
+            a.addsd(acc, tmp);
+        }
+    }
+
+    void emit_sincos(Assembler &a, const bool cosine, const MathAccuracy accuracy, const Xmm &result,
+                     const Xmm &x, const Xmm (&s)[MATH_KERNEL_SCRATCH]) {
+        a.comment(cosine ? "; -- inline cos" : "; -- inline sin");
+        // k = round(x 2/pi), r = x - k pi/2
+        constant(a, s[0], INV_PIO2);
+        a.mulsd(s[0], x);
+        a.roundsd(s[0], s[0], ROUND_NEAREST);
+        a.cvtsd2si(x86::rcx, s[0]);
+        a.movapd(s[1], x);
+        for (const double part: {PIO2_1, PIO2_2, PIO2_3}) {
+            constant(a, s[2], part);
+            a.mulsd(s[2], s[0]);
+            a.subsd(s[1], s[2]);
+        }
+        a.movapd(s[2], s[1]);
+        a.mulsd(s[2], s[1]); // z = r^2
+
+        // both polynomials, the quadrant picks one
+        emit_horner(a, s[3], s[2], s[4], precise(accuracy) ? poly(SIN_PRECISE) : poly(SIN_FAST));
+        a.mulsd(s[3], s[2]);
+        a.mulsd(s[3], s[1]);
+        a.addsd(s[3], s[1]);
+        emit_horner(a, s[0], s[2], s[4], precise(accuracy) ? poly(COS_PRECISE) : poly(COS_FAST));
+        a.mulsd(s[0], s[2]);
+        a.mulsd(s[0], s[2]);
+        constant(a, s[1], 0.5);
+        a.mulsd(s[1], s[2]);
+        constant(a, s[4], 1.0);
+        a.subsd(s[4], s[1]);
+        constant(a, s[2], 1.0);
+        a.subsd(s[2], s[4]);
+        a.subsd(s[2], s[1]);
+        a.addsd(s[2], s[0]);
+        a.addsd(s[2], s[4]);
+
+        // odd quadrants take the other function, quadrants 2 and 3 negate
+        if (cosine) a.add(x86::rcx, 1);
+        a.movq(x86::rax, s[3]);
+        a.movq(x86::rdx, s[2]);
+        a.test(x86::cl, 1);
+        a.cmovnz(x86::rax, x86::rdx);
+        a.mov(x86::rdx, x86::rcx);
+        a.and_(x86::edx, 2);
+        a.shl(x86::rdx, 62);
+        a.xor_(x86::rax, x86::rdx);
+        a.movq(result, x86::rax);
+    }
+
+    // three scratch registers
+    void emit_exp(Assembler &a, const MathAccuracy accuracy, const Xmm &result, const Xmm &x,
+                  const Xmm &s0, const Xmm &s1, const Xmm &s2) {
+        a.comment("; -- inline exp");
+        constant(a, s0, EXP_LOW);
+        a.maxsd(s0, x); // a NaN x is kept
+        constant(a, s1, EXP_HIGH);
+        a.minsd(s1, s0);
+        // k = round(x / ln2), r = x - k ln2
+        constant(a, s0, INV_LN2);
+        a.mulsd(s0, s1);
+        a.roundsd(s0, s0, ROUND_NEAREST);
+        a.cvtsd2si(x86::rcx, s0);
+        constant(a, s2, LN2_HI);
+        a.mulsd(s2, s0);
+        a.subsd(s1, s2);
+        constant(a, s2, LN2_LO);
+        a.mulsd(s2, s0);
+        a.subsd(s1, s2);
+
+        emit_horner(a, s0, s1, s2, precise(accuracy) ? poly(EXP_PRECISE) : poly(EXP_FAST));
+        a.mulsd(s0, s1);
+        a.mulsd(s0, s1);
+        a.addsd(s0, s1);
+        constant(a, s2, 1.0);
+        a.addsd(s0, s2);
+
+        // times 2^(k/2) 2^(k - k/2), both in range down to subnormal results
+        a.mov(x86::rdx, x86::rcx);
+        a.sar(x86::rdx, 1);
+        a.sub(x86::rcx, x86::rdx);
+        for (const auto &k: {x86::rdx, x86::rcx}) {
+            a.add(k, 1023);
+            a.shl(k, 52);
+            a.movq(s2, k);
+            a.mulsd(s0, s2);
+        }
+        a.movapd(result, s0);
+    }
+
+    // five scratch registers, x may be s[0]: it is read before any scratch is written
+    void emit_log(Assembler &a, const MathAccuracy accuracy, const Xmm &result, const Xmm &x, const Xmm *s) {
+        a.comment("; -- inline log");
+        const asmjit::Label body = a.newLabel();
+        const asmjit::Label special = a.newLabel();
+        const asmjit::Label minusInfinity = a.newLabel();
+        const asmjit::Label notNumber = a.newLabel();
+        const asmjit::Label done = a.newLabel();
+
+        // rdx adjusts the exponent of a scaled subnormal
+        a.movq(x86::rax, x);
+        a.xor_(x86::edx, x86::edx);
+        a.mov(x86::rcx, x86::rax);
+        a.shr(x86::rcx, 52);
+        a.sub(x86::rcx, 1);
+        a.cmp(x86::rcx, 0x7FE);
+        a.jae(special); // zero, subnormal, negative, infinity or NaN
+
+        // x = 2^e m, sqrt(2)/2 <= m < sqrt(2)
+        a.bind(body);
+        a.mov(x86::rcx, asmjit::imm(MANTISSA));
+        a.and_(x86::rcx, x86::rax);
+        a.shr(x86::rax, 52);
+        a.add(x86::rax, x86::rdx);
+        a.mov(x86::rdx, asmjit::imm(SQRT2_ROUND));
+        a.add(x86::rdx, x86::rcx);
+        a.shr(x86::rdx, 52); // 1 when m would be >= sqrt(2)
+        a.add(x86::rax, x86::rdx);
+        a.sub(x86::rax, 1023);
+        a.neg(x86::rdx);
+        a.add(x86::rdx, 0x3FF);
+        a.shl(x86::rdx, 52);
+        a.or_(x86::rcx, x86::rdx);
+        a.movq(s[0], x86::rcx);
+        constant(a, s[1], 1.0);
+        a.subsd(s[0], s[1]); // f
+        constant(a, s[1], 2.0);
+        a.addsd(s[1], s[0]);
+        a.movapd(s[2], s[0]);
+        a.divsd(s[2], s[1]); // s
+        a.movapd(s[1], s[2]);
+        a.mulsd(s[1], s[2]); // z
+        emit_horner(a, s[3], s[1], s[4], precise(accuracy) ? poly(LOG_PRECISE) : poly(LOG_FAST));
+        a.mulsd(s[3], s[1]);
+        a.movapd(s[1], s[0]);
+        a.mulsd(s[1], s[0]);
+        constant(a, s[4], 0.5);
+        a.mulsd(s[1], s[4]); // f^2/2
+        a.addsd(s[3], s[1]);
+        a.mulsd(s[3], s[2]);
+        a.cvtsi2sd(s[2], x86::rax); // e
+        constant(a, s[4], LN2_LO);
+        a.mulsd(s[4], s[2]);
+        a.addsd(s[3], s[4]);
+        a.subsd(s[1], s[3]);
+        a.subsd(s[1], s[0]);
+        constant(a, s[4], LN2_HI);
+        a.mulsd(s[4], s[2]);
+        a.subsd(s[4], s[1]);
+        a.movapd(result, s[4]);
+        a.jmp(done);
+
+        a.bind(special);
+        a.mov(x86::rcx, x86::rax);
+        a.shl(x86::rcx, 1);
+        a.jz(minusInfinity);
+        a.test(x86::rax, x86::rax);
+        a.js(notNumber);
+        a.shr(x86::rcx, 53);
+        const asmjit::Label subnormal = a.newLabel();
+        a.jz(subnormal);
+        a.movapd(result, x); // +infinity or NaN
+        a.jmp(done);
+        a.bind(subnormal);
+        a.mov(x86::rax, asmjit::imm(TWO_54));
+        a.movq(s[1], x86::rax);
+        a.mulsd(s[1], x);
+        a.movq(x86::rax, s[1]);
+        a.mov(x86::rdx, -54);
+        a.jmp(body);
+        a.bind(minusInfinity);
+        a.mov(x86::rax, asmjit::imm(MINUS_INFINITY));
+        a.movq(result, x86::rax);
+        a.jmp(done);
+        a.bind(notNumber);
+        a.mov(x86::rax, asmjit::imm(QUIET_NAN));
+        a.movq(result, x86::rax);
+        a.bind(done);
+    }
+
+    void emit_tanh(Assembler &a, const MathAccuracy accuracy, const Xmm &result, const Xmm &x,
+                   const Xmm (&s)[MATH_KERNEL_SCRATCH]) {
+        a.comment("; -- inline tanh");
+        const asmjit::Label large = a.newLabel();
+        const asmjit::Label quotient = a.newLabel();
+        a.mov(x86::rax, asmjit::imm(~SIGN_BIT));
+        a.movq(s[3], x86::rax);
+        a.andpd(s[3], x);
+        a.addsd(s[3], s[3]); // t = 2|x|
+        constant(a, s[0], TANH_SMALL);
+        a.ucomisd(s[3], s[0]);
+        a.jae(large);
+        emit_horner(a, s[0], s[3], s[1], precise(accuracy) ? poly(EXPM1_PRECISE) : poly(EXPM1_FAST));
+        a.mulsd(s[0], s[3]);
+        a.jmp(quotient);
+        a.bind(large);
+        constant(a, s[4], TANH_LARGE);
+        a.minsd(s[4], s[3]);
+        emit_exp(a, accuracy, s[0], s[4], s[1], s[2], s[3]);
+        constant(a, s[1], 1.0);
+        a.subsd(s[0], s[1]);
+        a.bind(quotient);
+        constant(a, s[1], 2.0);
+        a.addsd(s[1], s[0]);
+        a.divsd(s[0], s[1]);
+        a.movq(x86::rax, s[0]);
+        a.movq(x86::rdx, x);
+        a.mov(x86::rcx, asmjit::imm(SIGN_BIT));
+        a.and_(x86::rdx, x86::rcx);
+        a.or_(x86::rax, x86::rdx);
+        a.movq(result, x86::rax);
+    }
+
+    void emit_pow(Assembler &a, const MathAccuracy accuracy, const Xmm &result, const Xmm &x, const Xmm &y,
+                  const Xmm (&s)[MATH_KERNEL_SCRATCH]) {
+        a.comment("; -- inline pow");
+        const asmjit::Label one = a.newLabel();
+        const asmjit::Label notNumber = a.newLabel();
+        const asmjit::Label positive = a.newLabel();
+        const asmjit::Label done = a.newLabel();
+
+        // x == 1 or y == 0, including NaNs
+        const asmjit::Label notOne = a.newLabel();
+        const asmjit::Label notZero = a.newLabel();
+        constant(a, s[0], 1.0);
+        a.ucomisd(x, s[0]);
+        a.jp(notOne);
+        a.je(one);
+        a.bind(notOne);
+        a.xorpd(s[0], s[0]);
+        a.ucomisd(y, s[0]);
+        a.jp(notZero);
+        a.je(one);
+        a.bind(notZero);
+
+        // s[5] is the sign of the result
+        a.xorpd(s[5], s[5]);
+        a.movq(x86::rax, x);
+        a.test(x86::rax, x86::rax);
+        a.jns(positive);
+        a.roundsd(s[0], y, ROUND_TRUNCATE);
+        a.ucomisd(s[0], y);
+        a.jp(notNumber);
+        a.jne(notNumber);
+        constant(a, s[0], 0.5);
+        a.mulsd(s[0], y);
+        a.roundsd(s[1], s[0], ROUND_TRUNCATE);
+        a.ucomisd(s[1], s[0]);
+        a.je(positive); // even
+        a.mov(x86::rax, asmjit::imm(SIGN_BIT));
+        a.movq(s[5], x86::rax);
+
+        // exp(y log|x|)
+        a.bind(positive);
+        a.mov(x86::rax, asmjit::imm(~SIGN_BIT));
+        a.movq(s[0], x86::rax);
+        a.andpd(s[0], x);
+        emit_log(a, accuracy, s[0], s[0], s);
+        a.mulsd(s[0], y);
+        emit_exp(a, accuracy, s[1], s[0], s[2], s[3], s[4]);
+        a.movq(x86::rax, s[1]);
+        a.movq(x86::rdx, s[5]);
+        a.xor_(x86::rax, x86::rdx);
+        a.movq(result, x86::rax);
+        a.jmp(done);
+
+        a.bind(one);
+        constant(a, result, 1.0);
+        a.jmp(done);
+        a.bind(notNumber);
+        a.mov(x86::rax, asmjit::imm(QUIET_NAN));
+        a.movq(result, x86::rax);
+        a.bind(done);
+    }
+}
+
+bool math_kernel_available(const std::string_view name) {
+    return name == "sin" || name == "cos" || name == "exp" || name == "log" || name == "ln" || name == "tanh" ||
+           name == "pow";
+}
+
+bool math_kernel_emit(Assembler &assembler, const std::string_view name, const MathAccuracy accuracy,
+                      const Xmm &result, const Xmm &x, const Xmm &y, const Xmm (&scratch)[MATH_KERNEL_SCRATCH]) {
+    if (accuracy == MathAccuracy::LIBM) return false;
+    if (name == "sin" || name == "cos") {
+        emit_sincos(assembler, name == "cos", accuracy, result, x, scratch);
+    } else if (name == "exp") {
+        emit_exp(assembler, accuracy, result, x, scratch[0], scratch[1], scratch[2]);
+    } else if (name == "log" || name == "ln") {
+        emit_log(assembler, accuracy, result, x, scratch);
+    } else if (name == "tanh") {
+        emit_tanh(assembler, accuracy, result, x, scratch);
+    } else if (name == "pow") {
+        emit_pow(assembler, accuracy, result, x, y, scratch);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double math_kernel_reference(const std::string_view name, const MathAccuracy accuracy, const double x,
+                             const double y) {
+    if (name == "sin" || name == "cos") return reference_sincos(x, name == "cos", accuracy);
+    if (name == "exp") return reference_exp(x, accuracy);
+    if (name == "log" || name == "ln") return reference_log(x, accuracy);
+    if (name == "tanh") return reference_tanh(x, accuracy);
+    if (name == "pow") return reference_pow(x, y, accuracy);
+    return std::nan("");
+}
@@ -4,9 +4,13 @@
 #include <SignalHandler.h>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <Tokenizer.h>
 #include "SymbolTable.h"
 #include "Settings.h"
+#include "ForthDictionary.h"
+#include "Peephole.h"
 
 int optimizations;
 
@@ -14,27 +18,39 @@ int Optimizer::optimize(const std::deque<ForthToken> &tokens,
                         std::deque<ForthToken> &optimized_tokens) {
     optimized_tokens.clear(); // Clear the output deque before optimization
     optimizations = 0;
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        const ForthToken &current = tokens[i];
 
-        // Optimize peephole cases: specific patterns like "DUP +" or "SWAP DROP"
-        if (i + 1 < tokens.size() && optimize_peephole_case(tokens, optimized_tokens, i)) {
-            continue; // `optimize_peephole_case` adjusts `i` automatically
-        }
+    std::deque<ForthToken> rewritten(tokens);
+
+    // Literal and CONSTANT arithmetic first, in the body between the stack comment and ;
+    size_t body = !rewritten.empty() && rewritten.front().type == TOKEN_COMPILING ? 2 : 0;
+    if (body < rewritten.size() && rewritten[body].type == TOKEN_BEGINCOMMENT) {
+        while (body < rewritten.size() && rewritten[body].type != TOKEN_ENDCOMMENT) body++;
+        body++;
+    }
+    size_t end = body;
+    while (end < rewritten.size() && rewritten[end].type != TOKEN_INTERPRETING) end++;
+    if (body < end) {
+        fold_constants(rewritten, body, end);
+    }
+
+    // Then peephole rules: patterns like "DUP +", "SWAP DROP" or "R> n + >R", see SHOW OPTIMIZER
+    optimizations += static_cast<int>(Peephole::instance().rewrite(rewritten));
 
+    for (size_t i = 0; i < rewritten.size(); ++i) {
+        const ForthToken &current = rewritten[i];
 
         // Optimize constant operations: NUMBER followed by OPERATOR
-        if (i + 1 < tokens.size() && current.type == TOKEN_NUMBER && is_arithmetic_operator(tokens[i + 1].value)) {
-            if (optimize_constant_operation(tokens, optimized_tokens, i)) {
+        if (i + 1 < rewritten.size() && current.type == TOKEN_NUMBER && is_arithmetic_operator(rewritten[i + 1].value)) {
+            if (optimize_constant_operation(rewritten, optimized_tokens, i)) {
                 i++; // Skip operator as it's already processed
                 continue;
             }
         }
 
         // Optimize literal comparisons: NUMBER followed by <, > or =
-        if (i + 1 < tokens.size() && current.type == TOKEN_NUMBER && is_comparison_operator(tokens[i + 1].value)) {
+        if (i + 1 < rewritten.size() && current.type == TOKEN_NUMBER && is_comparison_operator(rewritten[i + 1].value)) {
 
-            if (optimize_literal_comparison(tokens, optimized_tokens, i)) {
+            if (optimize_literal_comparison(rewritten, optimized_tokens, i)) {
                 i++; // Skip operator as it's already processed
 
                 continue;
@@ -45,6 +61,8 @@ int Optimizer::optimize(const std::deque<ForthToken> &tokens,
         optimized_tokens.push_back(current);
     }
 
+    mark_tail_calls(optimized_tokens);
+
     // Add TOKEN_END to signal end of optimization
     optimized_tokens.emplace_back(ForthToken{TOKEN_END});
     //Tokenizer::instance().print_token_list(optimized_tokens);
@@ -55,11 +73,11 @@ int Optimizer::optimize(const std::deque<ForthToken> &tokens,
 
 // PRIVATE UTILITY FUNCTIONS
 
-bool Optimizer::is_arithmetic_operator(const std::string &op) {
+bool Optimizer::is_arithmetic_operator(const std::string_view op) {
     return (op == "+" || op == "-" || op == "*" || op == "/");
 }
 
-bool Optimizer::is_comparison_operator(const std::string &op) {
+bool Optimizer::is_comparison_operator(const std::string_view op) {
     return (op == "<" || op == ">" || op == "=");
 }
 
@@ -144,150 +162,208 @@ bool Optimizer::optimize_literal_comparison(const std::deque<ForthToken> &tokens
 
 
 
-ForthToken Optimizer::getToken(const std::deque<ForthToken>& tokens, size_t i) {
-    return (i < tokens.size()) ? tokens[i] : ForthToken();
+bool Optimizer::is_power_of_two(int64_t value) {
+    return (value > 0 && (value & (value - 1)) == 0);
 }
 
-bool Optimizer::optimize_peephole_case(const std::deque<ForthToken>& tokens,
-                                       std::deque<ForthToken>& optimized_tokens, size_t& index) {
-
+ForthToken Optimizer::create_optimized_token(const std::string_view optimized_op) {
+    ForthToken temp;
+    temp.type = TOKEN_OPTIMIZED;
+    temp.optimized_op = optimized_op;
+    set_common_fields(temp);
 
-    // Lambda to create optimized tokens with less boilerplate
-    auto addOptimizedToken = [&](const std::string& optimized_name, int int_value = 0, const std::string& value = "", int word_id = 0) {
-        auto token = create_optimized_token(optimized_name);
-        token.int_value = int_value;
-        token.value = value;
-        token.word_id = word_id;
-        optimized_tokens.emplace_back(token);
-    };
+    return temp;
+}
 
-    // Retrieve current token and lookahead tokens
-    const ForthToken& current = getToken(tokens, index);
-    const ForthToken& next = getToken(tokens, index + 1);
-    const ForthToken& third = getToken(tokens, index + 2);
-    const ForthToken& fourth = getToken(tokens, index + 3);
+void Optimizer::set_common_fields(ForthToken &token) {
+    token.word_id = SymbolTable::instance().addSymbol(token.optimized_op);
+    token.optimized_op = SymbolTable::instance().getSymbol(token.word_id); // keep the name in the symbol arena
+    token.word_len = token.optimized_op.size();
+    token.opt_value = token.int_value;
 
+}
 
-    if (current.value == "R>" && next.type == TOKEN_NUMBER && third.value == "+" && fourth.value == ">R") {
-        addOptimizedToken("INC_R@", next.int_value);
-        index += 3; // Skip next 3 tokens
-        optimizations++;
-        return true;
-    }
 
-    // swap n + swap = add n to 20S
-    if (current.value == "SWAP" && next.type == TOKEN_NUMBER && third.value == "+" && fourth.value == "SWAP") {
-        addOptimizedToken("INC_2OS", next.int_value);
-        index += 3; // Skip next 3 tokens
-        optimizations++;
-        return true;
-    }
+namespace {
+    enum class FoldOp {
+        ADD, SUB, MUL, DIV, MOD, UDIV, UMOD, AND, OR, NEGATE, ABS, NOT,
+        EQ, NEQ, LT, GT, LE, ZERO_EQ, ZERO_NEQ, ZERO_LT, ZERO_GT,
+        DUP, DROP, SWAP, OVER, NIP
+    };
 
+    struct FoldWord {
+        std::string_view name;
+        FoldOp op;
+        size_t inputs;
+    };
 
-    if (current.value == "R>" && next.type == TOKEN_NUMBER && third.value == "-" && fourth.value == ">R") {
-        addOptimizedToken("DEC_R@", next.int_value);
-        index += 3;
-        optimizations++;
-        return true;
-    }
+    // primitives without side effects; XOR and -ROT keep their generators' own behaviour
+    constexpr FoldWord foldWords[] = {
+        {"+", FoldOp::ADD, 2}, {"-", FoldOp::SUB, 2}, {"*", FoldOp::MUL, 2}, {"/", FoldOp::DIV, 2},
+        {"MOD", FoldOp::MOD, 2}, {"U/", FoldOp::UDIV, 2}, {"UMOD", FoldOp::UMOD, 2},
+        {"AND", FoldOp::AND, 2}, {"OR", FoldOp::OR, 2},
+        {"NEGATE", FoldOp::NEGATE, 1}, {"ABS", FoldOp::ABS, 1}, {"NOT", FoldOp::NOT, 1},
+        {"=", FoldOp::EQ, 2}, {"<>", FoldOp::NEQ, 2}, {"<", FoldOp::LT, 2}, {">", FoldOp::GT, 2},
+        {"<=", FoldOp::LE, 2}, {"0=", FoldOp::ZERO_EQ, 1}, {"0<>", FoldOp::ZERO_NEQ, 1},
+        {"0<", FoldOp::ZERO_LT, 1}, {"0>", FoldOp::ZERO_GT, 1},
+        {"DUP", FoldOp::DUP, 1}, {"DROP", FoldOp::DROP, 1}, {"SWAP", FoldOp::SWAP, 2},
+        {"OVER", FoldOp::OVER, 2}, {"NIP", FoldOp::NIP, 2},
+    };
 
-    if (current.type == TOKEN_NUMBER && next.type == TOKEN_VARIABLE && third.value == "!") {
-        addOptimizedToken("LIT_VAR_!", current.int_value, next.value);
-        index += 2;
-        optimizations++;
-        return true;
+    // A foldable primitive, not a user word of the same name
+    const FoldWord *find_fold_word(const ForthToken &token) {
+        if (token.type != TOKEN_WORD) return nullptr;
+        for (const auto &word: foldWords) {
+            if (word.name != token.value) continue;
+            const auto entry = ForthDictionary::instance().findWord(token.value);
+            return entry && entry->generator ? &word : nullptr;
+        }
+        return nullptr;
     }
 
-    if (current.value == "R@" && next.value == "C!") {
-        addOptimizedToken("R@_C!");
-        index += 1;
-        optimizations++;
+    int64_t flag(const bool f) { return f ? -1 : 0; }
+
+    // What the primitive leaves for inputs a (deepest) .. b, computed as the generated code
+    // would: wrapping arithmetic, truncating division, 0/-1 flags (NOT gives 0/1).
+    // False if the code would trap, that is left to happen at run time.
+    bool evaluate(const FoldOp op, const int64_t *in, std::vector<int64_t> &out) {
+        const int64_t a = in[0];
+        const int64_t b = in[1];
+        const auto ua = static_cast<uint64_t>(a);
+        const auto ub = static_cast<uint64_t>(b);
+        switch (op) {
+            case FoldOp::ADD: out = {static_cast<int64_t>(ua + ub)}; break;
+            case FoldOp::SUB: out = {static_cast<int64_t>(ua - ub)}; break;
+            case FoldOp::MUL: out = {static_cast<int64_t>(ua * ub)}; break;
+            case FoldOp::DIV:
+            case FoldOp::MOD:
+                if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+                out = {op == FoldOp::DIV ? a / b : a % b};
+                break;
+            case FoldOp::UDIV:
+            case FoldOp::UMOD:
+                if (b == 0) return false;
+                out = {static_cast<int64_t>(op == FoldOp::UDIV ? ua / ub : ua % ub)};
+                break;
+            case FoldOp::AND: out = {a & b}; break;
+            case FoldOp::OR: out = {a | b}; break;
+            case FoldOp::NEGATE: out = {static_cast<int64_t>(0 - ua)}; break;
+            case FoldOp::ABS: out = {a < 0 ? static_cast<int64_t>(0 - ua) : a}; break;
+            case FoldOp::NOT: out = {a == 0 ? 1 : 0}; break;
+            case FoldOp::EQ: out = {flag(a == b)}; break;
+            case FoldOp::NEQ: out = {flag(a != b)}; break;
+            case FoldOp::LT: out = {flag(a < b)}; break;
+            case FoldOp::GT: out = {flag(a > b)}; break;
+            case FoldOp::LE: out = {flag(a <= b)}; break;
+            case FoldOp::ZERO_EQ: out = {flag(a == 0)}; break;
+            case FoldOp::ZERO_NEQ: out = {flag(a != 0)}; break;
+            case FoldOp::ZERO_LT: out = {flag(a < 0)}; break;
+            case FoldOp::ZERO_GT: out = {flag(a > 0)}; break;
+            case FoldOp::DUP: out = {a, a}; break;
+            case FoldOp::DROP: out = {}; break;
+            case FoldOp::SWAP: out = {b, a}; break;
+            case FoldOp::OVER: out = {a, b, a}; break;
+            case FoldOp::NIP: out = {b}; break;
+        }
         return true;
     }
 
-    if (current.value == "R@" && next.value == "!") {
-        addOptimizedToken("R@_!");
-        index += 1;
-        optimizations++;
-        return true;
+    ForthToken literal_token(const int64_t value) {
+        ForthToken token(TOKEN_NUMBER);
+        token.int_value = static_cast<uint64_t>(value);
+        return token;
     }
+}
 
-    if (current.type == TOKEN_VARIABLE) {
-
-        if (next.value == "@") {
-            addOptimizedToken("VAR_@", 0, current.value, current.word_id);
-            index += 1;
-            optimizations++;
-            return true;
-        }
-        if (next.value == "!") {
-            addOptimizedToken("VAR_!", 0, current.value, current.word_id);
-            index += 1;
-            optimizations++;
-            return true;
-        }
-        if (next.value == ">R") {
-            addOptimizedToken("VAR_TOR", 0, current.value, current.word_id);
-            index += 1;
-            optimizations++;
-            return true;
+// Evaluates runs of literals, CONSTANTs and pure primitives in tokens[start, end) at compile
+// time, e.g. 3 4 + 2 * becomes 14 and WIDTH HEIGHT * one literal. A CONSTANT becomes its
+// value even where nothing folds. Tokens after an immediate word are left alone.
+bool Optimizer::fold_constants(std::deque<ForthToken> &tokens, const size_t start, const size_t end) {
+    const auto &dict = ForthDictionary::instance();
+    std::deque<ForthToken> folded(tokens.begin(), tokens.begin() + static_cast<std::ptrdiff_t>(start));
+    size_t literals = 0; // literal tokens at the end of folded, usable as operands
+    bool changed = false;
+
+    for (size_t i = start; i < end; i++) {
+        const ForthToken &token = tokens[i];
+
+        // a word following an immediate word may be its argument
+        if (i > 0 && tokens[i - 1].type == TOKEN_WORD) {
+            const auto previous = dict.findWord(tokens[i - 1].value);
+            if (previous && (previous->immediate_interpreter || previous->immediate_compiler)) {
+                folded.push_back(token);
+                literals = 0;
+                continue;
+            }
         }
-    }
-
-    if (current.value == "C@" && next.value == "EMIT") {
-        addOptimizedToken("C@_EMIT");
-        index += 1;
-        optimizations++;
-        return true;
-    }
 
-    if (current.value == "DUP" && next.value == "+") {
-        addOptimizedToken("LEA_TOS");
-        index += 1;
-        optimizations++;
-        return true;
-    }
+        if (token.type == TOKEN_NUMBER) {
+            folded.push_back(token);
+            literals++;
+            continue;
+        }
 
-    if (current.value == "SWAP" && next.value == "DROP") {
-        addOptimizedToken("MOV_TOS_1");
-        index += 1;
-        optimizations++;
-        return true;
-    }
+        if (token.type == TOKEN_WORD) {
+            const auto entry = dict.findWord(token.value);
+            if (entry && entry->type == ForthWordType::CONSTANT && entry->data) {
+                folded.push_back(literal_token(*static_cast<const int64_t *>(entry->data)));
+                literals++;
+                changed = true;
+                continue;
+            }
+        }
 
-    if (current.value == "DUP" && next.value == "ROT") {
-        addOptimizedToken("TUCK");
-        index += 1;
-        optimizations++;
-        return true;
-    }
+        const FoldWord *word = find_fold_word(token);
+        std::vector<int64_t> results;
+        if (word && word->inputs <= literals) {
+            int64_t in[2] = {};
+            for (size_t k = 0; k < word->inputs; k++) {
+                in[k] = static_cast<int64_t>(folded[folded.size() - word->inputs + k].int_value);
+            }
+            if (evaluate(word->op, in, results)) {
+                folded.erase(folded.end() - static_cast<std::ptrdiff_t>(word->inputs), folded.end());
+                for (const int64_t value: results) folded.push_back(literal_token(value));
+                literals = literals - word->inputs + results.size();
+                optimizations++;
+                changed = true;
+                continue;
+            }
+        }
 
-    if (current.value == "OVER" && next.value == "DROP") {
-        addOptimizedToken("DUP");
-        index += 1;
-        optimizations++;
-        return true;
+        folded.push_back(token);
+        literals = 0;
     }
 
-    return false;
-}
-
-bool Optimizer::is_power_of_two(int64_t value) {
-    return (value > 0 && (value & (value - 1)) == 0);
-}
-
-ForthToken Optimizer::create_optimized_token(const std::string &optimized_op) {
-    ForthToken temp;
-    temp.type = TOKEN_OPTIMIZED;
-    temp.optimized_op = optimized_op;
-    set_common_fields(temp);
-
-    return temp;
+    if (!changed) return false;
+    folded.insert(folded.end(), tokens.begin() + static_cast<std::ptrdiff_t>(end), tokens.end());
+    tokens.swap(folded);
+    return true;
 }
 
-void Optimizer::set_common_fields(ForthToken &token) {
-    token.word_id = SymbolTable::instance().addSymbol(token.optimized_op);
-    token.word_len = token.optimized_op.size();
-    token.opt_value = token.int_value;
-
+// A word compiled as a call, or RECURSE, followed by ; or EXIT (THEN only binds a label)
+// returns straight after its callee; mark it TOKEN_CALL so the compiler emits a jump.
+void Optimizer::mark_tail_calls(std::deque<ForthToken> &tokens) {
+    const auto &dict = ForthDictionary::instance();
+    for (size_t i = 2; i < tokens.size(); ++i) {
+        ForthToken &token = tokens[i];
+        if (token.type != TOKEN_WORD) continue;
+
+        size_t next = i + 1;
+        while (next < tokens.size() && tokens[next].type == TOKEN_WORD && tokens[next].value == "THEN") next++;
+        if (next >= tokens.size()) continue;
+        if (tokens[next].type != TOKEN_INTERPRETING && tokens[next].value != "EXIT") continue;
+
+        // a word following an immediate word may be its argument
+        const auto previous = dict.findWord(tokens[i - 1].value);
+        if (previous && (previous->immediate_interpreter || previous->immediate_compiler)) continue;
+
+        const auto entry = dict.findWord(token.value);
+        if (!entry) continue;
+        const bool call = entry->type == ForthWordType::WORD && entry->executable && !entry->generator
+                          && !entry->immediate_interpreter && !entry->immediate_compiler;
+        if (call || token.value == "RECURSE") {
+            token.type = TOKEN_CALL;
+            optimizations++;
+        }
+    }
 }
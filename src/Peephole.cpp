@@ -0,0 +1,253 @@
+#include "Peephole.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "ForthDictionary.h"
+#include "SymbolTable.h"
+
+namespace {
+    struct BuiltinRule {
+        const char *text;
+        bool fragment;
+    };
+
+    // the patterns the optimizer has always known
+    constexpr BuiltinRule builtinRules[] = {
+        {"R> #n + >R => INC_R@", true},
+        {"R> #n - >R => DEC_R@", true},
+        {"SWAP #n + SWAP => INC_2OS", true},
+        {"#n #v ! => LIT_VAR_!", true},
+        {"R@ C! => R@_C!", true},
+        {"R@ ! => R@_!", true},
+        {"#v @ => VAR_@", true},
+        {"#v ! => VAR_!", true},
+        {"#v >R => VAR_TOR", true},
+        {"C@ EMIT => C@_EMIT", true},
+        {"DUP + => LEA_TOS", true},
+        {"SWAP DROP => MOV_TOS_1", true},
+        {"SWAP OVER => TUCK", false},
+        {"OVER DROP =>", false},
+    };
+
+    // splits "pattern => replacement" into words, false if there is no => or no pattern
+    bool parse_rule(const std::string_view text, std::vector<std::string> &pattern, std::string &replacement) {
+        std::istringstream words{std::string(text)};
+        std::string word;
+        bool arrow = false;
+        while (words >> word) {
+            if (word == "=>" && !arrow) {
+                arrow = true;
+            } else if (!arrow) {
+                pattern.push_back(word);
+            } else if (replacement.empty()) {
+                replacement = word;
+            } else {
+                return false; // one replacement word at most
+            }
+        }
+        return arrow && !pattern.empty();
+    }
+}
+
+Peephole::Peephole() {
+    trie.emplace_back();
+    for (const auto &rule: builtinRules) {
+        std::vector<std::string> pattern;
+        std::string replacement;
+        parse_rule(rule.text, pattern, replacement);
+
+        std::vector<uint32_t> elements;
+        for (const auto &word: pattern) {
+            elements.push_back(word == "#n" ? ANY_NUMBER
+                               : word == "#v" ? ANY_VARIABLE
+                               : SymbolTable::instance().addSymbol(word));
+        }
+        add(elements, replacement, rule.fragment, rule.text);
+    }
+}
+
+bool Peephole::add_rule(const std::string_view text) {
+    std::vector<std::string> pattern;
+    std::string replacement;
+    if (!parse_rule(text, pattern, replacement)) {
+        std::cerr << "PEEPHOLE: expected pattern => replacement" << std::endl;
+        return false;
+    }
+
+    const auto &dict = ForthDictionary::instance();
+    std::vector<uint32_t> elements;
+    bool operand = false;
+    for (const auto &word: pattern) {
+        if (word == "#n" || word == "#v") {
+            elements.push_back(word == "#n" ? ANY_NUMBER : ANY_VARIABLE);
+            operand = true;
+        } else if (dict.findWord(word)) {
+            elements.push_back(SymbolTable::instance().addSymbol(word));
+        } else {
+            std::cerr << "PEEPHOLE: unknown word in pattern: " << word << std::endl;
+            return false;
+        }
+    }
+
+    bool fragment = false;
+    if (!replacement.empty()) {
+        const auto entry = dict.findWord(replacement);
+        if (!entry) {
+            std::cerr << "PEEPHOLE: unknown replacement: " << replacement << std::endl;
+            return false;
+        }
+        fragment = entry->type == ForthWordType::MACRO && entry->immediate_interpreter;
+        if (operand && !fragment) {
+            std::cerr << "PEEPHOLE: only a FRAGMENTS word can take the #n or #v of " << replacement << std::endl;
+            return false;
+        }
+    }
+
+    std::string normalized;
+    for (const auto &word: pattern) normalized += word + " ";
+    normalized += "=>";
+    if (!replacement.empty()) normalized += " " + replacement;
+    return add(elements, replacement, fragment, normalized);
+}
+
+bool Peephole::add(const std::vector<uint32_t> &pattern, const std::string_view replacement, const bool fragment,
+                   std::string text) {
+    uint32_t node = 0;
+    for (const uint32_t element: pattern) {
+        const auto it = trie[node].next.find(element);
+        if (it != trie[node].next.end()) {
+            node = it->second;
+            continue;
+        }
+        trie.emplace_back();
+        trie[node].next.emplace(element, static_cast<uint32_t>(trie.size() - 1));
+        node = static_cast<uint32_t>(trie.size() - 1);
+    }
+
+    Rule rule;
+    rule.text = std::move(text);
+    rule.pattern = pattern;
+    if (!replacement.empty()) {
+        rule.replacementId = SymbolTable::instance().addSymbol(replacement);
+        rule.replacement = SymbolTable::instance().getSymbol(rule.replacementId);
+    }
+    rule.fragment = fragment;
+
+    // a later rule for the same pattern replaces the earlier one
+    if (trie[node].rule >= 0) {
+        rules[trie[node].rule] = std::move(rule);
+    } else {
+        trie[node].rule = static_cast<int>(rules.size());
+        rules.push_back(std::move(rule));
+    }
+    return true;
+}
+
+void Peephole::longest(const std::deque<ForthToken> &tokens, const size_t position, const uint32_t node,
+                       int &best) const {
+    if (const int rule = trie[node].rule; rule >= 0) {
+        if (best < 0 || rules[rule].pattern.size() > rules[best].pattern.size()) best = rule;
+    }
+    if (position >= tokens.size()) return;
+
+    const ForthToken &token = tokens[position];
+    uint32_t keys[2];
+    size_t count = 0;
+    if (token.type == TOKEN_NUMBER) {
+        keys[count++] = ANY_NUMBER;
+    } else if (token.type == TOKEN_WORD || token.type == TOKEN_VARIABLE) {
+        const uint32_t id = token.word_id ? token.word_id : SymbolTable::instance().findSymbol(token.value);
+        if (id) keys[count++] = id;
+        if (token.type == TOKEN_VARIABLE) keys[count++] = ANY_VARIABLE;
+    }
+
+    for (size_t k = 0; k < count; k++) {
+        const auto it = trie[node].next.find(keys[k]);
+        if (it != trie[node].next.end()) longest(tokens, position + 1, it->second, best);
+    }
+}
+
+int Peephole::match(const std::deque<ForthToken> &tokens, const size_t start) const {
+    int best = -1;
+    longest(tokens, start, 0, best);
+    return best;
+}
+
+size_t Peephole::rewrite(std::deque<ForthToken> &tokens) {
+    // leave : NAME alone
+    const size_t start = !tokens.empty() && tokens.front().type == TOKEN_COMPILING ? 2 : 0;
+    const auto &dict = ForthDictionary::instance();
+    size_t rewrites = 0;
+
+    for (int pass = 0; pass < MAX_PASSES; pass++) {
+        std::deque<ForthToken> rewritten;
+        size_t changed = 0;
+        size_t i = 0;
+        while (i < tokens.size()) {
+            const int found = i >= start ? match(tokens, i) : -1;
+            if (found >= 0 && i > 0) {
+                // a word following an immediate word may be its argument
+                const auto previous = dict.findWord(tokens[i - 1].value);
+                if (previous && (previous->immediate_interpreter || previous->immediate_compiler)) {
+                    rewritten.push_back(tokens[i++]);
+                    continue;
+                }
+            }
+            if (found < 0) {
+                rewritten.push_back(tokens[i++]);
+                continue;
+            }
+
+            Rule &rule = rules[found];
+            if (!rule.replacement.empty()) {
+                ForthToken token;
+                if (rule.fragment) {
+                    token.type = TOKEN_OPTIMIZED;
+                    token.optimized_op = rule.replacement;
+                    for (size_t k = 0; k < rule.pattern.size(); k++) {
+                        if (rule.pattern[k] == ANY_NUMBER) {
+                            token.int_value = tokens[i + k].int_value;
+                        } else if (rule.pattern[k] == ANY_VARIABLE) {
+                            token.value = tokens[i + k].value;
+                            token.word_id = tokens[i + k].word_id;
+                        }
+                    }
+                    token.opt_value = static_cast<int64_t>(token.int_value);
+                } else {
+                    token.type = TOKEN_WORD;
+                    token.value = rule.replacement;
+                    token.word_id = rule.replacementId;
+                }
+                token.original_type = token.type;
+                token.word_len = static_cast<uint32_t>(rule.replacement.size());
+                rewritten.push_back(token);
+            }
+            rule.hits++;
+            changed++;
+            i += rule.pattern.size();
+        }
+        if (changed == 0) break;
+        tokens.swap(rewritten);
+        rewrites += changed;
+    }
+    return rewrites;
+}
+
+bool Peephole::usesSymbol(const uint32_t id) const {
+    for (const auto &rule: rules) {
+        if (rule.replacementId == id) return true;
+        if (std::find(rule.pattern.begin(), rule.pattern.end(), id) != rule.pattern.end()) return true;
+    }
+    return false;
+}
+
+void Peephole::display() const {
+    std::cout << "Peephole rules:" << std::endl;
+    uint64_t total = 0;
+    for (const auto &rule: rules) {
+        std::cout << "  " << std::setw(10) << rule.hits << "  " << rule.text << std::endl;
+        total += rule.hits;
+    }
+    std::cout << "  " << std::setw(10) << total << "  rewrites in all" << std::endl;
+}
@@ -0,0 +1,179 @@
+#include "PerfCounters.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+PerfCounters::PerfCounters() {
+    fds.fill(-1);
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+const char *PerfCounters::name(const Event event) {
+    switch (event) {
+        case CYCLES: return "cycles";
+        case INSTRUCTIONS: return "instructions";
+        case BRANCH_MISSES: return "branch-misses";
+        case L1D_MISSES: return "L1d-misses";
+        case LLC_MISSES: return "LLC-misses";
+        default: return "";
+    }
+}
+
+#ifdef __linux__
+
+namespace {
+    constexpr uint64_t cacheReadMiss(const uint64_t cache) {
+        return cache | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    }
+
+    // read format with PERF_FORMAT_GROUP, TOTAL_TIME_ENABLED, TOTAL_TIME_RUNNING and ID
+    struct GroupRead {
+        uint64_t events;
+        uint64_t enabled;
+        uint64_t running;
+        struct {
+            uint64_t value;
+            uint64_t id;
+        } values[PerfCounters::EVENTS];
+    };
+}
+
+bool PerfCounters::open() {
+    if (available()) return true;
+    static constexpr std::array<std::pair<uint32_t, uint64_t>, EVENTS> events = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL)},
+    }};
+
+    int firstErrno = 0;
+    for (int e = 0; e < EVENTS; e++) {
+        perf_event_attr attr{};
+        attr.size = sizeof attr;
+        attr.type = events[e].first;
+        attr.config = events[e].second;
+        attr.disabled = leader < 0; // the group is enabled through its leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING |
+                           PERF_FORMAT_ID;
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            if (firstErrno == 0) firstErrno = errno;
+            continue;
+        }
+        fds[e] = fd;
+        ioctl(fd, PERF_EVENT_IOC_ID, &ids[e]);
+        if (leader < 0) leader = fd;
+    }
+
+    if (!available()) {
+        lastError = std::string("perf_event_open: ") + strerror(firstErrno);
+        if (firstErrno == EACCES || firstErrno == EPERM) {
+            std::ifstream paranoid("/proc/sys/kernel/perf_event_paranoid");
+            int level = 0;
+            if (paranoid >> level) lastError += " (kernel.perf_event_paranoid is " + std::to_string(level) + ")";
+        } else if (firstErrno == ENOENT || firstErrno == ENODEV || firstErrno == ENOSYS) {
+            lastError += " (no hardware counters here, a virtual machine or container may not offer them)";
+        }
+        return false;
+    }
+    return true;
+}
+
+void PerfCounters::close() {
+    for (int &fd: fds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    leader = -1;
+}
+
+void PerfCounters::start() {
+    if (!available()) return;
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::Counts PerfCounters::stop() {
+    Counts counts;
+    if (!available()) return counts;
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    GroupRead group{};
+    if (read(leader, &group, sizeof group) <= 0 || group.running == 0) return counts;
+
+    // a multiplexed group ran part of the time, scale up to the time it was enabled
+    const double scale = static_cast<double>(group.enabled) / static_cast<double>(group.running);
+    counts.valid = true;
+    counts.scaled = group.running < group.enabled;
+    for (uint64_t i = 0; i < group.events && i < EVENTS; i++) {
+        for (int e = 0; e < EVENTS; e++) {
+            if (fds[e] >= 0 && ids[e] == group.values[i].id) {
+                counts.counted[e] = true;
+                counts.values[e] = static_cast<double>(group.values[i].value) * scale;
+            }
+        }
+    }
+    return counts;
+}
+
+#else
+
+bool PerfCounters::open() {
+    lastError = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+void PerfCounters::close() {
+}
+
+void PerfCounters::start() {
+}
+
+PerfCounters::Counts PerfCounters::stop() {
+    return {};
+}
+
+#endif
+
+void PerfCounters::display(const Counts &counts, const uint64_t iterations) {
+    if (!counts.valid) {
+        std::cout << "  counters not counted" << std::endl;
+        return;
+    }
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+    const double n = static_cast<double>(iterations == 0 ? 1 : iterations);
+    std::cout << std::fixed << std::setprecision(2);
+    for (int e = 0; e < EVENTS; e++) {
+        std::cout << "  " << name(static_cast<Event>(e)) << " ";
+        if (counts.counted[e]) {
+            std::cout << counts.values[e] / n;
+        } else {
+            std::cout << "n/a";
+        }
+    }
+    if (counts.counted[CYCLES] && counts.counted[INSTRUCTIONS] && counts.values[CYCLES] > 0) {
+        std::cout << "  IPC " << counts.values[INSTRUCTIONS] / counts.values[CYCLES];
+    }
+    std::cout << (iterations > 1 ? " per iteration" : "");
+    if (counts.scaled) std::cout << " (scaled, the counters were shared)";
+    std::cout << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
@@ -0,0 +1,181 @@
+#include "PerfMap.h"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// jitdump format, see tools/perf/Documentation/jitdump-specification.txt in the Linux sources
+namespace {
+    constexpr uint32_t JITDUMP_MAGIC = 0x4A695444; // "JiTD"
+    constexpr uint32_t JITDUMP_VERSION = 1;
+    constexpr uint32_t ELF_MACHINE_X86_64 = 62;
+    constexpr uint32_t JIT_CODE_LOAD = 0;
+    constexpr uint32_t JIT_CODE_CLOSE = 3;
+
+    struct JitHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t totalSize;
+        uint32_t elfMachine;
+        uint32_t pad;
+        uint32_t pid;
+        uint64_t timestamp;
+        uint64_t flags;
+    };
+
+    struct JitRecord {
+        uint32_t id;
+        uint32_t totalSize;
+        uint64_t timestamp;
+    };
+
+    // followed by the name, with its 0, and the code bytes
+    struct JitCodeLoad {
+        JitRecord record;
+        uint32_t pid;
+        uint32_t tid;
+        uint64_t vma;
+        uint64_t codeAddress;
+        uint64_t codeSize;
+        uint64_t codeIndex;
+    };
+
+    // perf record -k 1 stamps samples with CLOCK_MONOTONIC
+    uint64_t timestamp() {
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+    }
+
+    uint32_t threadId() {
+#ifdef __linux__
+        return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+        return static_cast<uint32_t>(getpid());
+#endif
+    }
+}
+
+PerfMap::~PerfMap() {
+    setMode(Mode::OFF);
+}
+
+std::string PerfMap::mapPath() const {
+    return "/tmp/perf-" + std::to_string(getpid()) + ".map";
+}
+
+std::string PerfMap::dumpPath() const {
+    return "/tmp/jit-" + std::to_string(getpid()) + ".dump";
+}
+
+void PerfMap::add(const std::string_view name, const void *code, const size_t size) {
+    if (!code || size == 0) return;
+    symbols.push_back({std::string(name), reinterpret_cast<uintptr_t>(code), size});
+    if (mapFile) writeMap(symbols.back());
+    if (dumpFile) writeDump(symbols.back());
+}
+
+void PerfMap::remove(const void *code) {
+    const auto start = reinterpret_cast<uintptr_t>(code);
+    symbols.erase(std::remove_if(symbols.begin(), symbols.end(),
+                                 [start](const Symbol &symbol) { return symbol.start == start; }),
+                  symbols.end());
+}
+
+void PerfMap::setMode(const Mode newMode) {
+    if (newMode == currentMode) return;
+
+    if (mapFile) {
+        fclose(mapFile);
+        mapFile = nullptr;
+    }
+    closeDump();
+    currentMode = Mode::OFF;
+    if (newMode == Mode::OFF) return;
+
+    mapFile = fopen(mapPath().c_str(), "w");
+    if (!mapFile) {
+        std::cerr << "PerfMap: cannot write " << mapPath() << std::endl;
+        return;
+    }
+    if (newMode == Mode::JITDUMP && !openDump()) {
+        fclose(mapFile);
+        mapFile = nullptr;
+        return;
+    }
+    currentMode = newMode;
+
+    // name the code compiled before
+    for (const auto &symbol: symbols) {
+        writeMap(symbol);
+        if (dumpFile) writeDump(symbol);
+    }
+}
+
+void PerfMap::writeMap(const Symbol &symbol) {
+    fprintf(mapFile, "%lx %zx %s\n", static_cast<unsigned long>(symbol.start), symbol.size, symbol.name.c_str());
+    fflush(mapFile);
+}
+
+void PerfMap::writeDump(const Symbol &symbol) {
+    JitCodeLoad load{};
+    load.record.id = JIT_CODE_LOAD;
+    load.record.totalSize = static_cast<uint32_t>(sizeof load + symbol.name.size() + 1 + symbol.size);
+    load.record.timestamp = timestamp();
+    load.pid = static_cast<uint32_t>(getpid());
+    load.tid = threadId();
+    load.vma = symbol.start;
+    load.codeAddress = symbol.start;
+    load.codeSize = symbol.size;
+    load.codeIndex = codeIndex++;
+    fwrite(&load, sizeof load, 1, dumpFile);
+    fwrite(symbol.name.c_str(), symbol.name.size() + 1, 1, dumpFile);
+    fwrite(reinterpret_cast<const void *>(symbol.start), symbol.size, 1, dumpFile);
+    fflush(dumpFile);
+}
+
+bool PerfMap::openDump() {
+    dumpFile = fopen(dumpPath().c_str(), "w+");
+    if (!dumpFile) {
+        std::cerr << "PerfMap: cannot write " << dumpPath() << std::endl;
+        return false;
+    }
+    JitHeader header{};
+    header.magic = JITDUMP_MAGIC;
+    header.version = JITDUMP_VERSION;
+    header.totalSize = sizeof header;
+    header.elfMachine = ELF_MACHINE_X86_64;
+    header.pid = static_cast<uint32_t>(getpid());
+    header.timestamp = timestamp();
+    fwrite(&header, sizeof header, 1, dumpFile);
+    fflush(dumpFile);
+
+    // perf record finds the dump by this executable mapping of it
+    dumpMarkerSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    dumpMarker = mmap(nullptr, dumpMarkerSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(dumpFile), 0);
+    if (dumpMarker == MAP_FAILED) {
+        std::cerr << "PerfMap: cannot map " << dumpPath() << ", perf inject will not find it" << std::endl;
+        dumpMarker = nullptr;
+    }
+    codeIndex = 0;
+    return true;
+}
+
+void PerfMap::closeDump() {
+    if (!dumpFile) return;
+    JitRecord close{};
+    close.id = JIT_CODE_CLOSE;
+    close.totalSize = sizeof close;
+    close.timestamp = timestamp();
+    fwrite(&close, sizeof close, 1, dumpFile);
+    if (dumpMarker) {
+        munmap(dumpMarker, dumpMarkerSize);
+        dumpMarker = nullptr;
+    }
+    fclose(dumpFile);
+    dumpFile = nullptr;
+}
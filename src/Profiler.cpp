@@ -0,0 +1,215 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <pthread.h>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include "ForthDictionary.h"
+#include "PerfMap.h"
+#include "SignalHandler.h"
+#ifdef __APPLE__
+#include <sys/ucontext.h>
+#else
+#include <ucontext.h>
+#endif
+
+Profiler::~Profiler() {
+    stop();
+}
+
+void Profiler::start() {
+    stop();
+    samples.assign(MAX_SAMPLES, Sample{});
+    taken = 0;
+    dropped = 0;
+
+    // the return addresses are between the interrupted stack pointer and the top of this thread's stack
+#ifdef __APPLE__
+    const pthread_t self = pthread_self();
+    stackTop = reinterpret_cast<uintptr_t>(pthread_get_stackaddr_np(self));
+    stackLow = stackTop - pthread_get_stacksize_np(self);
+#else
+    pthread_attr_t attributes;
+    void *low = nullptr;
+    size_t size = 0;
+    pthread_getattr_np(pthread_self(), &attributes);
+    pthread_attr_getstack(&attributes, &low, &size);
+    pthread_attr_destroy(&attributes);
+    stackLow = reinterpret_cast<uintptr_t>(low);
+    stackTop = stackLow + size;
+#endif
+
+    profiling = SignalHandler::instance().arm_profile_timer(SAMPLE_HZ, sample);
+    if (!profiling) {
+        std::cerr << "PROFILE: cannot arm the SIGPROF timer" << std::endl;
+    }
+}
+
+void Profiler::stop() {
+    if (!profiling) return;
+    SignalHandler::instance().disarm_profile_timer();
+    profiling = false;
+}
+
+size_t Profiler::sampleCount() const {
+    return std::min(taken.load(), samples.size());
+}
+
+// In the SIGPROF handler: no allocation, no locks
+void Profiler::sample(const void *context) {
+    Profiler &profiler = instance();
+    const size_t slot = profiler.taken.load(std::memory_order_relaxed);
+    if (slot >= profiler.samples.size()) {
+        profiler.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+#ifdef __APPLE__
+    const auto *machine = static_cast<const ucontext_t *>(context)->uc_mcontext;
+    const uintptr_t pc = machine->__ss.__rip;
+    const uintptr_t sp = machine->__ss.__rsp;
+#else
+    const auto &registers = static_cast<const ucontext_t *>(context)->uc_mcontext.gregs;
+    const auto pc = static_cast<uintptr_t>(registers[REG_RIP]);
+    const auto sp = static_cast<uintptr_t>(registers[REG_RSP]);
+#endif
+
+    Sample &s = profiler.samples[slot];
+    s.pc = pc;
+    s.depth = 0;
+    if (sp >= profiler.stackLow && sp < profiler.stackTop) {
+        const auto *stack = reinterpret_cast<const uintptr_t *>(sp);
+        const size_t available = (profiler.stackTop - sp) / sizeof(uintptr_t);
+        s.depth = std::min(available, STACK_WORDS);
+        std::copy(stack, stack + s.depth, s.stack);
+    }
+    profiler.taken.store(slot + 1, std::memory_order_release);
+}
+
+std::vector<std::vector<int>> Profiler::chains(std::vector<std::string> &names) const {
+    struct Range {
+        uintptr_t start;
+        uintptr_t end;
+        int name;
+    };
+
+    // code ranges from the JIT, named by the dictionary entry that runs them
+    std::unordered_map<uintptr_t, std::string_view> wordNames;
+    ForthDictionary::instance().forEachEntry([&wordNames](ForthDictionaryEntry *entry) {
+        if (entry->executable) {
+            wordNames.emplace(reinterpret_cast<uintptr_t>(entry->executable), entry->getWordName());
+        }
+    });
+    names.assign(1, "(other code)");
+    std::unordered_map<std::string, int> nameIndex;
+    std::vector<Range> ranges;
+    for (const auto &symbol: PerfMap::instance().code()) {
+        const auto word = wordNames.find(symbol.start);
+        std::string name = word != wordNames.end() ? std::string(word->second) : symbol.name;
+        const auto [it, added] = nameIndex.emplace(name, static_cast<int>(names.size()));
+        if (added) names.push_back(name);
+        ranges.push_back({symbol.start, symbol.start + symbol.size, it->second});
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) { return a.start < b.start; });
+
+    const auto find = [&ranges](const uintptr_t address) -> const Range * {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), address,
+                                   [](const uintptr_t a, const Range &r) { return a < r.start; });
+        if (it == ranges.begin()) return nullptr;
+        --it;
+        return address < it->end ? &*it : nullptr;
+    };
+
+    std::vector<std::vector<int>> result;
+    const size_t count = sampleCount();
+    result.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const Sample &s = samples[i];
+        std::vector<int> chain;
+        const Range *leaf = find(s.pc);
+        chain.push_back(leaf ? leaf->name : 0);
+        for (size_t k = 0; k < s.depth; k++) {
+            const Range *caller = find(s.stack[k]);
+            // the start of a word is a pointer to it, not a return address
+            if (!caller || s.stack[k] == caller->start) continue;
+            if (caller->name != chain.back()) chain.push_back(caller->name);
+        }
+        result.push_back(std::move(chain));
+    }
+    return result;
+}
+
+std::vector<Profiler::WordProfile> Profiler::flat() const {
+    std::vector<std::string> names;
+    const auto sampled = chains(names);
+    std::vector<WordProfile> words(names.size());
+    for (size_t i = 0; i < names.size(); i++) words[i].name = names[i];
+    for (const auto &chain: sampled) {
+        words[chain.front()].self++;
+        for (const int word: std::set<int>(chain.begin(), chain.end())) {
+            words[word].total++;
+        }
+    }
+    words.erase(std::remove_if(words.begin(), words.end(), [](const WordProfile &w) { return w.total == 0; }),
+                words.end());
+    std::sort(words.begin(), words.end(), [](const WordProfile &a, const WordProfile &b) {
+        return a.self != b.self ? a.self > b.self : a.total > b.total;
+    });
+    return words;
+}
+
+std::vector<Profiler::CallProfile> Profiler::callGraph() const {
+    std::vector<std::string> names;
+    const auto sampled = chains(names);
+    std::map<std::pair<int, int>, size_t> counts;
+    for (const auto &chain: sampled) {
+        std::set<std::pair<int, int> > calls;
+        for (size_t i = 0; i + 1 < chain.size(); i++) {
+            calls.emplace(chain[i + 1], chain[i]);
+        }
+        for (const auto &call: calls) counts[call]++;
+    }
+    std::vector<CallProfile> result;
+    for (const auto &[call, samplesUnder]: counts) {
+        result.push_back({names[call.first], names[call.second], samplesUnder});
+    }
+    std::sort(result.begin(), result.end(), [](const CallProfile &a, const CallProfile &b) {
+        return a.samples > b.samples;
+    });
+    return result;
+}
+
+void Profiler::report() {
+    stop();
+    const size_t count = sampleCount();
+    std::cout << "Profile: " << count << " samples, SIGPROF at " << SAMPLE_HZ << " Hz of CPU time";
+    if (dropped > 0) std::cout << " (" << dropped << " dropped, the buffer is full)";
+    std::cout << std::endl;
+    if (count == 0) return;
+
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+    const auto percent = [count](const size_t n) { return 100.0 * static_cast<double>(n) / static_cast<double>(count); };
+    std::cout << std::fixed << std::setprecision(1);
+
+    std::cout << "    self       %    total       %  word" << std::endl;
+    for (const auto &word: flat()) {
+        std::cout << std::setw(8) << word.self << std::setw(8) << percent(word.self)
+                << std::setw(9) << word.total << std::setw(8) << percent(word.total)
+                << "  " << word.name << std::endl;
+    }
+
+    const auto calls = callGraph();
+    if (!calls.empty()) {
+        std::cout << "Calls (samples under the callee, called from the caller):" << std::endl;
+        for (const auto &call: calls) {
+            std::cout << std::setw(8) << call.samples << std::setw(8) << percent(call.samples)
+                    << "  " << call.caller << " -> " << call.callee << std::endl;
+        }
+    }
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
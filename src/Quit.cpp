@@ -4,6 +4,8 @@
 #include "Quit.h"
 
 #include <fstream>
+#include <chrono>
+#include <vector>
 #include <Interpreter.h>
 #include <unordered_set>
 
@@ -82,6 +84,26 @@ void to_uppercase(std::string &str) {
 // used by the FLOAD file.f command.
 std::unordered_set<std::string> loaded_files;
 
+// wall clock time of each file load, nested loads are included in their parent
+struct LoadTiming {
+    std::string filename;
+    std::chrono::steady_clock::duration time;
+};
+
+static std::vector<LoadTiming> load_timings;
+
+void display_load_timings() {
+    if (load_timings.empty()) {
+        std::cout << "No files loaded" << std::endl;
+        return;
+    }
+    std::cout << "File loads:" << std::endl;
+    for (const auto &[filename, time]: load_timings) {
+        std::cout << "    " << filename << ": "
+                  << std::chrono::duration<double, std::milli>(time).count() << " ms" << std::endl;
+    }
+}
+
 
 void include_file(const std::string &filename) {
 
@@ -100,6 +122,7 @@ void include_file(const std::string &filename) {
         std::cerr << "Error: Could not open file: " << filename << std::endl;
         return;
     }
+    const auto start = std::chrono::steady_clock::now();
 
     std::string line;
     std::string accumulated_input;
@@ -151,6 +174,7 @@ void include_file(const std::string &filename) {
     }
 
     file.close(); // Close the file
+    load_timings.push_back({filename, std::chrono::steady_clock::now() - start});
 
 }
 
@@ -180,6 +204,7 @@ void process_forth_file(const std::string &filename) {
     bool compiling = false;
 
     std::cout << "Processing file: " << filename << std::endl;
+    const auto start = std::chrono::steady_clock::now();
 
     // Process each line in the file
     while (std::getline(file, line)) {
@@ -228,7 +253,10 @@ void process_forth_file(const std::string &filename) {
         }
     }
 
-    std::cout << "Finished processing file: " << filename << std::endl;
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    load_timings.push_back({filename, elapsed});
+    std::cout << "Finished processing file: " << filename << " in "
+              << std::chrono::duration<double, std::milli>(elapsed).count() << " ms" << std::endl;
 
     file.close(); // Close the file
 
@@ -296,6 +324,7 @@ void Quit() {
             interactive_terminal();
         } else {
             // If an exception is raised (via longjmp), handle it here
+            Interpreter::instance().recover();
             // std::cout << "Recovered from a runtime error. Restarting interpreter." << std::endl;
         }
     }
@@ -2,6 +2,7 @@
 #include <csignal>
 #include <csetjmp>
 #include <cstdio>
+#include <sys/time.h>
 
 // Public method to raise an exception
 void SignalHandler::raise(int eno) {
@@ -29,6 +30,33 @@ void SignalHandler::register_signal_handlers() {
 }
 
 
+static volatile SignalHandler::ProfileSampler profileSampler = nullptr;
+
+static void handle_profile_signal(int, siginfo_t *, void *context) {
+    if (const auto sampler = profileSampler) sampler(context);
+}
+
+bool SignalHandler::arm_profile_timer(const int hz, const ProfileSampler sampler) {
+    profileSampler = sampler;
+    struct sigaction action{};
+    action.sa_sigaction = handle_profile_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) return false;
+
+    itimerval timer{};
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value = timer.it_interval;
+    return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+}
+
+void SignalHandler::disarm_profile_timer() {
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    profileSampler = nullptr;
+}
+
+
 // Static: General signal handling logic
 void SignalHandler::handle_signal(int signal_number) {
     // Map the signal number to an error code
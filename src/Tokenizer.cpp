@@ -11,23 +11,65 @@
 #include <ForthDictionary.h>
 #include "SymbolTable.h"
 
-bool is_number(const std::string &s) {
-    try {
-        std::stoll(s, nullptr, 0);
-        return true;
-    } catch (...) {
-        return false;
-    }
+// Digit value of c, or 36 when c is not a digit in any base
+static unsigned digit_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+    return 36;
 }
 
-int64_t parseNumber(const std::string &word) {
-    try {
-        return std::stoll(word, nullptr, 0);
-    } catch (...) {
-        throw std::invalid_argument("Invalid number: " + word);
+// Parses a whole token as an integer without throwing.
+// Accepts an optional '-' and the prefixes 0x (hex), $ (hex), # (decimal)
+// and % (binary), the '-' may come before or after the prefix.
+// Otherwise digits are read in the given base (BASE).
+// 64 bit values are accepted as cells, so FFFFFFFFFFFFFFFF is -1.
+bool parse_number(const char *str, size_t len, int base, int64_t &result) {
+    const char *p = str;
+    const char *end = str + len;
+
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+
+    if (p < end) {
+        if (*p == '$') {
+            base = 16;
+            p++;
+        } else if (*p == '#') {
+            base = 10;
+            p++;
+        } else if (*p == '%') {
+            base = 2;
+            p++;
+        } else if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            base = 16;
+            p += 2;
+        }
+    }
+
+    if (!negative && p < end && *p == '-' && p != str) {
+        negative = true;
+        p++;
+    }
+
+    if (p == end) return false; // no digits
+
+    uint64_t value = 0;
+    for (; p < end; p++) {
+        const unsigned digit = digit_value(*p);
+        if (digit >= static_cast<unsigned>(base)) return false;
+        if (__builtin_mul_overflow(value, static_cast<uint64_t>(base), &value) ||
+            __builtin_add_overflow(value, static_cast<uint64_t>(digit), &value)) {
+            return false; // does not fit in a cell
+        }
     }
-}
 
+    result = static_cast<int64_t>(negative ? 0 - value : value);
+    return true;
+}
 
 void Tokenizer::print_token(const ForthToken &token) {
     switch (token.type) {
@@ -37,6 +79,9 @@ void Tokenizer::print_token(const ForthToken &token) {
         case TOKEN_WORD:
             std::cout << "WORD:" << '\t' << '[' << token.value << "]\n";
             break;
+        case TOKEN_CALL:
+            std::cout << "CALL:" << '\t' << '[' << token.value << "]\n";
+            break;
         case TOKEN_NUMBER:
             std::cout << "NUMBER:" << '\t' << '[' << token.int_value << "]\n";
             break;
@@ -143,7 +188,8 @@ ForthToken Tokenizer::get_next_token(const char **input) {
     }
 
     int i = 0;
-    char temp[MAX_TOKEN_LENGTH] = {0};
+    char temp[MAX_TOKEN_LENGTH]; // NUL terminated below
+    const char *start = *input; // token text is viewed in place
 
     // 🔥 Improved token parsing: Allow words to end in `"`, but not start with it
     while (**input && !isspace(**input) && i < MAX_TOKEN_LENGTH - 1) {
@@ -162,19 +208,19 @@ ForthToken Tokenizer::get_next_token(const char **input) {
     // 🔍 Check if the token is a word ending in `"`, like `S"` or `."`
     if (i > 1 && temp[i - 1] == '"') {
         token.type = TOKEN_WORD;
-        token.value = temp; // Store the full word (e.g., `."`, `S"`)
-        token.word_len = strlen(temp);
-        token.word_id = SymbolTable::instance().addSymbol(temp);
+        token.word_len = i;
+        token.word_id = SymbolTable::instance().addSymbol(std::string_view(temp, i));
+        token.value = SymbolTable::instance().getSymbol(token.word_id); // Store the full word (e.g., `."`, `S"`)
         return token;
     }
 
     // ✅ Regular word lookup
-    if (auto word_id = SymbolTable::instance().definedSymbol(temp); word_id != 0) {
+    if (auto word_id = SymbolTable::instance().definedSymbol(std::string_view(temp, i)); word_id != 0) {
         token.type = TOKEN_WORD;
-        token.value = temp;
+        token.value = SymbolTable::instance().getSymbol(word_id);
         token.word_id = word_id;
-        token.word_len = strlen(temp);
-        if (const auto &dict = ForthDictionary::instance(); dict.isVariable(temp)) {
+        token.word_len = i;
+        if (const auto &dict = ForthDictionary::instance(); dict.isVariable(word_id)) {
             token.type = TOKEN_VARIABLE;
         }
         return token;
@@ -196,19 +242,22 @@ ForthToken Tokenizer::get_next_token(const char **input) {
 
     } else if (strcmp(temp, "{") == 0) {
         token.type = TOKEN_BEGINLOCALS;
-        token.value = temp;
+        token.value = std::string_view(start, i);
     } else if (strcmp(temp, "}") == 0) {
         token.type = TOKEN_ENDLOCALS;
-    } else if (is_float(temp)) {
-        token.type = TOKEN_FLOAT;
-        token.float_value = atof(temp);
-    } else if (is_number(temp)) {
+    } else if (int64_t number; parse_number(temp, i, numberBase, number)) {
         token.type = TOKEN_NUMBER;
-        token.int_value = parseNumber(temp);
+        token.int_value = static_cast<uint64_t>(number);
+        token.value = std::string_view(start, i); // for rebase
+    } else if (numberBase == 10 && is_float(temp)) {
+        // floats are only recognized in decimal, 1E3 is a number in HEX
+        token.type = TOKEN_FLOAT;
+        token.float_value = strtod(temp, nullptr);
+        token.value = std::string_view(start, i);
     } else {
         // and unknown word may be swallowed by CREATE, VARIABLE, CONSTANT etc
         token.type = TOKEN_UNKNOWN;
-        token.value = temp;
+        token.value = std::string_view(start, i);
 
         //std::cerr << "Error: Unknown token: " << temp << std::endl;
         //raise_c(5);
@@ -217,10 +266,45 @@ ForthToken Tokenizer::get_next_token(const char **input) {
     return token;
 }
 
+// BASE as set by the running program, 10 if BASE is missing or out of range
+int Tokenizer::current_base() {
+    if (!baseCell) {
+        const auto base_word = ForthDictionary::instance().findWord(std::string_view("BASE"));
+        if (!base_word || !base_word->data) return 10;
+        baseCell = static_cast<const int64_t *>(base_word->data);
+    }
+    const int64_t base = *baseCell;
+    return (base >= 2 && base <= 36) ? static_cast<int>(base) : 10;
+}
+
+void Tokenizer::rebase(std::deque<ForthToken> &tokens, int &tokensBase) {
+    const int base = current_base();
+    if (base == tokensBase) return;
+    tokensBase = base;
+
+    char temp[MAX_TOKEN_LENGTH];
+    for (ForthToken &token: tokens) {
+        if (token.type != TOKEN_NUMBER && token.type != TOKEN_FLOAT && token.type != TOKEN_UNKNOWN) continue;
+        if (token.value.empty() || token.value.size() >= MAX_TOKEN_LENGTH) continue;
+        const size_t length = token.value.size();
+        std::memcpy(temp, token.value.data(), length);
+        temp[length] = '\0';
+        if (int64_t number; parse_number(temp, length, base, number)) {
+            token.type = TOKEN_NUMBER;
+            token.int_value = static_cast<uint64_t>(number);
+        } else if (base == 10 && is_float(temp)) {
+            token.type = TOKEN_FLOAT;
+            token.float_value = strtod(temp, nullptr);
+        } else {
+            token.type = TOKEN_UNKNOWN;
+            token.int_value = 0;
+        }
+    }
+}
+
 ForthToken get_string_token(const char **input) {
     ForthToken token;
-    token.type = TOKEN_STRING;
-    token.value = ""; // Initialize value as empty string
+    token.type = TOKEN_STRING; // value starts out empty
 
     if (**input == '\0') return token; // 🚨 Prevent buffer overrun
 
@@ -233,9 +317,11 @@ ForthToken get_string_token(const char **input) {
 
     // 🚨 Prevent infinite loops and buffer overruns
     int max_length = MAX_INPUT; // Avoid unbounded loops
+    const char *start = *input;
     while (**input && **input != '"' && max_length-- > 0) {
-        token.value += *(*input)++;
+        (*input)++;
     }
+    token.value = std::string_view(start, *input - start);
 
     // 🚨 Avoid dereferencing null pointers
     if (**input == '"') {
@@ -251,6 +337,8 @@ ForthToken get_string_token(const char **input) {
 int Tokenizer::tokenize_forth(const std::string &input, std::deque<ForthToken> &tokens) {
     const char *cursor = input.c_str(); // Pointer for traversing input
     tokens.clear(); // Clear any pre-existing tokens
+    baseCell = nullptr; // a line run since may have defined another BASE
+    numberBase = current_base();
 
 
 
@@ -0,0 +1,405 @@
+#include "VirtualStack.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <asmjit/asmjit.h>
+#include "CodeGenerator.h"
+#include "ForthDictionary.h"
+#include "Settings.h"
+
+namespace {
+    enum class StackOp { DUP, DROP, SWAP, OVER, ROT, NIP, TUCK, TWO_DUP, TWO_DROP, ADD, SUB, AND, OR, LITERAL };
+
+    struct StackWord {
+        std::string_view name;
+        StackOp op;
+        int instructions; // emitted by the word's own generator
+    };
+
+    // -ROT and XOR keep their own generators
+    constexpr StackWord stackWords[] = {
+        {"DUP", StackOp::DUP, 3}, {"DROP", StackOp::DROP, 3}, {"SWAP", StackOp::SWAP, 1},
+        {"OVER", StackOp::OVER, 5}, {"ROT", StackOp::ROT, 4}, {"NIP", StackOp::NIP, 2},
+        {"TUCK", StackOp::TUCK, 2}, {"2DUP", StackOp::TWO_DUP, 3}, {"2DROP", StackOp::TWO_DROP, 3},
+        {"+", StackOp::ADD, 6}, {"-", StackOp::SUB, 6}, {"AND", StackOp::AND, 4}, {"OR", StackOp::OR, 4},
+    };
+
+    constexpr StackWord literalWord{"", StackOp::LITERAL, 4};
+
+    // The primitive a token stands for, if the pass models it
+    const StackWord *find_stack_word(const ForthToken &token) {
+        if (token.type == TokenType::TOKEN_NUMBER) return &literalWord;
+        if (token.type != TokenType::TOKEN_WORD) return nullptr;
+
+        for (const auto &word: stackWords) {
+            if (word.name != token.value) continue;
+            // a user definition of the same name is called, not modelled
+            const auto entry = ForthDictionary::instance().findWord(token.value);
+            if (entry && entry->generator && entry->type == ForthWordType::WORD) return &word;
+            return nullptr;
+        }
+        return nullptr;
+    }
+
+    // Where a value is: in the canonical layout as it was at the start of the run,
+    // in a scratch register, or a literal.
+    struct Value {
+        enum Kind { TOS, NOS, MEMORY, REGISTER, CONSTANT } kind;
+        int64_t n; // MEMORY: offset from R15 at the start, REGISTER: register id, CONSTANT: value
+
+        bool operator==(const Value &other) const { return kind == other.kind && n == other.n; }
+    };
+
+    constexpr int RAX = 0; // temporary for memory to memory moves and wide literals
+
+    // Slot k of the canonical stack, 0 is TOS, displaced by the given number of cells
+    Value canonical_slot(const int k, const int displacement = 0) {
+        if (k == 0) return {Value::TOS, 0};
+        if (k == 1) return {Value::NOS, 0};
+        return {Value::MEMORY, 8 * static_cast<int64_t>(k - 2 + displacement)};
+    }
+
+    bool fits_imm32(const int64_t value) {
+        return value >= INT32_MIN && value <= INT32_MAX;
+    }
+
+    // One straight line run. With a null assembler the run is only planned and counted.
+    class Region {
+    public:
+        explicit Region(asmjit::x86::Assembler *assembler) : a(assembler) {
+        }
+
+        // Model one word, false when the word needs a register and none is left
+        bool apply(const StackWord &word, const ForthToken &token);
+
+        // Write the symbolic stack back to R13/R12/[R15]
+        void materialize();
+
+        [[nodiscard]] int instructions() const { return emitted; }
+
+    private:
+        asmjit::x86::Assembler *a;
+        std::vector<Value> stack; // values pushed in the run, top last
+        int consumed = 0; // canonical slots taken by the run
+        std::vector<int> freeRegisters{9, 8, 6, 2, 1}; // r9 r8 rsi rdx rcx, r10/r11 may hold a DO loop
+        int emitted = 0;
+
+        Value pop() {
+            if (stack.empty()) return canonical_slot(consumed++);
+            const Value value = stack.back();
+            stack.pop_back();
+            return value;
+        }
+
+        void push(const Value &value) { stack.push_back(value); }
+
+        [[nodiscard]] bool referenced(const Value &value) const {
+            return std::find(stack.begin(), stack.end(), value) != stack.end();
+        }
+
+        // Return a scratch register to the pool once nothing refers to it
+        void release(const Value &value, const int keep = -1) {
+            if (value.kind != Value::REGISTER || value.n == keep || referenced(value)) return;
+            const int reg = static_cast<int>(value.n);
+            if (std::find(freeRegisters.begin(), freeRegisters.end(), reg) == freeRegisters.end()) {
+                freeRegisters.push_back(reg);
+            }
+        }
+
+        void binary(StackOp op, const Value &x, const Value &y);
+
+        void arith(StackOp op, int reg, const Value &src);
+
+        void move(const Value &dst, const Value &src);
+
+        static asmjit::x86::Gp gp(const Value &value) {
+            if (value.kind == Value::TOS) return asmjit::x86::r13;
+            if (value.kind == Value::NOS) return asmjit::x86::r12;
+            return asmjit::x86::gpq(static_cast<uint32_t>(value.n));
+        }
+
+        static asmjit::x86::Mem memory(const Value &value) {
+            return asmjit::x86::qword_ptr(asmjit::x86::r15, static_cast<int32_t>(value.n));
+        }
+
+        template<typename Dst, typename Src>
+        void emit_mov(const Dst &dst, const Src &src) {
+            emitted++;
+            if (a) a->mov(dst, src);
+        }
+
+        template<typename Src>
+        void emit_arith(const StackOp op, const asmjit::x86::Gp &dst, const Src &src) {
+            emitted++;
+            if (!a) return;
+            switch (op) {
+                case StackOp::ADD: a->add(dst, src);
+                    break;
+                case StackOp::SUB: a->sub(dst, src);
+                    break;
+                case StackOp::AND: a->and_(dst, src);
+                    break;
+                default: a->or_(dst, src);
+                    break;
+            }
+        }
+    };
+
+    bool Region::apply(const StackWord &word, const ForthToken &token) {
+        switch (word.op) {
+            case StackOp::DUP: {
+                const Value x = pop();
+                push(x);
+                push(x);
+                break;
+            }
+            case StackOp::DROP:
+                release(pop());
+                break;
+            case StackOp::SWAP: {
+                const Value y = pop();
+                const Value x = pop();
+                push(y);
+                push(x);
+                break;
+            }
+            case StackOp::OVER: {
+                const Value y = pop();
+                const Value x = pop();
+                push(x);
+                push(y);
+                push(x);
+                break;
+            }
+            case StackOp::ROT: {
+                const Value z = pop();
+                const Value y = pop();
+                const Value x = pop();
+                push(y);
+                push(z);
+                push(x);
+                break;
+            }
+            case StackOp::NIP: {
+                const Value y = pop();
+                const Value x = pop();
+                push(y);
+                release(x);
+                break;
+            }
+            case StackOp::TUCK: {
+                const Value y = pop();
+                const Value x = pop();
+                push(y);
+                push(x);
+                push(y);
+                break;
+            }
+            case StackOp::TWO_DUP: {
+                const Value y = pop();
+                const Value x = pop();
+                push(x);
+                push(y);
+                push(x);
+                push(y);
+                break;
+            }
+            case StackOp::TWO_DROP: {
+                const Value y = pop();
+                const Value x = pop();
+                release(y);
+                release(x);
+                break;
+            }
+            case StackOp::LITERAL:
+                push({Value::CONSTANT, static_cast<int64_t>(token.int_value)});
+                break;
+            default: {
+                // one register for the result, one kept back for breaking cycles in materialize
+                if (freeRegisters.size() < 2) return false;
+                const Value y = pop();
+                const Value x = pop();
+                binary(word.op, x, y);
+                break;
+            }
+        }
+        return true;
+    }
+
+    void Region::binary(const StackOp op, const Value &x, const Value &y) {
+        if (x.kind == Value::CONSTANT && y.kind == Value::CONSTANT) {
+            const auto l = static_cast<uint64_t>(x.n);
+            const auto r = static_cast<uint64_t>(y.n);
+            uint64_t result;
+            switch (op) {
+                case StackOp::ADD: result = l + r;
+                    break;
+                case StackOp::SUB: result = l - r;
+                    break;
+                case StackOp::AND: result = l & r;
+                    break;
+                default: result = l | r;
+                    break;
+            }
+            push({Value::CONSTANT, static_cast<int64_t>(result)});
+            return;
+        }
+
+        const bool commutative = op != StackOp::SUB;
+        int reg;
+        if (x.kind == Value::REGISTER && !referenced(x)) {
+            reg = static_cast<int>(x.n); // x dies here, compute in place
+            arith(op, reg, y);
+        } else if (commutative && y.kind == Value::REGISTER && !referenced(y)) {
+            reg = static_cast<int>(y.n);
+            arith(op, reg, x);
+        } else {
+            reg = freeRegisters.back();
+            freeRegisters.pop_back();
+            move({Value::REGISTER, reg}, x);
+            arith(op, reg, y);
+        }
+        push({Value::REGISTER, reg});
+        release(x, reg);
+        release(y, reg);
+    }
+
+    void Region::arith(const StackOp op, const int reg, const Value &src) {
+        const auto dst = asmjit::x86::gpq(static_cast<uint32_t>(reg));
+        switch (src.kind) {
+            case Value::MEMORY:
+                emit_arith(op, dst, memory(src));
+                break;
+            case Value::CONSTANT:
+                if (fits_imm32(src.n)) {
+                    emit_arith(op, dst, asmjit::imm(src.n));
+                } else {
+                    emit_mov(asmjit::x86::rax, asmjit::imm(src.n));
+                    emit_arith(op, dst, asmjit::x86::rax);
+                }
+                break;
+            default:
+                emit_arith(op, dst, gp(src));
+                break;
+        }
+    }
+
+    void Region::move(const Value &dst, const Value &src) {
+        if (dst.kind != Value::MEMORY) {
+            if (src.kind == Value::MEMORY) {
+                emit_mov(gp(dst), memory(src));
+            } else if (src.kind == Value::CONSTANT) {
+                emit_mov(gp(dst), asmjit::imm(src.n));
+            } else {
+                emit_mov(gp(dst), gp(src));
+            }
+            return;
+        }
+
+        if (src.kind == Value::MEMORY || (src.kind == Value::CONSTANT && !fits_imm32(src.n))) {
+            const Value temp{Value::REGISTER, RAX};
+            move(temp, src);
+            emit_mov(memory(dst), gp(temp));
+        } else if (src.kind == Value::CONSTANT) {
+            emit_mov(memory(dst), asmjit::imm(src.n));
+        } else {
+            emit_mov(memory(dst), gp(src));
+        }
+    }
+
+    // The run took `consumed` slots and leaves `stack` in their place; slots below that
+    // stay in memory where they are unless the new depth moves them into or out of R12/R13.
+    void Region::materialize() {
+        const int pushed = static_cast<int>(stack.size());
+        const int displacement = consumed - pushed; // cells R15 moves up by
+        const int depth = std::max({pushed, 2, pushed + 2 - consumed});
+
+        std::vector<std::pair<Value, Value> > moves; // destination, source
+        for (int j = 0; j < depth; j++) {
+            const Value dst = canonical_slot(j, displacement);
+            const Value src = j < pushed ? stack[pushed - 1 - j] : canonical_slot(consumed + j - pushed);
+            if (!(dst == src)) moves.emplace_back(dst, src);
+        }
+
+        // parallel move: write a destination once nothing still reads it
+        while (!moves.empty()) {
+            auto ready = std::find_if(moves.begin(), moves.end(), [&](const auto &candidate) {
+                return std::none_of(moves.begin(), moves.end(), [&](const auto &other) {
+                    return &other != &candidate && other.second == candidate.first;
+                });
+            });
+            if (ready != moves.end()) {
+                move(ready->first, ready->second);
+                moves.erase(ready);
+                continue;
+            }
+            // only cycles left, save one destination in a spare register
+            const Value saved = moves.front().first;
+            const Value spare{Value::REGISTER, freeRegisters.back()};
+            move(spare, saved);
+            for (auto &[dst, src]: moves) {
+                if (src == saved) src = spare;
+            }
+        }
+
+        if (displacement != 0) {
+            emitted++;
+            if (a) {
+                if (displacement > 0) {
+                    a->add(asmjit::x86::r15, 8 * displacement);
+                } else {
+                    a->sub(asmjit::x86::r15, -8 * displacement);
+                }
+            }
+        }
+    }
+}
+
+size_t VirtualStack::compile_region(const std::deque<ForthToken> &tokens) {
+    // plan first, the run is only compiled this way if it is shorter than the primitives
+    Region plan(nullptr);
+    size_t length = 0;
+    int primitive = 0;
+    for (const auto &token: tokens) {
+        const StackWord *word = find_stack_word(token);
+        if (!word || !plan.apply(*word, token)) break;
+        primitive += word->instructions;
+        length++;
+    }
+    if (length < 2) return 0;
+    plan.materialize();
+    if (plan.instructions() >= primitive) return 0;
+
+    asmjit::x86::Assembler *assembler;
+    if (initialize_assembler(assembler)) return 0;
+    assembler->commentf("; -- virtual stack, %zu words", length);
+
+    Region region(assembler);
+    for (size_t i = 0; i < length; i++) {
+        region.apply(*find_stack_word(tokens[i]), tokens[i]);
+    }
+    region.materialize();
+
+    regions++;
+    words += length;
+    primitiveInstructions += primitive;
+    emittedInstructions += region.instructions();
+    return length;
+}
+
+void VirtualStack::reset_counts() {
+    regions = 0;
+    words = 0;
+    primitiveInstructions = 0;
+    emittedInstructions = 0;
+}
+
+void VirtualStack::report(const std::string &word_name) const {
+    if (!jitLogging || regions == 0) return;
+    std::cout << "Virtual stack: " << word_name << " " << words << " words in " << regions << " runs, "
+            << emittedInstructions << " instructions instead of " << primitiveInstructions << ", "
+            << primitiveInstructions - emittedInstructions << " moves eliminated" << std::endl;
+}
@@ -1,6 +1,7 @@
 #include <CodeGenerator.h>
 #include <gtest/gtest.h>
 #include "ForthDictionary.h"
+#include "JitContext.h"
 
 
 TEST(ForthDictionaryTest, AddWordsAndChain) {
@@ -96,9 +97,9 @@ TEST(ForthDictionaryTest, SpecialCharactersInWords) {
     ForthDictionaryEntry* word3 = dict.addWord("WORD$3", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
 
     // Verify that words with special characters exist
-    EXPECT_NE(dict.findWord("WORD_1"), word1);
-    EXPECT_NE(dict.findWord("WORD-2"), word2);
-    EXPECT_NE(dict.findWord("WORD$3"), word3);
+    EXPECT_EQ(dict.findWord("WORD_1"), word1);
+    EXPECT_EQ(dict.findWord("WORD-2"), word2);
+    EXPECT_EQ(dict.findWord("WORD$3"), word3);
 
     // Ensure invalid names are handled gracefully
     EXPECT_EQ(dict.findWord("INVALID@WORD"), nullptr);
@@ -166,6 +167,185 @@ TEST(ForthDictionaryTest, MultipleVocabulariesWithSameWord) {
     EXPECT_EQ(foundWord, vocab1Word);  // Now it should find the word from VOCAB1
 }
 
+// Test that a redefinition shadows the older word and forgetting it restores the older one
+TEST(ForthDictionaryTest, ShadowingAndForget) {
+    ForthDictionary& dict = ForthDictionary::instance();
+
+    dict.setSearchOrder({"FORTH"});
+    dict.setVocabulary("FORTH");
+
+    ForthDictionaryEntry* older = dict.addWord("SHADOWED", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
+    ForthDictionaryEntry* newer = dict.addWord("SHADOWED", ForthState::EXECUTABLE, ForthWordType::VARIABLE, "FORTH");
+
+    EXPECT_EQ(dict.findWord("SHADOWED"), newer);
+    EXPECT_TRUE(dict.isVariable("SHADOWED"));
+
+    dict.forgetLastWord();
+    EXPECT_EQ(dict.findWord("SHADOWED"), older);
+    EXPECT_FALSE(dict.isVariable("SHADOWED"));
+
+    dict.forgetLastWord();
+    EXPECT_EQ(dict.findWord("SHADOWED"), nullptr);
+}
+
+// Test MARKER style rollback, and that a shadowed definition keeps its shared data
+TEST(ForthDictionaryTest, ForgetToMarker) {
+    ForthDictionary& dict = ForthDictionary::instance();
+    auto& heap = WordHeap::instance();
+
+    dict.setSearchOrder({"FORTH"});
+    dict.setVocabulary("FORTH");
+
+    ForthDictionaryEntry* older = dict.addWord("ROLLDATA", ForthState::EXECUTABLE, ForthWordType::VARIABLE, "FORTH");
+    ASSERT_NE(heap.allocate(older->id, 8), nullptr);
+
+    ForthDictionaryEntry* marker = dict.addWord("ROLLMARK", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
+    dict.addWord("ROLLONE", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
+    ForthDictionaryEntry* newer = dict.addWord("ROLLDATA", ForthState::EXECUTABLE, ForthWordType::VARIABLE, "FORTH");
+    EXPECT_EQ(newer->id, older->id);
+
+    dict.forgetTo(marker);
+    EXPECT_EQ(dict.findWord("ROLLMARK"), nullptr);
+    EXPECT_EQ(dict.findWord("ROLLONE"), nullptr);
+    EXPECT_EQ(dict.findWord("ROLLDATA"), older);
+    EXPECT_NE(heap.getAllocation(older->id), nullptr);
+
+    dict.forgetLastWord();
+    EXPECT_EQ(dict.findWord("ROLLDATA"), nullptr);
+}
+
+static void sharedCodeWord() {
+}
+
+// Test that entries sharing one executable are counted, the code has users until the last is forgotten
+TEST(ForthDictionaryTest, SharedCodeCounted) {
+    ForthDictionary& dict = ForthDictionary::instance();
+    auto& jit = JitContext::instance();
+    const auto code = reinterpret_cast<const void*>(&sharedCodeWord);
+
+    dict.setSearchOrder({"FORTH"});
+    dict.setVocabulary("FORTH");
+
+    ForthDictionaryEntry* first = dict.addCodeWord("SHARER", "FORTH", ForthState::EXECUTABLE, ForthWordType::WORD,
+                                                   nullptr, &sharedCodeWord, nullptr);
+    EXPECT_EQ(jit.codeUsers(code), 1u);
+    ForthDictionaryEntry* second = dict.addWord("ALSOSHARER", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
+    dict.setExecutable(second, &sharedCodeWord);
+    EXPECT_EQ(jit.codeUsers(code), 2u);
+
+    dict.forgetLastWord();
+    EXPECT_EQ(jit.codeUsers(code), 1u);
+    EXPECT_EQ(first->executable, &sharedCodeWord);
+
+    dict.forgetLastWord();
+    EXPECT_EQ(jit.codeUsers(code), 0u);
+}
+
+// Test that code stored straight into an executable cell, as Forth code can through
+// the address a CREATE word pushes, is still seen as in use though it is not counted
+TEST(ForthDictionaryTest, StoredCodeInUse) {
+    ForthDictionary& dict = ForthDictionary::instance();
+    auto& jit = JitContext::instance();
+    const auto code = reinterpret_cast<const void*>(&sharedCodeWord);
+
+    dict.setSearchOrder({"FORTH"});
+    dict.setVocabulary("FORTH");
+
+    ForthDictionaryEntry* holder = dict.addWord("STOREDHOLDER", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
+    dict.addCodeWord("STOREDCODE", "FORTH", ForthState::EXECUTABLE, ForthWordType::WORD,
+                     nullptr, &sharedCodeWord, nullptr);
+    holder->executable = &sharedCodeWord;
+    EXPECT_EQ(jit.codeUsers(code), 1u);
+    EXPECT_TRUE(dict.executableInUse(code, dict.findWord("STOREDCODE")));
+
+    dict.forgetLastWord();
+    EXPECT_EQ(jit.codeUsers(code), 0u);
+    EXPECT_TRUE(dict.executableInUse(code));
+
+    holder->executable = nullptr;
+    EXPECT_FALSE(dict.executableInUse(code));
+    dict.forgetLastWord();
+}
+
+// Test that vocabularies, like words, are found whatever the case of their name
+TEST(ForthDictionaryTest, VocabCaseFolded) {
+    ForthDictionary& dict = ForthDictionary::instance();
+    ForthDictionaryEntry* vocab = dict.createVocabulary("FOLDV");
+    ASSERT_NE(vocab, nullptr);
+    EXPECT_EQ(dict.findVocab("foldv"), vocab);
+    EXPECT_EQ(dict.findVocab("FoldV"), vocab);
+
+    ForthDictionaryEntry* word = dict.addWord("folded", ForthState::EXECUTABLE, ForthWordType::WORD, "foldv");
+    ASSERT_NE(word, nullptr);
+    EXPECT_EQ(word->getWordName(), "FOLDED");
+    EXPECT_EQ(word->vocab_id, vocab->word_id);
+}
+
+// Test that the search order, not definition order, decides between vocabularies
+TEST(ForthDictionaryTest, SearchOrderPriority) {
+    ForthDictionary& dict = ForthDictionary::instance();
+
+    dict.createVocabulary("FIRSTV");
+    dict.createVocabulary("SECONDV");
+
+    ForthDictionaryEntry* first = dict.addWord("PICKME", ForthState::EXECUTABLE, ForthWordType::WORD, "FIRSTV");
+    ForthDictionaryEntry* second = dict.addWord("PICKME", ForthState::EXECUTABLE, ForthWordType::WORD, "SECONDV");
+
+    dict.setSearchOrder({"FIRSTV", "SECONDV"});
+    EXPECT_EQ(dict.findWord("PICKME"), first);
+
+    dict.setSearchOrder({"SECONDV", "FIRSTV"});
+    EXPECT_EQ(dict.findWord("PICKME"), second);
+
+    dict.addSearchOrder("FORTH");
+    EXPECT_EQ(dict.findWord("PICKME"), second);
+
+    dict.resetSearchOrder();
+    EXPECT_EQ(dict.findWord("PICKME"), nullptr);
+}
+
+// Test the allocation free lookups and that a miss leaves the symbol table alone
+TEST(ForthDictionaryTest, LookupWithoutSymbolSideEffects) {
+    ForthDictionary& dict = ForthDictionary::instance();
+
+    dict.setSearchOrder({"FORTH"});
+    ForthDictionaryEntry* word = dict.addWord("VIEWED", ForthState::EXECUTABLE, ForthWordType::WORD, "FORTH");
+
+    EXPECT_EQ(dict.findWord(std::string_view("VIEWED")), word);
+    EXPECT_EQ(dict.findWord("viewed"), word);
+    EXPECT_EQ(dict.findWordById(word->word_id), word);
+
+    EXPECT_EQ(dict.findWord("NEVERDEFINED"), nullptr);
+    EXPECT_EQ(dict.isVariable("NEVERDEFINED"), false);
+    EXPECT_EQ(SymbolTable::instance().findSymbol("NEVERDEFINED"), 0u);
+}
+
+// Test that the symbol table holds forgotten IDs back, then hands them out again once released
+TEST(ForthDictionaryTest, SymbolIdReuse) {
+    SymbolTable& symbols = SymbolTable::instance();
+
+    const uint32_t id = symbols.addSymbol("TRANSIENT");
+    EXPECT_EQ(symbols.addSymbol("TRANSIENT"), id);
+    EXPECT_EQ(symbols.getSymbol(id), "TRANSIENT");
+
+    EXPECT_TRUE(symbols.forgetSymbol("TRANSIENT"));
+    EXPECT_EQ(symbols.findSymbol("TRANSIENT"), 0u);
+    EXPECT_EQ(symbols.getSymbol(id), "");
+    EXPECT_TRUE(symbols.hasForgotten());
+
+    // held: a new name does not get the ID, the forgotten name gets it back
+    const uint32_t other = symbols.addSymbol("BYSTANDER");
+    EXPECT_NE(other, id);
+    EXPECT_EQ(symbols.addSymbol("TRANSIENT"), id);
+    EXPECT_EQ(symbols.getSymbol(id), "TRANSIENT");
+
+    EXPECT_TRUE(symbols.forgetSymbol("TRANSIENT"));
+    symbols.releaseForgotten([](uint32_t) { return false; });
+    EXPECT_FALSE(symbols.hasForgotten());
+    EXPECT_EQ(symbols.addSymbol("REPLACEMENT"), id);
+    EXPECT_EQ(symbols.getSymbol(id), "REPLACEMENT");
+}
+
 #include <random>
 #include <string>
 #include <unordered_set>
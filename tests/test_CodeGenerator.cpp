@@ -2,6 +2,18 @@
 #include "CodeGenerator.h"
 #include "JitContext.h"
 #include "ForthDictionary.h"
+#include "Interpreter.h"
+#include "Settings.h"
+#include "MathKernels.h"
+#include "LetMapGenerator.h"
+#include "Profiler.h"
+#include "PerfMap.h"
+#include "Benchmark.h"
+#include "SignalHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <csetjmp>
+#include <fstream>
 
 // Forward declarations for cpush and cpop stack helpers
 extern void cpush(int64_t value);
@@ -366,9 +378,653 @@ TEST(FloatingPointOperations, TestSquareRoot) {
 
 
 
+// Small definitions are inlined into their callers and give the same results
+TEST(CompilerOperations, TestInlineSmallWords) {
+    code_generator_initialize();
+    inlining = true;
+
+    Interpreter::instance().execute(": SQUARE DUP * ;");
+    Interpreter::instance().execute(": CUBE DUP SQUARE * ;");
+    const auto square = ForthDictionary::instance().findWord("SQUARE");
+    ASSERT_NE(square, nullptr);
+    ASSERT_NE(square->inlineBody, nullptr);
+    EXPECT_EQ(square->inlineBody->tokens.size(), 2);
+
+    cpush(3);
+    ForthDictionary::instance().execWord("CUBE");
+    EXPECT_EQ(cpop(), 27);
+
+    // a body with control flow is called, not inlined
+    Interpreter::instance().execute(": ABSOLUTE DUP 0 < IF 0 SWAP - THEN ;");
+    EXPECT_EQ(ForthDictionary::instance().findWord("ABSOLUTE")->inlineBody, nullptr);
+
+    inlining = false;
+    Interpreter::instance().execute(": CUBE2 DUP SQUARE * ;");
+    inlining = true;
+    cpush(4);
+    ForthDictionary::instance().execWord("CUBE2");
+    EXPECT_EQ(cpop(), 64);
+}
+
+
+TEST(CompilerOperations, TestTailCalls) {
+    code_generator_initialize();
+    const bool optimizing = optimizer;
+    optimizer = true; // tail calls are marked by the optimizer
+
+    // a million deep recursion needs no machine stack when RECURSE is a jump
+    Interpreter::instance().execute(": COUNTDOWN DUP 0 > IF 1 - RECURSE THEN ;");
+    cpush(1000000);
+    ForthDictionary::instance().execWord("COUNTDOWN");
+    EXPECT_EQ(cpop(), 0);
+
+    // the last call of a word becomes a jump, EXIT too
+    inlining = false;
+    Interpreter::instance().execute(": DOUBLE DUP + ;");
+    Interpreter::instance().execute(": QUAD DOUBLE DOUBLE ;");
+    Interpreter::instance().execute(": QUAD-OR-NOT DUP 0 < IF EXIT THEN QUAD ;");
+    inlining = true;
+    cpush(5);
+    ForthDictionary::instance().execWord("QUAD-OR-NOT");
+    EXPECT_EQ(cpop(), 20);
+    cpush(-5);
+    ForthDictionary::instance().execWord("QUAD-OR-NOT");
+    EXPECT_EQ(cpop(), -5);
+    optimizer = optimizing;
+}
+TEST(CompilerOperations, TestVirtualStackRuns) {
+    code_generator_initialize();
+    const bool optimizing = optimizer;
+    optimizer = true;
+    inlining = false;
+
+    Interpreter::instance().execute(": VS-SUMS OVER OVER + SWAP ;");
+    cpush(3);
+    cpush(4);
+    ForthDictionary::instance().execWord("VS-SUMS");
+    EXPECT_EQ(cpop(), 4);
+    EXPECT_EQ(cpop(), 7);
+    EXPECT_EQ(cpop(), 3);
+
+    // reaches below R12 and changes the depth
+    Interpreter::instance().execute(": VS-DEEP ROT 2DUP - NIP TUCK 10 OR ROT DROP ;");
+    cpush(1);
+    cpush(2);
+    cpush(3);
+    cpush(100);
+    ForthDictionary::instance().execWord("VS-DEEP");
+    EXPECT_EQ(cpop(), 106); // (100 - 2) OR 10
+    EXPECT_EQ(cpop(), 100);
+    EXPECT_EQ(cpop(), 3);
+    EXPECT_EQ(cpop(), 1);
+
+    inlining = true;
+    optimizer = optimizing;
+}
+TEST(CompilerOperations, TestRegisterDoLoops) {
+    code_generator_initialize();
+    inlining = false;
+
+    // innermost loop, index and limit in registers
+    Interpreter::instance().execute(": RL-SUM 0 SWAP 0 DO I + LOOP ;");
+    cpush(100);
+    ForthDictionary::instance().execWord("RL-SUM");
+    EXPECT_EQ(cpop(), 4950);
+
+    Interpreter::instance().execute(": RL-STEP 0 SWAP 0 DO I + 3 +LOOP ;");
+    cpush(10);
+    ForthDictionary::instance().execWord("RL-STEP");
+    EXPECT_EQ(cpop(), 0 + 3 + 6 + 9);
+
+    // a call in the body spills and reloads the index
+    Interpreter::instance().execute(": RL-TWICE 2 * ;");
+    Interpreter::instance().execute(": RL-CALLS 0 SWAP 0 DO I RL-TWICE + LOOP ;");
+    cpush(10);
+    ForthDictionary::instance().execWord("RL-CALLS");
+    EXPECT_EQ(cpop(), 90);
+
+    // LEAVE and EXIT from a register loop, J reads the outer loop from the return stack
+    Interpreter::instance().execute(": RL-LEAVE 0 100 0 DO I 5 = IF LEAVE THEN 1 + LOOP ;");
+    ForthDictionary::instance().execWord("RL-LEAVE");
+    EXPECT_EQ(cpop(), 5);
+    Interpreter::instance().execute(": RL-EXIT 100 0 DO I 7 = IF I EXIT THEN LOOP -1 ;");
+    ForthDictionary::instance().execWord("RL-EXIT");
+    EXPECT_EQ(cpop(), 7);
+    Interpreter::instance().execute(": RL-NESTED 0 3 0 DO 4 0 DO J 10 * I + + LOOP LOOP ;");
+    ForthDictionary::instance().execWord("RL-NESTED");
+    EXPECT_EQ(cpop(), 4 * (0 + 10 + 20) + 3 * (0 + 1 + 2 + 3));
+
+    inlining = true;
+}
+TEST(CompilerOperations, TestCompareAndBranch) {
+    code_generator_initialize();
+
+    Interpreter::instance().execute(": CB-MAX 2DUP < IF SWAP THEN DROP ;");
+    cpush(3);
+    cpush(9);
+    ForthDictionary::instance().execWord("CB-MAX");
+    EXPECT_EQ(cpop(), 9);
+    cpush(-3);
+    cpush(-9);
+    ForthDictionary::instance().execWord("CB-MAX");
+    EXPECT_EQ(cpop(), -3);
+
+    // literal comparisons are signed, fused or not
+    Interpreter::instance().execute(": CB-NEG 0 < IF 1 ELSE 2 THEN ;");
+    cpush(-3);
+    ForthDictionary::instance().execWord("CB-NEG");
+    EXPECT_EQ(cpop(), 1);
+    cpush(3);
+    ForthDictionary::instance().execWord("CB-NEG");
+    EXPECT_EQ(cpop(), 2);
+
+    Interpreter::instance().execute(": CB-SIGN DUP 0< IF DROP -1 ELSE 0> IF 1 ELSE 0 THEN THEN ;");
+    for (const int64_t n: {-7, 0, 7}) {
+        cpush(n);
+        ForthDictionary::instance().execWord("CB-SIGN");
+        EXPECT_EQ(cpop(), (n > 0) - (n < 0));
+    }
+
+    Interpreter::instance().execute(": CB-UNTIL 0 BEGIN 1 + DUP 10 = UNTIL ;");
+    ForthDictionary::instance().execWord("CB-UNTIL");
+    EXPECT_EQ(cpop(), 10);
+
+    Interpreter::instance().execute(": CB-WHILE 0 BEGIN DUP 5 < WHILE 1 + REPEAT ;");
+    ForthDictionary::instance().execWord("CB-WHILE");
+    EXPECT_EQ(cpop(), 5);
+
+    // the flag words still work on their own
+    Interpreter::instance().execute(": CB-FLAGS 0 0= 5 0< -5 0< ;");
+    ForthDictionary::instance().execWord("CB-FLAGS");
+    EXPECT_EQ(cpop(), -1);
+    EXPECT_EQ(cpop(), 0);
+    EXPECT_EQ(cpop(), -1);
+}
+
+TEST(CompilerOperations, TestConstantFolding) {
+    code_generator_initialize();
+
+    Interpreter::instance().execute("640 CONSTANT CF-WIDTH");
+    Interpreter::instance().execute("480 CONSTANT CF-HEIGHT");
+    Interpreter::instance().execute(": CF-AREA CF-WIDTH CF-HEIGHT * ;");
+    ForthDictionary::instance().execWord("CF-AREA");
+    EXPECT_EQ(cpop(), 307200);
+
+    Interpreter::instance().execute(": CF-SCALE 3 4 + * 1 2 < AND ;");
+    cpush(5);
+    ForthDictionary::instance().execWord("CF-SCALE");
+    EXPECT_EQ(cpop(), 35);
+
+    // folded and run time arithmetic agree
+    Interpreter::instance().execute(": CF-FOLDED 9223372036854775807 1 + -7 2 / -7 2 MOD ;");
+    Interpreter::instance().execute(": CF-RUNTIME >R >R >R >R + R> R> / R> R> MOD ;");
+    ForthDictionary::instance().execWord("CF-FOLDED");
+    const int64_t mod = cpop();
+    const int64_t div = cpop();
+    const int64_t sum = cpop();
+    for (const int64_t n: {INT64_MAX, int64_t{1}, int64_t{-7}, int64_t{2}, int64_t{-7}, int64_t{2}}) cpush(n);
+    ForthDictionary::instance().execWord("CF-RUNTIME");
+    EXPECT_EQ(cpop(), mod);
+    EXPECT_EQ(cpop(), div);
+    EXPECT_EQ(cpop(), sum);
+    EXPECT_EQ(sum, INT64_MIN);
+}
+
+TEST(CompilerOperations, TestPeepholeRules) {
+    code_generator_initialize();
+
+    // the rewritten words compute what the originals did
+    Interpreter::instance().execute(": PH-NIP 1 2 3 SWAP DROP ;");
+    ForthDictionary::instance().execWord("PH-NIP");
+    EXPECT_EQ(cpop(), 3);
+    EXPECT_EQ(cpop(), 1);
+
+    Interpreter::instance().execute(": PH-TUCK 1 2 SWAP OVER ;");
+    ForthDictionary::instance().execWord("PH-TUCK");
+    EXPECT_EQ(cpop(), 2);
+    EXPECT_EQ(cpop(), 1);
+    EXPECT_EQ(cpop(), 2);
+
+    Interpreter::instance().execute(": PH-OVER 1 2 OVER DROP ;");
+    ForthDictionary::instance().execWord("PH-OVER");
+    EXPECT_EQ(cpop(), 2);
+    EXPECT_EQ(cpop(), 1);
+
+    Interpreter::instance().execute("PEEPHOLE: OVER OVER => 2DUP");
+    Interpreter::instance().execute(": PH-2DUP 3 4 OVER OVER ;");
+    ForthDictionary::instance().execWord("PH-2DUP");
+    EXPECT_EQ(cpop(), 4);
+    EXPECT_EQ(cpop(), 3);
+    EXPECT_EQ(cpop(), 4);
+    EXPECT_EQ(cpop(), 3);
+}
+
+TEST(CompilerOperations, TestCaseDispatch) {
+    code_generator_initialize();
+
+    // dense keys, a jump table; 5 is a hole and goes to the default
+    Interpreter::instance().execute(": CD-DENSE CASE 0 OF 10 ENDOF 1 OF 11 ENDOF 2 OF 12 ENDOF 3 OF 13 ENDOF "
+                                    "4 OF 14 ENDOF 6 OF 16 ENDOF 7 OF 17 ENDOF 1 OF 99 ENDOF DUP 1000 + SWAP ENDCASE ;");
+    for (const int64_t n: {0, 1, 2, 3, 4, 6, 7}) {
+        cpush(n);
+        ForthDictionary::instance().execWord("CD-DENSE");
+        EXPECT_EQ(cpop(), 10 + n);
+    }
+    for (const int64_t n: {-1, 5, 8, 1000000}) {
+        cpush(n);
+        ForthDictionary::instance().execWord("CD-DENSE");
+        EXPECT_EQ(cpop(), 1000 + n);
+    }
+
+    // sparse keys, a compare tree
+    Interpreter::instance().execute("7000 CONSTANT CD-BIG");
+    Interpreter::instance().execute(": CD-SPARSE CASE -50 OF 1 ENDOF 3 OF 2 ENDOF 100 OF 3 ENDOF 1000 OF 4 ENDOF "
+                                    "CD-BIG OF 5 ENDOF 123456789012 OF 6 ENDOF 0 SWAP ENDCASE ;");
+    const int64_t sparse[] = {-50, 3, 100, 1000, 7000, 123456789012};
+    for (int64_t i = 0; i < 6; i++) {
+        cpush(sparse[i]);
+        ForthDictionary::instance().execWord("CD-SPARSE");
+        EXPECT_EQ(cpop(), i + 1);
+    }
+    for (const int64_t n: {-51, 4, 999, 7001}) {
+        cpush(n);
+        ForthDictionary::instance().execWord("CD-SPARSE");
+        EXPECT_EQ(cpop(), 0);
+    }
+
+    // a key computed at run time tests each OF in turn, nested CASEs keep their own keys
+    Interpreter::instance().execute(": CD-MIXED CASE 1 OF 10 ENDOF 1 2 + OF 30 "
+                                    "7 CASE 6 OF 1 ENDOF 7 OF 2 ENDOF 0 SWAP ENDCASE + ENDOF 0 SWAP ENDCASE ;");
+    cpush(1);
+    ForthDictionary::instance().execWord("CD-MIXED");
+    EXPECT_EQ(cpop(), 10);
+    cpush(3);
+    ForthDictionary::instance().execWord("CD-MIXED");
+    EXPECT_EQ(cpop(), 32);
+    cpush(2);
+    ForthDictionary::instance().execWord("CD-MIXED");
+    EXPECT_EQ(cpop(), 0);
+}
+
 
 
 // Main function for Google Test
+TEST(CompilerOperations, TestTieredRecompile) {
+    code_generator_initialize();
+    const bool savedOptimizer = optimizer;
+    const bool savedInlining = inlining;
+    optimizer = false;
+    inlining = false;
+    tiering = true;
+    tierLimit = 20;
+
+    Interpreter::instance().execute(": TR-SQUARE DUP * ;");
+    Interpreter::instance().execute(": TR-SUM 0 SWAP 0 DO I TR-SQUARE + LOOP ;");
+    const auto square = ForthDictionary::instance().findWord("TR-SQUARE");
+    const auto sum = ForthDictionary::instance().findWord("TR-SUM");
+    ASSERT_NE(square->tierProfile, nullptr);
+    ASSERT_NE(sum->tierProfile, nullptr);
+    const ForthFunction baseline = sum->executable;
+
+    // TR-SQUARE is hot during the second TR-SUM, TR-SUM with its loop at its third call
+    for (int i = 0; i < 3; i++) {
+        Interpreter::instance().execute("10 TR-SUM");
+        EXPECT_EQ(cpop(), 285);
+    }
+    EXPECT_TRUE(square->tierProfile->recompiled);
+    EXPECT_TRUE(sum->tierProfile->recompiled);
+    EXPECT_NE(sum->executable, baseline);
+    EXPECT_GE(sum->tierProfile->counters.loops, 20u);
+
+    // a word that uses a redefined word keeps its first code
+    Interpreter::instance().execute(": TR-BASE 2 ;");
+    Interpreter::instance().execute(": TR-USER TR-BASE 3 * ;");
+    Interpreter::instance().execute(": TR-BASE 5 ;");
+    const auto user = ForthDictionary::instance().findWord("TR-USER");
+    const ForthFunction first = user->executable;
+    for (int i = 0; i < 25; i++) {
+        Interpreter::instance().execute("TR-USER");
+        EXPECT_EQ(cpop(), 6);
+    }
+    EXPECT_TRUE(user->tierProfile->recompiled);
+    EXPECT_EQ(user->executable, first);
+
+    // the float stack and math settings are recorded, and pinned only while recompiling
+    const MathAccuracy savedMath = mathAccuracy;
+    mathAccuracy = MathAccuracy::PRECISE;
+    Interpreter::instance().execute(": TR-PRECISE 7 ;");
+    mathAccuracy = savedMath;
+    const auto precise = ForthDictionary::instance().findWord("TR-PRECISE");
+    EXPECT_EQ(precise->tierProfile->mathAccuracy, MathAccuracy::PRECISE);
+    EXPECT_EQ(precise->tierProfile->floatStackSeparate, floatStackSeparate);
+    for (int i = 0; i < 25; i++) {
+        Interpreter::instance().execute("TR-PRECISE");
+        EXPECT_EQ(cpop(), 7);
+    }
+    EXPECT_TRUE(precise->tierProfile->recompiled);
+    EXPECT_EQ(mathAccuracy, savedMath);
+
+    tiering = false;
+    tierLimit = 1000;
+    optimizer = savedOptimizer;
+    inlining = savedInlining;
+}
+
+TEST(FloatingPointOperations, TestSeparateFloatStack) {
+    code_generator_initialize();
+    Interpreter::instance().execute("SET FSTACK SEPARATE");
+
+    // integers and floats on their own stacks
+    cpush(7);
+    cfpush(3.0);
+    cfpush(4.0);
+    Interpreter::instance().execute(": FS-HYPOT fdup f* fswap fdup f* f+ fsqrt ;");
+    Interpreter::instance().execute("FS-HYPOT");
+    EXPECT_DOUBLE_EQ(cfpop(), 5.0);
+    EXPECT_EQ(cpop(), 7);
+
+    // deeper than the two floats kept in registers
+    Interpreter::instance().execute(": FS-DEEP 1.0 2.0 3.0 4.0 f+ f* fover f- f+ ;");
+    Interpreter::instance().execute("FS-DEEP");
+    EXPECT_DOUBLE_EQ(cfpop(), 14.0);
+
+    Interpreter::instance().execute("VARIABLE FS-CELL");
+    Interpreter::instance().execute(": FS-STORE 2.5 FS-CELL f! FS-CELL f@ FS-CELL f@ f* ;");
+    Interpreter::instance().execute("FS-STORE");
+    EXPECT_DOUBLE_EQ(cfpop(), 6.25);
+
+    // conversions and comparisons leave integers on the data stack
+    Interpreter::instance().execute(": FS-CONV 10 s>f 4.0 f/ fdup f>s 2.0 3.0 f< ;");
+    Interpreter::instance().execute("FS-CONV");
+    EXPECT_EQ(cpop(), -1);
+    EXPECT_EQ(cpop(), 2);
+    EXPECT_DOUBLE_EQ(cfpop(), 2.5);
+
+    // the interpreter runs the rebuilt float words
+    Interpreter::instance().execute("1.5 2.25 f+");
+    EXPECT_DOUBLE_EQ(cfpop(), 3.75);
+
+    Interpreter::instance().execute("SET FSTACK SHARED");
+}
+
+TEST(FloatingPointOperations, TestInlineMathKernels) {
+    code_generator_initialize();
+    const auto ulps = [](const double got, const double want) {
+        return std::fabs(got - want) / (std::nextafter(std::fabs(want), INFINITY) - std::fabs(want));
+    };
+
+    // the kernels keep their documented bounds against libm
+    const double args[] = {-1e5, -20.0, -3.7, -1.0, -0.3, -1e-9, 1e-300, 0.001, 0.5, 1.0, 3.14159, 10.0, 700.0};
+    for (const double x: args) {
+        EXPECT_LE(ulps(math_kernel_reference("sin", MathAccuracy::PRECISE, x), sin(x)), 2.5) << x;
+        EXPECT_LE(ulps(math_kernel_reference("cos", MathAccuracy::PRECISE, x), cos(x)), 2.5) << x;
+        EXPECT_LE(ulps(math_kernel_reference("exp", MathAccuracy::PRECISE, x), exp(x)), 1.0) << x;
+        EXPECT_LE(ulps(math_kernel_reference("tanh", MathAccuracy::PRECISE, x), tanh(x)), 3.5) << x;
+        EXPECT_NEAR(math_kernel_reference("sin", MathAccuracy::FAST, x), sin(x), 3e-9) << x;
+        if (x > 1e-100) {
+            EXPECT_LE(ulps(math_kernel_reference("log", MathAccuracy::PRECISE, x), log(x)), 1.0) << x;
+            EXPECT_LE(ulps(math_kernel_reference("pow", MathAccuracy::PRECISE, x, -2.5), pow(x, -2.5)),
+                      2.0 * (1.0 + std::fabs(2.5 * log(x)))) << x;
+        }
+    }
+    EXPECT_EQ(math_kernel_reference("pow", MathAccuracy::PRECISE, -2.0, 3.0), -8.0);
+    EXPECT_EQ(math_kernel_reference("pow", MathAccuracy::PRECISE, 0.0, 0.0), 1.0);
+    EXPECT_TRUE(std::isnan(math_kernel_reference("pow", MathAccuracy::PRECISE, -2.0, 0.5)));
+    EXPECT_EQ(math_kernel_reference("log", MathAccuracy::PRECISE, 0.0), -INFINITY);
+    EXPECT_EQ(math_kernel_reference("exp", MathAccuracy::PRECISE, 1000.0), INFINITY);
+
+    // the JIT computes exactly what the reference does, on either float stack
+    Interpreter::instance().execute("SET MATH PRECISE");
+    Interpreter::instance().execute(": MK-SIN sin ; : MK-COS cos ; : MK-EXP fexp ; : MK-LN fln ; : MK-TANH ftanh ;");
+    Interpreter::instance().execute(": MK-POW f** ;");
+    const std::pair<const char *, const char *> words[] = {
+        {"MK-SIN", "sin"}, {"MK-COS", "cos"}, {"MK-EXP", "exp"}, {"MK-LN", "log"}, {"MK-TANH", "tanh"}
+    };
+    for (const double x: {0.001, 0.5, 2.0, 10.0, 100.0}) {
+        for (const auto &[word, name]: words) {
+            cfpush(x);
+            Interpreter::instance().execute(word);
+            EXPECT_EQ(cfpop(), math_kernel_reference(name, MathAccuracy::PRECISE, x)) << word << " " << x;
+        }
+        cfpush(-x);
+        cfpush(3.0);
+        Interpreter::instance().execute("MK-POW");
+        EXPECT_EQ(cfpop(), math_kernel_reference("pow", MathAccuracy::PRECISE, -x, 3.0)) << x;
+    }
+
+    Interpreter::instance().execute("SET MATH FAST");
+    Interpreter::instance().execute("SET FSTACK SEPARATE");
+    Interpreter::instance().execute(": MK-FAST 0.5 sin 0.5 fexp f* 2.0 fln f+ ;");
+    Interpreter::instance().execute("MK-FAST");
+    const double fast = math_kernel_reference("sin", MathAccuracy::FAST, 0.5) *
+                        math_kernel_reference("exp", MathAccuracy::FAST, 0.5) +
+                        math_kernel_reference("log", MathAccuracy::FAST, 2.0);
+    EXPECT_EQ(cfpop(), fast);
+    EXPECT_NEAR(fast, sin(0.5) * exp(0.5) + log(2.0), 1e-7);
+
+    // the interpreter runs the rebuilt words
+    Interpreter::instance().execute("2.0 10.0 f**");
+    EXPECT_EQ(cfpop(), math_kernel_reference("pow", MathAccuracy::FAST, 2.0, 10.0));
+
+    Interpreter::instance().execute("SET FSTACK SHARED");
+    Interpreter::instance().execute("SET MATH LIBM");
+}
+
+TEST(FloatingPointOperations, TestLetMap) {
+    code_generator_initialize();
+    auto &generator = LetMapGenerator::instance();
+    const char *body = " LET-MAP (r, s) = FN(x, y) = a * x ^ 2 + fmax(y, 0.0), sqrt(fabs(x - y)) / -a * x ^ -3"
+                       " WHERE a = 1.5 ;";
+    const std::pair<const char *, LetMapGenerator::Isa> widths[] = {
+        {"LM-SSE2", LetMapGenerator::Isa::SSE2},
+        {"LM-AVX2", LetMapGenerator::Isa::AVX2},
+        {"LM-AVX512", LetMapGenerator::Isa::AVX512}
+    };
+
+    // every width agrees with the scalar formula, for counts that leave any tail
+    for (const auto &[word, isa]: widths) {
+        generator.limit_isa(isa);
+        Interpreter::instance().execute(std::string(": ") + word + body);
+        for (const int n: {0, 1, 3, 4, 7, 8, 9, 17, 100}) {
+            std::vector<double> x(n + 1), y(n + 1), r(n + 1, -1.0), s(n + 1, -1.0);
+            for (int i = 0; i < n; i++) {
+                x[i] = 0.25 * i + 0.5;
+                y[i] = std::sin(i) * 4.0;
+            }
+            cpush(12345);
+            cpush(reinterpret_cast<int64_t>(x.data()));
+            cpush(reinterpret_cast<int64_t>(y.data()));
+            cpush(reinterpret_cast<int64_t>(r.data()));
+            cpush(reinterpret_cast<int64_t>(s.data()));
+            cpush(n);
+            Interpreter::instance().execute(word);
+            EXPECT_EQ(cpop(), 12345) << word;
+            for (int i = 0; i < n; i++) {
+                const double cube = x[i] * x[i] * x[i];
+                EXPECT_EQ(r[i], 1.5 * (x[i] * x[i]) + std::fmax(y[i], 0.0)) << word << " " << n << " " << i;
+                EXPECT_EQ(s[i], std::sqrt(std::fabs(x[i] - y[i])) / -1.5 * (1.0 / cube)) << word << " " << n << " " << i;
+            }
+            EXPECT_EQ(r[n], -1.0) << word << " " << n;
+            EXPECT_EQ(s[n], -1.0) << word << " " << n;
+        }
+    }
+
+    // an output may be one of the inputs
+    Interpreter::instance().execute(": LM-SCALE LET-MAP (r) = FN(x) = x * 2 ;");
+    std::vector<double> v = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0};
+    cpush(reinterpret_cast<int64_t>(v.data()));
+    cpush(reinterpret_cast<int64_t>(v.data()));
+    cpush(static_cast<int64_t>(v.size()));
+    Interpreter::instance().execute("LM-SCALE");
+    for (size_t i = 0; i < v.size(); i++) {
+        EXPECT_EQ(v[i], 2.0 * (i + 1));
+    }
+}
+
+TEST(CompilerOperations, TestProfiler) {
+    code_generator_initialize();
+    Interpreter::instance().execute(": PROF-SPIN 0 100000000 0 DO 1+ LOOP ;");
+    Interpreter::instance().execute(": PROF-OUTER PROF-SPIN 1+ ;");
+
+    auto &profiler = Profiler::instance();
+    profiler.start();
+    ASSERT_TRUE(profiler.running());
+    Interpreter::instance().execute("PROF-OUTER");
+    profiler.stop();
+    EXPECT_FALSE(profiler.running());
+    EXPECT_EQ(cpop(), 100000001);
+    ASSERT_GT(profiler.sampleCount(), 0u);
+
+    // the loop is where the time goes, the caller is found on the machine stack
+    const auto flat = profiler.flat();
+    const auto row = [&flat](const std::string &name) {
+        const auto it = std::find_if(flat.begin(), flat.end(), [&name](const auto &w) { return w.name == name; });
+        return it == flat.end() ? Profiler::WordProfile{} : *it;
+    };
+    EXPECT_GT(row("PROF-SPIN").self, profiler.sampleCount() / 2);
+    EXPECT_GE(row("PROF-OUTER").total, row("PROF-SPIN").self);
+    const auto calls = profiler.callGraph();
+    EXPECT_TRUE(std::any_of(calls.begin(), calls.end(), [](const auto &call) {
+        return call.caller == "PROF-OUTER" && call.callee == "PROF-SPIN" && call.samples > 0;
+    }));
+}
+
+TEST(CompilerOperations, TestBench) {
+    code_generator_initialize();
+    Interpreter::instance().execute(": BENCH-SQUARE DUP * ;");
+    Interpreter::instance().execute(": BENCH-PUSH 1 ;");
+    Interpreter::instance().execute("DEPTH");
+    const int64_t depth = cpop();
+
+    cpush(3);
+    Interpreter::instance().execute("BENCH BENCH-SQUARE 20");
+    cpop();
+    const auto &result = Benchmark::instance().last();
+    EXPECT_EQ(result.samples, 20u);
+    EXPECT_GT(result.iterations, 0u);
+    EXPECT_LE(result.min, result.median);
+    EXPECT_LE(result.median, result.p99);
+    EXPECT_GT(result.mean, 0);
+
+    // an unbalanced word is called once and not timed
+    Interpreter::instance().execute("BENCH BENCH-PUSH 20");
+    EXPECT_EQ(cpop(), 1);
+    Interpreter::instance().execute("DEPTH");
+    EXPECT_EQ(cpop(), depth);
+}
+
+TEST(CompilerOperations, TestBenchCounters) {
+    code_generator_initialize();
+    Interpreter::instance().execute(": BENCH-SUM 0 1000 0 DO I + LOOP DROP ;");
+    Interpreter::instance().execute("SET COUNTERS ON");
+    Interpreter::instance().execute("BENCH BENCH-SUM 5");
+    const auto &result = Benchmark::instance().last();
+    EXPECT_EQ(result.samples, 5u);
+
+    if (!hardwareCounters) {
+        // without counters, in a container or virtual machine, BENCH still times the word
+        EXPECT_FALSE(PerfCounters::instance().error().empty());
+        EXPECT_FALSE(result.counts.valid);
+        return;
+    }
+    ASSERT_TRUE(result.counts.valid);
+    ASSERT_TRUE(result.counts.counted[PerfCounters::INSTRUCTIONS]);
+    const double iterations = static_cast<double>(result.iterations * result.samples);
+    EXPECT_GT(result.counts.values[PerfCounters::INSTRUCTIONS] / iterations, 1000.0);
+    Interpreter::instance().execute("SET COUNTERS OFF");
+    EXPECT_FALSE(hardwareCounters);
+}
+
+// A word forgotten and a new one defined on the same line; the forgotten word's token
+// must not run the new word, which would otherwise get the forgotten symbol id
+TEST(CompilerOperations, TestForgetThenDefine) {
+    code_generator_initialize();
+    auto &interpreter = Interpreter::instance();
+    auto &dict = ForthDictionary::instance();
+    interpreter.execute(": FORGOTTEN-WORD 11 ;");
+    const ForthDictionaryEntry *forgotten = dict.findWord("FORGOTTEN-WORD");
+    ASSERT_NE(forgotten, nullptr);
+    const uint32_t id = forgotten->word_id;
+
+    bool notFound = false;
+    if (setjmp(SignalHandler::instance().get_jump_buffer()) == 0) {
+        interpreter.execute("FORGET VARIABLE REPLACING-WORD FORGOTTEN-WORD");
+    } else {
+        notFound = true;
+        interpreter.recover();
+    }
+    EXPECT_TRUE(notFound);
+
+    const ForthDictionaryEntry *replacing = dict.findWord("REPLACING-WORD");
+    ASSERT_NE(replacing, nullptr);
+    EXPECT_NE(replacing->word_id, id);
+    EXPECT_EQ(dict.findWord("FORGOTTEN-WORD"), nullptr);
+    EXPECT_EQ(dict.findWordById(id), nullptr);
+}
+
+// BASE changed on the line that then uses it
+TEST(CompilerOperations, TestBaseOnOneLine) {
+    code_generator_initialize();
+    Interpreter::instance().execute("HEX FF DECIMAL");
+    EXPECT_EQ(cpop(), 255);
+    Interpreter::instance().execute("16 BASE ! 10 DECIMAL 10");
+    EXPECT_EQ(cpop(), 10);
+    EXPECT_EQ(cpop(), 16);
+    Interpreter::instance().execute("2 BASE ! 101 DECIMAL : BASE-TEST 7 ; BASE-TEST");
+    EXPECT_EQ(cpop(), 7);
+    EXPECT_EQ(cpop(), 5);
+}
+
+// Under HEX new names such as FACE and ADD read as numbers, defining words still take them
+TEST(CompilerOperations, TestHexNames) {
+    code_generator_initialize();
+    Interpreter::instance().execute("HEX : FACE 1 ; VARIABLE BEEF 2 CONSTANT ADD DECIMAL");
+    auto &dict = ForthDictionary::instance();
+    EXPECT_NE(dict.findWord("FACE"), nullptr);
+    EXPECT_NE(dict.findWord("BEEF"), nullptr);
+    EXPECT_NE(dict.findWord("ADD"), nullptr);
+    Interpreter::instance().execute("FACE ADD");
+    EXPECT_EQ(cpop(), 2);
+    EXPECT_EQ(cpop(), 1);
+}
+
+// A file included part way through a line keeps the rest of the line in the BASE it leaves
+TEST(CompilerOperations, TestBaseAfterInclude) {
+    code_generator_initialize();
+    const std::string file = ::testing::TempDir() + "base_hex.f";
+    std::ofstream(file) << "HEX\n";
+    Interpreter::instance().execute("INCLUDE " + file + " 10 DECIMAL");
+    EXPECT_EQ(cpop(), 16);
+}
+
+TEST(CompilerOperations, TestScale) {
+    code_generator_initialize();
+    // */ is committed with the startup batch, so it runs interpreted and compiles into words
+    ASSERT_NE(ForthDictionary::instance().findWord("*/")->executable, nullptr);
+    Interpreter::instance().execute("1 6 4 3 */");
+    EXPECT_EQ(cpop(), 8);
+    EXPECT_EQ(cpop(), 1);
+    Interpreter::instance().execute(": SCALE-TEST 1000000000000 3 1000 */ ;");
+    Interpreter::instance().execute("SCALE-TEST");
+    EXPECT_EQ(cpop(), 3000000000);
+    Interpreter::instance().execute("-7 2 3 */");
+    EXPECT_EQ(cpop(), -4);
+}
+
+// SET FSTACK rebuilds the float words, their code is named after them, not the latest word
+TEST(FloatingPointOperations, TestRebuiltFloatWordsNamed) {
+    code_generator_initialize();
+    Interpreter::instance().execute(": PERF-LATEST ;");
+    Interpreter::instance().execute("SET FSTACK SEPARATE");
+    const auto start = reinterpret_cast<uintptr_t>(ForthDictionary::instance().findWord("f+")->executable);
+    const auto &symbols = PerfMap::instance().code();
+    const auto symbol = std::find_if(symbols.begin(), symbols.end(),
+                                     [start](const PerfMap::Symbol &s) { return s.start == start; });
+    ASSERT_NE(symbol, symbols.end());
+    EXPECT_EQ(symbol->name, "f+");
+    Interpreter::instance().execute("SET FSTACK SHARED");
+}
+
 int main(int argc, char **argv) {
 
     ::testing::InitGoogleTest(&argc, argv);
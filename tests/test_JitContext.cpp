@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "JitContext.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 // Test if JitContext initializes correctly
 TEST(JitContextTest, Initialization) {
@@ -14,7 +17,89 @@ TEST(JitContextTest, CodeHolderInitialization) {
     EXPECT_TRUE(codeHolder.isInitialized());
 }
 
+// Test that words assembled into one batch each get their own entry point
+TEST(JitContextTest, BatchedFunctions) {
+    auto &jc = JitContext::instance();
+    jc.initialize();
+    jc.beginBatch();
+    EXPECT_TRUE(jc.batching());
 
+    asmjit::Label entries[3];
+    for (int i = 0; i < 3; i++) {
+        jc.beginBatchWord();
+        auto &assembler = jc.getAssembler();
+        entries[i] = assembler.newLabel();
+        assembler.bind(entries[i]);
+        assembler.mov(asmjit::x86::rax, asmjit::imm(40 + i));
+        assembler.ret();
+        jc.endBatchWord();
+    }
+
+    ASSERT_NE(jc.commitBatch(), nullptr);
+    EXPECT_FALSE(jc.batching());
+    for (int i = 0; i < 3; i++) {
+        const auto fn = reinterpret_cast<long (*)()>(jc.batchFunction(entries[i]));
+        ASSERT_NE(fn, nullptr);
+        EXPECT_EQ(fn(), 40 + i);
+    }
+}
+
+// Test that code is only released once nothing calls it
+TEST(JitContextTest, ReleaseCode) {
+    auto &jc = JitContext::instance();
+
+    jc.initialize();
+    jc.getAssembler().ret();
+    const auto callee = jc.finalize();
+    ASSERT_NE(callee, nullptr);
+
+    jc.initialize();
+    jc.noteReference(reinterpret_cast<const void *>(callee));
+    jc.getAssembler().call(callee);
+    jc.getAssembler().ret();
+    const auto caller = jc.finalize();
+    ASSERT_NE(caller, nullptr);
+
+    EXPECT_TRUE(jc.ownsCode(reinterpret_cast<const void *>(callee)));
+    EXPECT_FALSE(jc.releaseCode(reinterpret_cast<const void *>(callee)));
+    EXPECT_TRUE(jc.releaseCode(reinterpret_cast<const void *>(caller)));
+    EXPECT_TRUE(jc.releaseCode(reinterpret_cast<const void *>(callee)));
+    EXPECT_FALSE(jc.ownsCode(reinterpret_cast<const void *>(callee)));
+}
+
+// Test that finalized code is named in the perf map, including code finalized before it was switched on
+TEST(JitContextTest, PerfMap) {
+    auto &jc = JitContext::instance();
+    auto &perfMap = PerfMap::instance();
+
+    jc.initialize();
+    jc.getAssembler().ret();
+    const auto before = jc.finalize("PERF-BEFORE");
+    ASSERT_NE(before, nullptr);
+
+    perfMap.setMode(PerfMap::Mode::MAP);
+    ASSERT_EQ(perfMap.mode(), PerfMap::Mode::MAP);
+    jc.initialize();
+    jc.getAssembler().mov(asmjit::x86::rax, asmjit::imm(7));
+    jc.getAssembler().ret();
+    const auto after = jc.finalize("PERF-AFTER");
+    ASSERT_NE(after, nullptr);
+
+    std::ifstream map(perfMap.mapPath());
+    std::stringstream contents;
+    contents << map.rdbuf();
+    std::ostringstream expected;
+    expected << std::hex << reinterpret_cast<uintptr_t>(before) << " 1 PERF-BEFORE\n";
+    EXPECT_NE(contents.str().find(expected.str()), std::string::npos) << contents.str();
+    expected.str("");
+    expected << std::hex << reinterpret_cast<uintptr_t>(after) << " " << jc.getCode().codeSize() << " PERF-AFTER\n";
+    EXPECT_NE(contents.str().find(expected.str()), std::string::npos) << contents.str();
+
+    perfMap.setMode(PerfMap::Mode::OFF);
+    EXPECT_TRUE(jc.releaseCode(reinterpret_cast<const void *>(before)));
+    EXPECT_TRUE(jc.releaseCode(reinterpret_cast<const void *>(after)));
+    std::remove(perfMap.mapPath().c_str());
+}
 
 // Main function for Google Test
 int main(int argc, char **argv) {
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "StringsStorage.h"
+
+// Each test starts from an empty arena
+class StringStorageTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        StringStorage::instance().clear();
+    }
+
+    void TearDown() override {
+        StringStorage::instance().clear();
+    }
+};
+
+static bool aligned(const char *text) {
+    return reinterpret_cast<uintptr_t>(text) % StringStorage::ALIGNMENT == 0;
+}
+
+TEST_F(StringStorageTest, SameTextSamePointer) {
+    auto &storage = StringStorage::instance();
+    const char *first = storage.intern("Hello, World");
+    const std::string copy = "Hello, World";
+    EXPECT_EQ(storage.intern(copy), first);
+    EXPECT_NE(storage.intern("Hello, World!"), first);
+    EXPECT_NE(storage.intern("Hello"), first);
+}
+
+TEST_F(StringStorageTest, AlignedAndTerminated) {
+    auto &storage = StringStorage::instance();
+    // lengths either side of the alignment, and empty
+    for (const size_t length: {0, 1, 14, 15, 16, 17, 31, 32, 100}) {
+        const std::string text(length, static_cast<char>('a' + length % 26));
+        const char *interned = storage.intern(text);
+        EXPECT_TRUE(aligned(interned)) << "length " << length;
+        EXPECT_EQ(interned[length], '\0') << "length " << length;
+        EXPECT_EQ(std::string(interned), text);
+    }
+    // a view into a longer string is terminated at the view's end
+    const std::string sentence = "interned prefix and the rest";
+    const char *prefix = storage.intern(std::string_view(sentence).substr(0, 15));
+    EXPECT_STREQ(prefix, "interned prefix");
+}
+
+TEST_F(StringStorageTest, OversizedStringOwnChunk) {
+    auto &storage = StringStorage::instance();
+    const char *before = storage.intern("before");
+    EXPECT_EQ(storage.statistics().chunks, 1u);
+
+    const std::string large(StringStorage::CHUNK_SIZE + 100, 'x');
+    const char *oversized = storage.intern(large);
+    EXPECT_TRUE(aligned(oversized));
+    EXPECT_EQ(oversized[large.size()], '\0');
+    EXPECT_EQ(storage.statistics().chunks, 2u);
+
+    // the next small string goes on in the chunk that was being filled
+    const char *after = storage.intern("after");
+    EXPECT_EQ(after, before + StringStorage::ALIGNMENT);
+    EXPECT_EQ(storage.statistics().chunks, 2u);
+    EXPECT_STREQ(before, "before");
+    EXPECT_EQ(storage.intern(large), oversized);
+}
+
+TEST_F(StringStorageTest, HitAndMissCounts) {
+    auto &storage = StringStorage::instance();
+    storage.intern("one");
+    storage.intern("two");
+    storage.intern("one");
+    storage.intern("one");
+    storage.intern("three");
+
+    const StringStorage::Statistics statistics = storage.statistics();
+    EXPECT_EQ(statistics.internCalls, 5u);
+    EXPECT_EQ(statistics.internHits, 2u);
+    EXPECT_EQ(statistics.strings, 3u);
+    EXPECT_EQ(statistics.stringBytes, 4u + 4u + 6u);
+    EXPECT_EQ(statistics.used, 3 * StringStorage::ALIGNMENT);
+
+    storage.clear();
+    EXPECT_EQ(storage.statistics().internCalls, 0u);
+    EXPECT_EQ(storage.statistics().internHits, 0u);
+}
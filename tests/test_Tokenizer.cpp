@@ -8,6 +8,8 @@
 #include <cmath>
 #include "CodeGenerator.h"
 #include "Optimizer.h"
+#include "Peephole.h"
+#include "ForthDictionary.h"
 
 // Helper to create a tokenizer and tokenize input
 std::deque<ForthToken> tokenizeInput(const std::string &input) {
@@ -125,6 +127,81 @@ TEST(TokenizerTests, HandleWhitespaces) {
     EXPECT_EQ(tokens[2].type, TOKEN_END);
 }
 
+// Test 9: Number prefixes
+TEST(TokenizerTests, TokenizeNumberPrefixes) {
+    code_generator_initialize();
+    std::string input = "$1A #10 %101 -$10 $-10 0xFFFFFFFFFFFFFFFF";
+    auto tokens = tokenizeInput(input);
+    ASSERT_EQ(tokens.size(), 7); // 6 numbers + 1 TOKEN_END
+    EXPECT_EQ(tokens[0].type, TOKEN_NUMBER);
+    EXPECT_EQ(tokens[0].int_value, 26);
+    EXPECT_EQ(tokens[1].int_value, 10);
+    EXPECT_EQ(tokens[2].int_value, 5);
+    EXPECT_EQ(static_cast<int64_t>(tokens[3].int_value), -16);
+    EXPECT_EQ(static_cast<int64_t>(tokens[4].int_value), -16);
+    EXPECT_EQ(static_cast<int64_t>(tokens[5].int_value), -1);
+    EXPECT_EQ(tokens[6].type, TOKEN_END);
+}
+
+// Test 10: Words that only start like numbers are not numbers
+TEST(TokenizerTests, TokenizeNotNumbers) {
+    code_generator_initialize();
+    std::string input = "2X - $ %102 0x 1.2.3 99999999999999999999";
+    auto tokens = tokenizeInput(input);
+    ASSERT_EQ(tokens.size(), 8);
+    for (size_t i = 0; i < 7; i++) {
+        EXPECT_NE(tokens[i].type, TOKEN_NUMBER) << tokens[i].value;
+        EXPECT_NE(tokens[i].type, TOKEN_FLOAT) << tokens[i].value;
+    }
+    EXPECT_EQ(tokens[7].type, TOKEN_END);
+}
+
+// Test 11: Numbers follow BASE, floats are only recognized in decimal
+TEST(TokenizerTests, TokenizeNumbersInBase) {
+    code_generator_initialize();
+    auto base = static_cast<int64_t *>(ForthDictionary::instance().findWord("BASE")->data);
+    std::string input = "FF 1E3 #10";
+    *base = 16;
+    auto tokens = tokenizeInput(input);
+    *base = 10;
+    ASSERT_EQ(tokens.size(), 4);
+    EXPECT_EQ(tokens[0].type, TOKEN_NUMBER);
+    EXPECT_EQ(tokens[0].int_value, 255);
+    EXPECT_EQ(tokens[1].type, TOKEN_NUMBER);
+    EXPECT_EQ(tokens[1].int_value, 0x1E3);
+    EXPECT_EQ(tokens[2].type, TOKEN_NUMBER);
+    EXPECT_EQ(tokens[2].int_value, 10);
+}
+
+// Test 12: Tokens still to run are classified again when BASE changes part way through a line
+TEST(TokenizerTests, RebaseAfterBaseChange) {
+    code_generator_initialize();
+    auto base = static_cast<int64_t *>(ForthDictionary::instance().findWord("BASE")->data);
+    std::string input = "FF 1E3 12";
+    auto tokens = tokenizeInput(input);
+    int tokensBase = Tokenizer::instance().token_base();
+    EXPECT_EQ(tokensBase, 10);
+    EXPECT_EQ(tokens[0].type, TOKEN_UNKNOWN);
+    EXPECT_EQ(tokens[1].type, TOKEN_FLOAT);
+    EXPECT_EQ(tokens[2].int_value, 12);
+
+    *base = 16;
+    Tokenizer::instance().rebase(tokens, tokensBase);
+    EXPECT_EQ(tokens[0].type, TOKEN_NUMBER);
+    EXPECT_EQ(tokens[0].int_value, 255);
+    EXPECT_EQ(tokens[1].type, TOKEN_NUMBER);
+    EXPECT_EQ(tokens[1].int_value, 0x1E3);
+    EXPECT_EQ(tokens[2].int_value, 0x12);
+    EXPECT_EQ(tokensBase, 16);
+
+    *base = 10;
+    Tokenizer::instance().rebase(tokens, tokensBase);
+    EXPECT_EQ(tokens[0].type, TOKEN_UNKNOWN);
+    EXPECT_EQ(tokens[1].type, TOKEN_FLOAT);
+    EXPECT_DOUBLE_EQ(tokens[1].float_value, 1000.0);
+    EXPECT_EQ(tokens[2].int_value, 12);
+}
+
 
 // Test constant folding optimization
 TEST(OptimizerTest, ConstantFolding_Addition) {
@@ -144,6 +221,53 @@ TEST(OptimizerTest, ConstantFolding_Addition) {
     EXPECT_EQ(optimized_tokens[0].int_value, 10);
 }
 
+// Runs of literals and pure words are evaluated at compile time
+TEST(OptimizerTest, ConstantFolding_Sequence) {
+    code_generator_initialize();
+    std::deque<ForthToken> tokens = {
+        ForthToken(TOKEN_NUMBER, 3),
+        ForthToken(TOKEN_NUMBER, 4),
+        ForthToken(TOKEN_WORD, "+", 0),
+        ForthToken(TOKEN_NUMBER, 2),
+        ForthToken(TOKEN_WORD, "*", 0),
+        ForthToken(TOKEN_WORD, "DUP", 0),
+        ForthToken(TOKEN_WORD, "NEGATE", 0)
+    };
+    std::deque<ForthToken> optimized_tokens;
+
+    Optimizer::instance().optimize(tokens, optimized_tokens);
+    Tokenizer::instance().print_token_list(optimized_tokens);
+    ASSERT_EQ(optimized_tokens.size(), 3);
+    EXPECT_EQ(optimized_tokens[0].type, TOKEN_NUMBER);
+    EXPECT_EQ(static_cast<int64_t>(optimized_tokens[0].int_value), 14);
+    EXPECT_EQ(optimized_tokens[1].type, TOKEN_NUMBER);
+    EXPECT_EQ(static_cast<int64_t>(optimized_tokens[1].int_value), -14);
+}
+
+// Folding wraps like the generated code and leaves traps to run time
+TEST(OptimizerTest, ConstantFolding_Overflow) {
+    code_generator_initialize();
+    std::deque<ForthToken> tokens = {
+        ForthToken(TOKEN_NUMBER, INT32_MAX),
+        ForthToken(TOKEN_NUMBER, 65536),
+        ForthToken(TOKEN_WORD, "*", 0),
+        ForthToken(TOKEN_NUMBER, 65536),
+        ForthToken(TOKEN_WORD, "*", 0),
+        ForthToken(TOKEN_NUMBER, 4),
+        ForthToken(TOKEN_WORD, "*", 0),
+        ForthToken(TOKEN_NUMBER, 4),
+        ForthToken(TOKEN_NUMBER, 0),
+        ForthToken(TOKEN_WORD, "MOD", 0)
+    };
+    std::deque<ForthToken> optimized_tokens;
+
+    Optimizer::instance().optimize(tokens, optimized_tokens);
+    Tokenizer::instance().print_token_list(optimized_tokens);
+    ASSERT_EQ(optimized_tokens.size(), 5);
+    EXPECT_EQ(optimized_tokens[0].int_value, static_cast<uint64_t>(INT32_MAX) << 34);
+    EXPECT_EQ(optimized_tokens[3].value, "MOD");
+}
+
 // Test strength reduction for multiplication by power of 2
 TEST(OptimizerTest, StrengthReduction_Multiplication) {
     code_generator_initialize();
@@ -335,3 +459,29 @@ TEST(OptimizerTest, NoOptimizationNeeded) {
     EXPECT_EQ(optimized_tokens[0].type, TOKEN_WORD);
     EXPECT_EQ(optimized_tokens[1].type, TOKEN_WORD);
 }
+
+// Rules added at run time, rewritten to a fixed point
+TEST(OptimizerTest, PeepholeOptimization_UserRule) {
+    code_generator_initialize();
+    ASSERT_TRUE(Peephole::instance().add_rule("OVER OVER => 2DUP"));
+    EXPECT_FALSE(Peephole::instance().add_rule("OVER OVER 2DUP"));
+    EXPECT_FALSE(Peephole::instance().add_rule("#n + => 2DUP"));
+
+    std::deque<ForthToken> tokens = {
+        ForthToken(TOKEN_WORD, "SWAP", 0),
+        ForthToken(TOKEN_WORD, "OVER", 0),
+        ForthToken(TOKEN_WORD, "OVER", 0),
+        ForthToken(TOKEN_WORD, "OVER", 0),
+        ForthToken(TOKEN_WORD, "DROP", 0)
+    };
+    std::deque<ForthToken> optimized_tokens;
+
+    Optimizer::instance().optimize(tokens, optimized_tokens);
+    Tokenizer::instance().print_token_list(optimized_tokens);
+    // SWAP OVER is TUCK, OVER OVER is 2DUP, OVER DROP does nothing
+    ASSERT_EQ(optimized_tokens.size(), 3);
+    EXPECT_EQ(optimized_tokens[0].type, TOKEN_WORD);
+    EXPECT_EQ(optimized_tokens[0].value, "TUCK");
+    EXPECT_EQ(optimized_tokens[1].type, TOKEN_WORD);
+    EXPECT_EQ(optimized_tokens[1].value, "2DUP");
+}